@@ -1,35 +1,91 @@
 #include "stdio.h"
 #include "stdlib.h"
-#include "time.h"
+
+#include "hpc_alloc.h"
+#include "bench_harness.h"
+
+// Compile: gcc -O2 -I../common -o ex1 ex1.c ../common/hpc_alloc.c
+//              ../common/bench_harness.c ../common/perf_counters.c -lm
+// Usage:   ./ex1 [--alloc=malloc|aligned|thp|hugetlb] [--interleave]
+//              [--reps=MIN:MAX] [--json=FILE] [--csv=FILE] ... (see bench_harness.h)
+//
+// One harness case per stride; the CSV below the table uses the medians
+// and the DTLB misses of the first timed repetition.
 
 #define MAX_STRIDE 40
 
-int main()
+typedef struct {
+    double *a;
+    int N, stride;
+    double sum;
+} stride_ctx_t;
+
+static void run_stride(void *p)
+{
+    stride_ctx_t *c = p;
+    double sum = 0.0;
+
+    for (int i = 0; i < c->N * c->stride; i += c->stride)
+        sum += c->a[i];
+    c->sum = sum;
+}
+
+int main(int argc, char **argv)
 {
+    if (hpc_alloc_parse_args(&argc, argv) != 0)
+        return 1;
+    if (bench_init("tp1_ex1", &argc, argv) != 0)
+        return 1;
+
     int N = 1000000;
     double *a;
-    a = malloc(N * MAX_STRIDE * sizeof(double));
-    double sum, rate, msec, start, end;
+    a = hpc_malloc((size_t)N * MAX_STRIDE * sizeof(double));
+    double rate, msec;
+    static char names[MAX_STRIDE][16];
+    stride_ctx_t ctx[MAX_STRIDE];
+
+    if (a == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
 
     for (int i = 0; i < N * MAX_STRIDE; i++)
         a[i] = 1.;
 
-    printf("stride , sum, time (msec), rate (MB/s)\n");
-
     for (int i_stride = 1; i_stride <= MAX_STRIDE; i_stride++)
     {
-        sum = 0.0;
-        start = (double)clock() / CLOCKS_PER_SEC;
+        stride_ctx_t *c = &ctx[i_stride - 1];
+        c->a = a;
+        c->N = N;
+        c->stride = i_stride;
+        snprintf(names[i_stride - 1], sizeof(names[0]), "stride %d", i_stride);
+
+        bench_case_t bc = {names[i_stride - 1], NULL, run_stride, c, 0,
+                           (double)N, (double)N * sizeof(double)};
+        bench_add(&bc);
+    }
 
-        for (int i = 0; i < N * i_stride; i += i_stride)
-            sum += a[i];
+    printf("# alloc: %s\n", hpc_alloc_describe());
+    bench_run();
+
+    printf("stride , sum, time (msec), rate (MB/s), dtlb misses\n");
+
+    for (int i_stride = 1; i_stride <= MAX_STRIDE; i_stride++)
+    {
+        const bench_result_t *r = bench_result(names[i_stride - 1]);
+        if (!r)
+            continue;
 
-        end = (double)clock() / CLOCKS_PER_SEC;
-        msec = (end - start) * 1000.0;
+        msec = r->median * 1000.0;
         rate = sizeof(double) * N * (1000.0 / msec) / (1024 * 1024);
+        double dtlb = perf_dtlb_misses(&r->perf);
 
-        printf("%d, %f, %f, %f\n", i_stride, sum, msec, rate);
+        if (dtlb >= 0)
+            printf("%d, %f, %f, %f, %.0f\n", i_stride, ctx[i_stride - 1].sum, msec, rate, dtlb);
+        else
+            printf("%d, %f, %f, %f, n/a\n", i_stride, ctx[i_stride - 1].sum, msec, rate);
     }
 
-    free(a);
+    hpc_free(a);
 }
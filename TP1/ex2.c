@@ -2,8 +2,17 @@
 #include <stdlib.h>
 #include <time.h>
 
+#include "bench_harness.h"
+
+// Compile: gcc -O2 -I../common -o ex2 ex2.c ../common/bench_harness.c ../common/perf_counters.c -lm
+// Usage:   ./ex2 [--reps=MIN:MAX] [--json=FILE] [--csv=FILE] ... (see bench_harness.h)
+
 #define N 1024  // Matrix size (try 1024 or 2048)
 
+typedef struct {
+    double *A, *B, *C;
+} mm_ctx_t;
+
 // Helper: Fill matrix with random values
 void initialize_matrix(double *mat, int n) {
     for (int i = 0; i < n * n; i++) {
@@ -18,30 +27,15 @@ void clear_matrix(double *mat, int n) {
     }
 }
 
-int main() {
-    // 1. Setup Memory
-    double *A = (double *)malloc(N * N * sizeof(double));
-    double *B = (double *)malloc(N * N * sizeof(double));
-    double *C = (double *)malloc(N * N * sizeof(double));
-
-    initialize_matrix(A, N);
-    initialize_matrix(B, N);
-
-    clock_t start, end;
-    double t_direct, t_var, t_opt;
-    double total_bytes = 3.0 * N * N * sizeof(double); // For bandwidth calculation
-
-    printf("Matrix Size: %d x %d\n", N, N);
-    printf("--------------------------------------------------------------\n");
-    printf("| Version             | Time (sec) | Bandwidth (MB/s) |\n");
-    printf("--------------------------------------------------------------\n");
+// Untimed setup before every repetition
+static void reset_c(void *p) {
+    clear_matrix(((mm_ctx_t *)p)->C, N);
+}
 
-    // =========================================================
-    // 1. Standard: Direct Write (i-j-k)
-    // =========================================================
-    clear_matrix(C, N);
-    start = clock();
-    
+// =========================================================
+// 1. Standard: Direct Write (i-j-k)
+// =========================================================
+static void direct_write(const double *restrict A, const double *restrict B, double *restrict C) {
     for (int i = 0; i < N; i++) {
         for (int j = 0; j < N; j++) {
             // BAD: We are writing to RAM (C[i*N+j]) in every single step
@@ -50,72 +44,98 @@ int main() {
             }
         }
     }
-    
-    end = clock();
-    t_direct = ((double)(end - start)) / CLOCKS_PER_SEC;
-    double bw_direct = (total_bytes / t_direct) / (1024 * 1024);
-    printf("| 1. Direct Write     | %-10.4f | %-16.2f |\n", t_direct, bw_direct);
-
-
-    // =========================================================
-    // 2. A Little Optimized: Variable Replacement (i-j-k)
-    // =========================================================
-    clear_matrix(C, N);
-    start = clock();
+}
 
+// =========================================================
+// 2. A Little Optimized: Variable Replacement (i-j-k)
+// =========================================================
+static void variable_sum(const double *restrict A, const double *restrict B, double *restrict C) {
     for (int i = 0; i < N; i++) {
         for (int j = 0; j < N; j++) {
             double sum = 0.0; // GOOD: Use a CPU register for math
-            
+
             for (int k = 0; k < N; k++) {
                 sum += A[i * N + k] * B[k * N + j];
             }
-            
+
             C[i * N + j] = sum; // Write to RAM only ONCE per pixel
         }
     }
+}
 
-    end = clock();
-    t_var = ((double)(end - start)) / CLOCKS_PER_SEC;
-    double bw_var = (total_bytes / t_var) / (1024 * 1024);
-    printf("| 2. Variable Sum     | %-10.4f | %-16.2f |\n", t_var, bw_var);
-
-
-    // =========================================================
-    // 3. Fully Optimized: Loop Reordering (i-k-j)
-    // =========================================================
-    clear_matrix(C, N);
-    start = clock();
-
+// =========================================================
+// 3. Fully Optimized: Loop Reordering (i-k-j)
+// =========================================================
+static void loop_reorder(const double *restrict A, const double *restrict B, double *restrict C) {
     for (int i = 0; i < N; i++) {
         for (int k = 0; k < N; k++) {
             double r = A[i * N + k]; // Pre-load A
-            
+
             for (int j = 0; j < N; j++) {
                 // BEST: Accessing C and B sequentially (Stride-1)
                 C[i * N + j] += r * B[k * N + j];
             }
         }
     }
+}
+
+// Harness entry points: unpack the context, the kernels keep restrict
+// pointers so they vectorise as they did when inlined in main()
+static void run_direct(void *p) { mm_ctx_t *m = p; direct_write(m->A, m->B, m->C); }
+static void run_var(void *p)    { mm_ctx_t *m = p; variable_sum(m->A, m->B, m->C); }
+static void run_opt(void *p)    { mm_ctx_t *m = p; loop_reorder(m->A, m->B, m->C); }
 
-    end = clock();
-    t_opt = ((double)(end - start)) / CLOCKS_PER_SEC;
-    double bw_opt = (total_bytes / t_opt) / (1024 * 1024);
-    printf("| 3. Loop Reorder     | %-10.4f | %-16.2f |\n", t_opt, bw_opt);
-    
-    printf("--------------------------------------------------------------\n");
+int main(int argc, char **argv) {
+    // Each version takes seconds at N=1024: no warm-up, 3 to 10 repetitions
+    bench_defaults(0, 3, 10, 20.0);
+    if (bench_init("tp1_ex2", &argc, argv) != 0)
+        return 1;
+
+    // 1. Setup Memory
+    mm_ctx_t m;
+    m.A = (double *)malloc(N * N * sizeof(double));
+    m.B = (double *)malloc(N * N * sizeof(double));
+    m.C = (double *)malloc(N * N * sizeof(double));
+    if (!m.A || !m.B || !m.C) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
+
+    initialize_matrix(m.A, N);
+    initialize_matrix(m.B, N);
+
+    double flops = 2.0 * N * N * N;
+    double total_bytes = 3.0 * N * N * sizeof(double); // For bandwidth calculation
+
+    bench_case_t cases[] = {
+        {"1. Direct Write", reset_c, run_direct,   &m, 0, flops, total_bytes},
+        {"2. Variable Sum", reset_c, run_var,      &m, 0, flops, total_bytes},
+        {"3. Loop Reorder", reset_c, run_opt,      &m, 0, flops, total_bytes},
+    };
+    for (int c = 0; c < 3; c++) bench_add(&cases[c]);
+
+    printf("Matrix Size: %d x %d\n", N, N);
+    bench_run();
+    printf("(GB/s assumes 3*N*N doubles moved; FLOP/byte uses counted FP ops\n"
+           " and 64 bytes per LLC miss.)\n");
 
     // =========================================================
-    // 4. Speedup Analysis
+    // 4. Speedup Analysis (on the medians)
     // =========================================================
     // Speedup = Time_Old / Time_New
-    double speedup_vs_direct = t_direct / t_opt;
-    double speedup_vs_var    = t_var / t_opt;
+    const bench_result_t *r_direct = bench_result("1. Direct Write");
+    const bench_result_t *r_var = bench_result("2. Variable Sum");
+    const bench_result_t *r_opt = bench_result("3. Loop Reorder");
 
-    printf("\n--- Speedup Analysis ---\n");
-    printf("Speedup vs Direct Write:  %.2f x faster\n", speedup_vs_direct);
-    printf("Speedup vs Variable Sum:  %.2f x faster\n", speedup_vs_var);
+    if (r_direct && r_var && r_opt) {
+        double speedup_vs_direct = r_direct->median / r_opt->median;
+        double speedup_vs_var    = r_var->median / r_opt->median;
+
+        printf("\n--- Speedup Analysis ---\n");
+        printf("Speedup vs Direct Write:  %.2f x faster\n", speedup_vs_direct);
+        printf("Speedup vs Variable Sum:  %.2f x faster\n", speedup_vs_var);
+    }
 
-    free(A); free(B); free(C);
+    free(m.A); free(m.B); free(m.C);
     return 0;
 }
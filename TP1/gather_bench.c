@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gather.h"
+#include "hpc_alloc.h"
+#include "bench_harness.h"
+
+// Compile: gcc -O2 -I../common -o gather_bench gather_bench.c ../common/gather.c
+//              ../common/simd_reduce.c ../common/hpc_alloc.c
+//              ../common/bench_harness.c ../common/perf_counters.c -lm
+// Usage:   ./gather_bench [--pf=DIST] [--alloc=malloc|aligned|thp|hugetlb] [--interleave]
+//              [--reps=MIN:MAX] [--json=FILE] [--csv=FILE] ... (see bench_harness.h)
+//
+// The stride sweep of ex1.c (sum of N elements, stride 1 .. MAX_STRIDE),
+// once per gather strategy (see ../common/gather.h):
+//
+//   plain      gather_sum_strided(..., GATHER_PLAIN): the ex1.c loads
+//   prefetch   gather_sum_strided(..., GATHER_PREFETCH)
+//   simd       gather_sum_strided(..., GATHER_SIMD)
+//   transpose  all `stride` columns extracted with gather_transpose(),
+//              time divided by stride: the cost of one column when the
+//              program needs every one of them
+//
+// The three sums share the same buffered 4-accumulator reduction, so
+// only the memory access pattern differs between them (the ex1.c loop
+// itself is one serial FP add chain, see ex1.c for that baseline).
+// Rates are useful MB/s (8 bytes per element) as in ex1.c.  Past a
+// stride of 8 every element costs a full cache line, so plain and
+// prefetch flatten out; what prefetch buys is the latency part.
+//
+// Every (stride, strategy) pair is one harness case, "s12 prefetch" etc.;
+// the CSV below the table uses the medians.
+
+#define MAX_STRIDE 40
+
+enum { PLAIN, PREFETCH, SIMD, TRANSPOSE, NSTRAT };
+static const char *strat_names[NSTRAT] = {"plain", "prefetch", "simd", "transpose"};
+
+typedef struct {
+    const double *a;
+    double *cols;
+    int N, stride, strat;
+    double sum;
+    char name[24];
+} gather_ctx_t;
+
+static void run_gather(void *p)
+{
+    gather_ctx_t *c = p;
+
+    switch (c->strat) {
+    case PLAIN:     c->sum = gather_sum_strided(c->a, c->N, c->stride, GATHER_PLAIN); break;
+    case PREFETCH:  c->sum = gather_sum_strided(c->a, c->N, c->stride, GATHER_PREFETCH); break;
+    case SIMD:      c->sum = gather_sum_strided(c->a, c->N, c->stride, GATHER_SIMD); break;
+    default:        gather_transpose(c->cols, c->a, c->N, c->stride, c->stride); break;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (hpc_alloc_parse_args(&argc, argv) != 0)
+        return 1;
+    bench_defaults(1, 3, 10, 1.0);
+    if (bench_init("tp1_gather", &argc, argv) != 0)
+        return 1;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--pf=", 5) == 0)
+            gather_set_prefetch(atoi(argv[i] + 5));
+        else {
+            fprintf(stderr, "Usage: %s [--pf=DIST] [--alloc=...] [--interleave] [harness options]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    int N = 1000000;
+    double *a = hpc_malloc((size_t)N * MAX_STRIDE * sizeof(double));
+    double *cols = hpc_malloc((size_t)N * MAX_STRIDE * sizeof(double));
+    if (a == NULL || cols == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
+    for (long i = 0; i < (long)N * MAX_STRIDE; i++) {
+        a[i] = 1.;
+        cols[i] = 0.;
+    }
+
+    static gather_ctx_t ctx[MAX_STRIDE][NSTRAT];
+    for (int stride = 1; stride <= MAX_STRIDE; stride++) {
+        for (int k = 0; k < NSTRAT; k++) {
+            gather_ctx_t *c = &ctx[stride - 1][k];
+            c->a = a;
+            c->cols = cols;
+            c->N = N;
+            c->stride = stride;
+            c->strat = k;
+            c->sum = N;
+            snprintf(c->name, sizeof(c->name), "s%d %s", stride, strat_names[k]);
+
+            // Transpose moves all `stride` columns: bytes of the whole block
+            double bytes = sizeof(double) * (double)N * (k == TRANSPOSE ? stride : 1);
+            bench_case_t bc = {c->name, NULL, run_gather, c, 0, 0, bytes};
+            bench_add(&bc);
+        }
+    }
+
+    printf("# alloc: %s, prefetch distance: %d elements\n", hpc_alloc_describe(), gather_prefetch());
+    bench_run();
+    printf("stride, plain (MB/s), prefetch (MB/s), simd (MB/s), transpose (MB/s per column), best/plain\n");
+
+    double bad = 0.0;
+    for (int stride = 1; stride <= MAX_STRIDE; stride++) {
+        double rate[NSTRAT], best = 0.0;
+        int complete = 1;
+
+        for (int k = 0; k < NSTRAT; k++) {
+            const bench_result_t *r = bench_result(ctx[stride - 1][k].name);
+            if (!r) {
+                complete = 0;
+                continue;
+            }
+            double ms = r->median * 1e3;
+            if (k == TRANSPOSE) ms /= stride;
+            rate[k] = sizeof(double) * N * (1000.0 / ms) / (1024 * 1024);
+            if (k > 0 && rate[k] > best) best = rate[k];
+            if (k < TRANSPOSE && ctx[stride - 1][k].sum != N) bad = ctx[stride - 1][k].sum;
+        }
+        if (!complete)
+            continue;
+        if (cols[(size_t)(stride - 1) * N + N - 1] != 1.) bad = -1.0;
+
+        printf("%d, %f, %f, %f, %f, %.2f\n", stride, rate[0], rate[1], rate[2], rate[3], best / rate[0]);
+    }
+    if (bad != 0.0)
+        fprintf(stderr, "Wrong result (%f)\n", bad);
+
+    hpc_free(cols);
+    hpc_free(a);
+    return bad != 0.0;
+}
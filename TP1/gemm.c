@@ -0,0 +1,541 @@
+/* ================================================================
+ * TP1 - Packed, register-blocked GEMM engine (see gemm.h)
+ * ================================================================
+ *
+ * COMPILATION (together with a driver such as mxm_bloc.c):
+ *   gcc -O3 -fopenmp -o mxm_bloc mxm_bloc.c gemm.c
+ *
+ * Without -fopenmp, gemm_parallel() simply runs on one thread.
+ *
+ * The micro-kernel is picked at runtime, like the common/simd_reduce
+ * kernels (see simd_reduce.h for why no -mavx2 / -mavx512f flag is
+ * needed); GEMM_ISA plays the role of REDUCE_ISA.
+ * ================================================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <immintrin.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "gemm.h"
+
+/* Packed buffers are aligned on a cache line */
+#define GEMM_ALIGN 64
+
+/* Largest register tile of any kernel (used for edge scratch tiles) */
+#define GEMM_MR_MAX 8
+#define GEMM_NR_MAX 24
+
+typedef void (*gemm_kernel_fn)(int kc, const double *a, const double *b,
+                               double *c, int ldc);
+
+/* ----------------------------------------------------------------
+ * Micro-kernels
+ * ----------------------------------------------------------------
+ * All kernels compute  C[MR x NR] += Ap * Bp  where
+ *   Ap : kc columns of MR contiguous values  (packed A micro-panel)
+ *   Bp : kc rows    of NR contiguous values  (packed B micro-panel)
+ * ---------------------------------------------------------------- */
+
+static void kernel_scalar_4x4(int kc, const double *a, const double *b,
+                              double *c, int ldc)
+{
+    double acc[4][4] = {{0.0}};
+
+    for (int p = 0; p < kc; p++) {
+        for (int i = 0; i < 4; i++) {
+            double ai = a[i];
+            for (int j = 0; j < 4; j++)
+                acc[i][j] += ai * b[j];
+        }
+        a += 4;
+        b += 4;
+    }
+
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            c[i * ldc + j] += acc[i][j];
+}
+
+__attribute__((target("avx2,fma")))
+static void kernel_avx2_6x8(int kc, const double *a, const double *b,
+                            double *c, int ldc)
+{
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+    __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+
+    for (int p = 0; p < kc; p++) {
+        __m256d b0 = _mm256_loadu_pd(b);
+        __m256d b1 = _mm256_loadu_pd(b + 4);
+        __m256d ai;
+
+        ai = _mm256_broadcast_sd(a + 0);
+        c00 = _mm256_fmadd_pd(ai, b0, c00); c01 = _mm256_fmadd_pd(ai, b1, c01);
+        ai = _mm256_broadcast_sd(a + 1);
+        c10 = _mm256_fmadd_pd(ai, b0, c10); c11 = _mm256_fmadd_pd(ai, b1, c11);
+        ai = _mm256_broadcast_sd(a + 2);
+        c20 = _mm256_fmadd_pd(ai, b0, c20); c21 = _mm256_fmadd_pd(ai, b1, c21);
+        ai = _mm256_broadcast_sd(a + 3);
+        c30 = _mm256_fmadd_pd(ai, b0, c30); c31 = _mm256_fmadd_pd(ai, b1, c31);
+        ai = _mm256_broadcast_sd(a + 4);
+        c40 = _mm256_fmadd_pd(ai, b0, c40); c41 = _mm256_fmadd_pd(ai, b1, c41);
+        ai = _mm256_broadcast_sd(a + 5);
+        c50 = _mm256_fmadd_pd(ai, b0, c50); c51 = _mm256_fmadd_pd(ai, b1, c51);
+
+        a += 6;
+        b += 8;
+    }
+
+#define STORE_ROW(r, lo, hi)                                                   \
+    _mm256_storeu_pd(c + (r) * ldc,     _mm256_add_pd(_mm256_loadu_pd(c + (r) * ldc),     lo)); \
+    _mm256_storeu_pd(c + (r) * ldc + 4, _mm256_add_pd(_mm256_loadu_pd(c + (r) * ldc + 4), hi));
+    STORE_ROW(0, c00, c01)
+    STORE_ROW(1, c10, c11)
+    STORE_ROW(2, c20, c21)
+    STORE_ROW(3, c30, c31)
+    STORE_ROW(4, c40, c41)
+    STORE_ROW(5, c50, c51)
+#undef STORE_ROW
+}
+
+__attribute__((target("avx512f")))
+static void kernel_avx512_8x24(int kc, const double *a, const double *b,
+                               double *c, int ldc)
+{
+    __m512d acc[8][3];
+
+#pragma GCC unroll 8
+    for (int i = 0; i < 8; i++) {
+        acc[i][0] = _mm512_setzero_pd();
+        acc[i][1] = _mm512_setzero_pd();
+        acc[i][2] = _mm512_setzero_pd();
+    }
+
+    for (int p = 0; p < kc; p++) {
+        __m512d b0 = _mm512_loadu_pd(b);
+        __m512d b1 = _mm512_loadu_pd(b + 8);
+        __m512d b2 = _mm512_loadu_pd(b + 16);
+
+#pragma GCC unroll 8
+        for (int i = 0; i < 8; i++) {
+            __m512d ai = _mm512_set1_pd(a[i]);
+            acc[i][0] = _mm512_fmadd_pd(ai, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_pd(ai, b1, acc[i][1]);
+            acc[i][2] = _mm512_fmadd_pd(ai, b2, acc[i][2]);
+        }
+        a += 8;
+        b += 24;
+    }
+
+#pragma GCC unroll 8
+    for (int i = 0; i < 8; i++) {
+        double *ci = c + i * ldc;
+        _mm512_storeu_pd(ci,      _mm512_add_pd(_mm512_loadu_pd(ci),      acc[i][0]));
+        _mm512_storeu_pd(ci + 8,  _mm512_add_pd(_mm512_loadu_pd(ci + 8),  acc[i][1]));
+        _mm512_storeu_pd(ci + 16, _mm512_add_pd(_mm512_loadu_pd(ci + 16), acc[i][2]));
+    }
+}
+
+/* ----------------------------------------------------------------
+ * ISA detection and parameters
+ * ---------------------------------------------------------------- */
+
+static int isa_detected = -1;   /* detected once */
+
+gemm_isa_t gemm_detect_isa(void)
+{
+    if (isa_detected >= 0) return (gemm_isa_t)isa_detected;
+
+    gemm_isa_t best = GEMM_ISA_SCALAR;
+
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        best = GEMM_ISA_AVX2;
+    if (__builtin_cpu_supports("avx512f"))
+        best = GEMM_ISA_AVX512;
+
+    const char *env = getenv("GEMM_ISA");
+    if (env) {
+        gemm_isa_t want = best;
+        if (strcmp(env, "scalar") == 0) want = GEMM_ISA_SCALAR;
+        else if (strcmp(env, "avx2") == 0) want = GEMM_ISA_AVX2;
+        else if (strcmp(env, "avx512") == 0) want = GEMM_ISA_AVX512;
+        if (want < best) best = want;
+    }
+
+    isa_detected = best;
+    return best;
+}
+
+const char *gemm_isa_name(gemm_isa_t isa)
+{
+    switch (isa) {
+    case GEMM_ISA_AVX512: return "AVX-512 8x24";
+    case GEMM_ISA_AVX2:   return "AVX2+FMA 6x8";
+    default:              return "scalar 4x4";
+    }
+}
+
+void gemm_kernel_shape(gemm_isa_t isa, int *mr, int *nr)
+{
+    switch (isa) {
+    case GEMM_ISA_AVX512: *mr = 8; *nr = 24; break;
+    case GEMM_ISA_AVX2:   *mr = 6; *nr = 8;  break;
+    default:              *mr = 4; *nr = 4;  break;
+    }
+}
+
+static const char *order_names[GEMM_ORDER_COUNT] = {
+    "JKI", "JIK", "KJI", "KIJ", "IKJ", "IJK"
+};
+
+const char *gemm_order_name(int order)
+{
+    if (order < 0 || order >= GEMM_ORDER_COUNT) return "???";
+    return order_names[order];
+}
+
+int gemm_order_parse(const char *name)
+{
+    for (int o = 0; o < GEMM_ORDER_COUNT; o++)
+        if (strcmp(name, order_names[o]) == 0) return o;
+    return -1;
+}
+
+static gemm_kernel_fn kernel_for(gemm_isa_t isa)
+{
+    switch (isa) {
+    case GEMM_ISA_AVX512: return kernel_avx512_8x24;
+    case GEMM_ISA_AVX2:   return kernel_avx2_6x8;
+    default:              return kernel_scalar_4x4;
+    }
+}
+
+int gemm_flops_per_cycle(gemm_isa_t isa)
+{
+    /* 2 FMA ports x vector width x 2 flops per FMA */
+    switch (isa) {
+    case GEMM_ISA_AVX512: return 32;
+    case GEMM_ISA_AVX2:   return 16;
+    default:              return 4;
+    }
+}
+
+static long cache_size(int name, long fallback)
+{
+    long s = sysconf(name);
+    return (s > 0) ? s : fallback;
+}
+
+static int round_down(int x, int mult)
+{
+    int r = (x / mult) * mult;
+    return (r < mult) ? mult : r;
+}
+
+void gemm_default_blocking(gemm_isa_t isa, gemm_blocking_t *blk)
+{
+    int mr, nr;
+    gemm_kernel_shape(isa, &mr, &nr);
+
+    long l1 = cache_size(_SC_LEVEL1_DCACHE_SIZE, 32L * 1024);
+    long l2 = cache_size(_SC_LEVEL2_CACHE_SIZE, 1024L * 1024);
+    long l3 = cache_size(_SC_LEVEL3_CACHE_SIZE, 8L * 1024 * 1024);
+
+    /* One KC x NR micro-panel of B takes at most half of L1 */
+    int kc = (int)(l1 / 2 / (nr * sizeof(double)));
+    if (kc > 512) kc = 512;
+    blk->kc = round_down(kc, 8);
+
+    /* The MC x KC block of A takes at most half of L2 */
+    int mc = (int)(l2 / 2 / (blk->kc * sizeof(double)));
+    if (mc > 1024) mc = 1024;
+    blk->mc = round_down(mc, mr);
+
+    /* The KC x NC panel of B takes at most half of L3 */
+    int nc = (int)(l3 / 2 / (blk->kc * sizeof(double)));
+    if (nc > 8192) nc = 8192;
+    blk->nc = round_down(nc, nr);
+
+    blk->order = GEMM_ORDER_JKI;
+}
+
+/* ----------------------------------------------------------------
+ * Packing
+ * ----------------------------------------------------------------
+ * pack_A: A[mc x kc] -> ceil(mc/MR) micro-panels, each stored
+ *         column by column (MR values per k), zero padded.
+ * pack_B: B[kc x nc] -> ceil(nc/NR) micro-panels, each stored
+ *         row by row (NR values per k), zero padded.
+ * Zero padding lets the micro-kernel always run a full tile.
+ * ---------------------------------------------------------------- */
+
+static void pack_A(int mc, int kc, const double *A, int lda, int mr, double *Ap)
+{
+    for (int i0 = 0; i0 < mc; i0 += mr) {
+        int ib = (mc - i0 < mr) ? mc - i0 : mr;
+        for (int p = 0; p < kc; p++) {
+            for (int i = 0; i < ib; i++)
+                Ap[i] = A[(i0 + i) * lda + p];
+            for (int i = ib; i < mr; i++)
+                Ap[i] = 0.0;
+            Ap += mr;
+        }
+    }
+}
+
+static void pack_B(int kc, int nc, const double *B, int ldb, int nr, double *Bp)
+{
+    for (int j0 = 0; j0 < nc; j0 += nr) {
+        int jb = (nc - j0 < nr) ? nc - j0 : nr;
+        for (int p = 0; p < kc; p++) {
+            const double *brow = B + p * ldb + j0;
+            memcpy(Bp, brow, jb * sizeof(double));
+            for (int j = jb; j < nr; j++)
+                Bp[j] = 0.0;
+            Bp += nr;
+        }
+    }
+}
+
+/* ----------------------------------------------------------------
+ * Macro-kernel: runs the micro-kernel over one packed MC x NC block
+ * ---------------------------------------------------------------- */
+static void macro_kernel(int mc, int nc, int kc,
+                         const double *Ap, const double *Bp,
+                         double *C, int ldc,
+                         gemm_kernel_fn kernel, int mr, int nr)
+{
+    double tile[GEMM_MR_MAX * GEMM_NR_MAX];
+
+    for (int jr = 0; jr < nc; jr += nr) {
+        int jb = (nc - jr < nr) ? nc - jr : nr;
+        const double *b = Bp + (size_t)jr * kc;
+
+        for (int ir = 0; ir < mc; ir += mr) {
+            int ib = (mc - ir < mr) ? mc - ir : mr;
+            const double *a = Ap + (size_t)ir * kc;
+            double *c = C + (size_t)ir * ldc + jr;
+
+            if (ib == mr && jb == nr) {
+                kernel(kc, a, b, c, ldc);
+            } else {
+                /* Edge tile: compute into scratch, copy back the valid part */
+                memset(tile, 0, sizeof(double) * mr * nr);
+                kernel(kc, a, b, tile, nr);
+                for (int i = 0; i < ib; i++)
+                    for (int j = 0; j < jb; j++)
+                        c[i * ldc + j] += tile[i * nr + j];
+            }
+        }
+    }
+}
+
+static double *alloc_panel(size_t elems)
+{
+    size_t bytes = ((sizeof(double) * elems + GEMM_ALIGN - 1) / GEMM_ALIGN) * GEMM_ALIGN;
+    double *p = (double *)aligned_alloc(GEMM_ALIGN, bytes);
+    if (!p) {
+        fprintf(stderr, "[gemm] Packing buffer allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/* ----------------------------------------------------------------
+ * Public driver
+ * ---------------------------------------------------------------- */
+void gemm(int m, int n, int k,
+          const double *A, int lda,
+          const double *B, int ldb,
+          double *C, int ldc,
+          const gemm_blocking_t *blk)
+{
+    gemm_isa_t isa = gemm_detect_isa();
+    gemm_kernel_fn kernel = kernel_for(isa);
+    gemm_blocking_t def;
+    int mr, nr;
+
+    gemm_kernel_shape(isa, &mr, &nr);
+    if (blk == NULL) {
+        gemm_default_blocking(isa, &def);
+        blk = &def;
+    }
+
+    /* Round panel sizes up to whole micro-panels */
+    int mc = ((blk->mc + mr - 1) / mr) * mr;
+    int nc = ((blk->nc + nr - 1) / nr) * nr;
+    int kc = blk->kc;
+
+    double *Ap = alloc_panel((size_t)mc * kc);
+    double *Bp = alloc_panel((size_t)kc * nc);
+
+    /* Block index, extent and step per dimension: 0 = I, 1 = K, 2 = J */
+    int ext[3]  = {m, k, n};
+    int step[3] = {mc, kc, nc};
+    int idx[3];
+    const char *ord = gemm_order_name(blk->order);
+    int d[3];
+    for (int l = 0; l < 3; l++)
+        d[l] = (ord[l] == 'I') ? 0 : (ord[l] == 'K') ? 1 : (ord[l] == 'J') ? 2 : -1;
+    if (d[0] < 0) {          /* unknown order: fall back to JKI */
+        d[0] = 2; d[1] = 1; d[2] = 0;
+    }
+
+    /* Block origin currently held in each packing buffer */
+    int a_ic = -1, a_pc = -1, b_pc = -1, b_jc = -1;
+
+    for (idx[d[0]] = 0; idx[d[0]] < ext[d[0]]; idx[d[0]] += step[d[0]]) {
+        for (idx[d[1]] = 0; idx[d[1]] < ext[d[1]]; idx[d[1]] += step[d[1]]) {
+            for (idx[d[2]] = 0; idx[d[2]] < ext[d[2]]; idx[d[2]] += step[d[2]]) {
+                int ic = idx[0], pc = idx[1], jc = idx[2];
+                int mb = (m - ic < mc) ? m - ic : mc;
+                int kb = (k - pc < kc) ? k - pc : kc;
+                int nb = (n - jc < nc) ? n - jc : nc;
+
+                if (pc != b_pc || jc != b_jc) {
+                    pack_B(kb, nb, B + (size_t)pc * ldb + jc, ldb, nr, Bp);
+                    b_pc = pc; b_jc = jc;
+                }
+                if (ic != a_ic || pc != a_pc) {
+                    pack_A(mb, kb, A + (size_t)ic * lda + pc, lda, mr, Ap);
+                    a_ic = ic; a_pc = pc;
+                }
+
+                macro_kernel(mb, nb, kb, Ap, Bp,
+                             C + (size_t)ic * ldc + jc, ldc,
+                             kernel, mr, nr);
+            }
+        }
+    }
+
+    free(Ap);
+    free(Bp);
+}
+
+/* ----------------------------------------------------------------
+ * Parallel driver
+ * ----------------------------------------------------------------
+ * The jc / pc loops run on the whole team: for every KC x NC block
+ * of B the threads pack one shared panel together (one NR-column
+ * micro-panel each), then split the MC row blocks of C between them,
+ * each packing its A block into a private buffer.  B is thus packed
+ * once per block, as in gemm(), instead of once per row block, and
+ * the panel is read by all cores from the shared L3.  Two barriers
+ * per block keep the panel stable while it is in use.
+ *
+ * Only the rows are split, so MC is shrunk until there are at least
+ * two row blocks per thread.  The static schedule hands every thread
+ * the same contiguous band of C rows for every block: the rows it
+ * touched first in a parallel schedule(static) initialisation of C.
+ * ---------------------------------------------------------------- */
+static double wall_time(void)
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return 0.0;
+#endif
+}
+
+void gemm_parallel(int m, int n, int k,
+                   const double *A, int lda,
+                   const double *B, int ldb,
+                   double *C, int ldc,
+                   const gemm_blocking_t *blk,
+                   gemm_thread_stats_t *stats)
+{
+    gemm_isa_t isa = gemm_detect_isa();
+    gemm_kernel_fn kernel = kernel_for(isa);
+    gemm_blocking_t def;
+    int mr, nr, nthreads = 1;
+
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif
+    gemm_kernel_shape(isa, &mr, &nr);
+    if (blk == NULL) {
+        gemm_default_blocking(isa, &def);
+        blk = &def;
+    }
+
+    int mc = ((blk->mc + mr - 1) / mr) * mr;
+    int nc = ((blk->nc + nr - 1) / nr) * nr;
+    int kc = blk->kc;
+
+    int want = 2 * nthreads;
+    while (mc > mr && (m + mc - 1) / mc < want)
+        mc = round_down(mc / 2, mr);
+    int tiles_m = (m + mc - 1) / mc;
+
+    if (stats)
+        memset(stats, 0, sizeof(gemm_thread_stats_t) * nthreads);
+
+    /* Shared B panel; its micro-panels are first touched by their packer */
+    double *Bp = alloc_panel((size_t)kc * nc);
+
+    #pragma omp parallel
+    {
+        int tid = 0;
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+#endif
+        /* Private A buffer, first touched by its owner */
+        double *Ap = alloc_panel((size_t)mc * kc);
+        double flops = 0.0, busy = 0.0;
+        int done = 0;
+
+        for (int jc = 0; jc < n; jc += nc) {
+            int nb = (n - jc < nc) ? n - jc : nc;
+            int panels = (nb + nr - 1) / nr;
+
+            for (int pc = 0; pc < k; pc += kc) {
+                int kb = (k - pc < kc) ? k - pc : kc;
+                double t0 = wall_time();
+
+                #pragma omp for schedule(static) nowait
+                for (int jp = 0; jp < panels; jp++) {
+                    int j0 = jp * nr;
+                    int jb = (nb - j0 < nr) ? nb - j0 : nr;
+                    pack_B(kb, jb, B + (size_t)pc * ldb + jc + j0, ldb, nr,
+                           Bp + (size_t)j0 * kb);
+                }
+                busy += wall_time() - t0;
+                #pragma omp barrier
+
+                t0 = wall_time();
+                #pragma omp for schedule(static) nowait
+                for (int t = 0; t < tiles_m; t++) {
+                    int ic = t * mc;
+                    int mb = (m - ic < mc) ? m - ic : mc;
+                    pack_A(mb, kb, A + (size_t)ic * lda + pc, lda, mr, Ap);
+                    macro_kernel(mb, nb, kb, Ap, Bp,
+                                 C + (size_t)ic * ldc + jc, ldc,
+                                 kernel, mr, nr);
+                    flops += 2.0 * mb * nb * (double)kb;
+                    if (pc == 0) done++;
+                }
+                busy += wall_time() - t0;
+
+                /* Bp is repacked next: wait until nobody reads it */
+                #pragma omp barrier
+            }
+        }
+
+        if (stats) {
+            stats[tid].flops   = flops;
+            stats[tid].seconds = busy;
+            stats[tid].tiles   = done;
+        }
+        free(Ap);
+    }
+    free(Bp);
+}
@@ -0,0 +1,107 @@
+/* ================================================================
+ * TP1 - Packed, register-blocked GEMM engine
+ * ================================================================
+ *
+ * Computes  C += A * B  for row-major double matrices, following
+ * the classic Goto/BLIS structure:
+ *
+ *   jc loop (NC columns of B)   -> B panel lives in L3
+ *    pc loop (KC depth)         -> pack B[pc:pc+KC, jc:jc+NC]
+ *     ic loop (MC rows of A)    -> pack A[ic:ic+MC, pc:pc+KC] (L2)
+ *      jr loop (NR columns)     -> one B micro-panel stays in L1
+ *       ir loop (MR rows)       -> MR x NR micro-kernel in registers
+ *
+ * The micro-kernel is chosen at runtime from the host CPU:
+ *   AVX-512F : 8 x 24 tile (24 zmm accumulators)
+ *   AVX2+FMA : 6 x 8  tile (12 ymm accumulators)
+ *   scalar   : 4 x 4  tile (portable fallback)
+ *
+ * The environment variable GEMM_ISA=scalar|avx2|avx512 forces a
+ * specific kernel (useful to compare against the roofline).
+ * ================================================================ */
+
+#ifndef GEMM_H
+#define GEMM_H
+
+typedef enum {
+    GEMM_ISA_SCALAR = 0,
+    GEMM_ISA_AVX2   = 1,
+    GEMM_ISA_AVX512 = 2
+} gemm_isa_t;
+
+/*
+ * Nesting order of the three cache-block loops, outermost first
+ * (I = ic over rows of A/C, K = pc over depth, J = jc over columns
+ * of B/C).  JKI is the Goto/BLIS order described above.  A panel
+ * is only repacked when its own two block indices change.
+ */
+typedef enum {
+    GEMM_ORDER_JKI = 0,
+    GEMM_ORDER_JIK,
+    GEMM_ORDER_KJI,
+    GEMM_ORDER_KIJ,
+    GEMM_ORDER_IKJ,
+    GEMM_ORDER_IJK,
+    GEMM_ORDER_COUNT
+} gemm_order_t;
+
+/* Cache blocking parameters (all in elements, not bytes) */
+typedef struct {
+    int mc;      /* rows of A packed per block   (L2 resident) */
+    int kc;      /* shared depth of both panels  (L1 resident) */
+    int nc;      /* columns of B packed per block (L3 resident) */
+    int order;   /* gemm_order_t, nesting of the block loops    */
+} gemm_blocking_t;
+
+/* Best ISA available on this CPU (honours GEMM_ISA if set; detected
+ * on the first call and cached) */
+gemm_isa_t gemm_detect_isa(void);
+const char *gemm_isa_name(gemm_isa_t isa);
+
+/* "JKI", "JIK", ... ; gemm_order_parse returns -1 on unknown names */
+const char *gemm_order_name(int order);
+int gemm_order_parse(const char *name);
+
+/* Register tile of the micro-kernel used for a given ISA */
+void gemm_kernel_shape(gemm_isa_t isa, int *mr, int *nr);
+
+/* Fill blk from the L1/L2/L3 sizes reported by the OS */
+void gemm_default_blocking(gemm_isa_t isa, gemm_blocking_t *blk);
+
+/* Peak double-precision FLOPs per cycle of one core for an ISA */
+int gemm_flops_per_cycle(gemm_isa_t isa);
+
+/*
+ * C[m x n] += A[m x k] * B[k x n]   (row-major, leading dimensions lda/ldb/ldc)
+ * blk may be NULL, in which case gemm_default_blocking() is used.
+ */
+void gemm(int m, int n, int k,
+          const double *A, int lda,
+          const double *B, int ldb,
+          double *C, int ldc,
+          const gemm_blocking_t *blk);
+
+/* Work done by one thread inside gemm_parallel() */
+typedef struct {
+    double flops;     /* 2*m*n*k share computed by this thread */
+    double seconds;   /* wall time spent packing and in tiles  */
+    int    tiles;     /* number of MC x NC macro-tiles handled */
+} gemm_thread_stats_t;
+
+/*
+ * OpenMP version of gemm(): the team packs each B panel once into a
+ * shared buffer, then splits the MC row blocks of C; every thread
+ * packs A into its own buffer (allocated, and therefore
+ * first-touched, by that thread).
+ * stats may be NULL, otherwise it must hold omp_get_max_threads()
+ * entries; unused entries are zeroed.
+ * The loop order is fixed (JKI), so blk->order does not apply here.
+ */
+void gemm_parallel(int m, int n, int k,
+                   const double *A, int lda,
+                   const double *B, int ldb,
+                   double *C, int ldc,
+                   const gemm_blocking_t *blk,
+                   gemm_thread_stats_t *stats);
+
+#endif /* GEMM_H */
@@ -0,0 +1,404 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <stdint.h>
+#include <omp.h>
+
+#include "gemm.h"
+#include "hpc_alloc.h"
+#include "bench_harness.h"
+
+// Build: gcc -O3 -fopenmp -I../common -o lu_bench lu_bench.c gemm.c ../common/hpc_alloc.c
+//            ../common/bench_harness.c ../common/perf_counters.c -lm
+//
+// Usage: ./lu_bench [-n N1,N2,...] [-nb NB1,NB2,...] [--alloc=...] [harness options]
+//
+// HPL-style benchmark without HPL: solves A x = b for a random dense A
+// with a blocked right-looking LU factorisation with partial pivoting,
+// then checks the HPL scaled residual
+//     ||A x - b||_inf / (eps * (||A||_inf * ||x||_inf + ||b||_inf) * N)  < 16
+// Every (N, NB) pair is one harness case, timed once by default as HPL
+// does (--reps=MIN:MAX for statistics).  After the harness table, CSV rows
+// (N,NB,Time_s,GFLOPS,Status, Time_s being the median) go to stdout, the
+// residuals of the last repetition to stderr.
+//
+// For every panel of NB columns:
+//   1. U12 = L11^-1 A12            (triangular solve, parallel over columns)
+//   2. A22 -= L21 * U12            (trailing update with the packed gemm)
+// The update is split into OpenMP tasks: one task updates the next
+// panel first and factorises it right away (look-ahead), the others
+// update the remaining column blocks, so the mostly serial panel
+// factorisation overlaps with the gemm work.  Row swaps found in a
+// panel are applied to the other columns once the update is done.
+
+#define HPL_THRESHOLD 16.0
+#define SEED 42
+
+// Column block width of one trailing-update task
+#ifndef UPDATE_COLS
+#define UPDATE_COLS 512
+#endif
+
+// ------------------------------------------------------------------
+// Random matrix: every row comes from its own generator state, so rows
+// can be produced in parallel (first touch) and regenerated for the
+// residual check without keeping a copy of A.
+// ------------------------------------------------------------------
+static uint64_t row_state(int i)
+{
+    uint64_t s = (uint64_t)SEED * 0x9E3779B97F4A7C15ull + (uint64_t)(i + 1) * 0xBF58476D1CE4E5B9ull;
+    return s ? s : 1;
+}
+
+// Uniform in [-0.5, 0.5)
+static double next_value(uint64_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return (double)(*s >> 11) * (1.0 / 9007199254740992.0) - 0.5;
+}
+
+static void generate_matrix(double *A, double *b, int n, int lda)
+{
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        uint64_t s = row_state(i);
+        for (int j = 0; j < n; j++)
+            A[(size_t)i * lda + j] = next_value(&s);
+        b[i] = next_value(&s);
+    }
+}
+
+// ------------------------------------------------------------------
+// Factorisation
+// ------------------------------------------------------------------
+
+static void swap_segment(double *A, int lda, int r1, int r2, int c0, int c1)
+{
+    if (r1 == r2 || c1 <= c0) return;
+    double *x = A + (size_t)r1 * lda, *y = A + (size_t)r2 * lda;
+    for (int c = c0; c < c1; c++) {
+        double t = x[c];
+        x[c] = y[c];
+        y[c] = t;
+    }
+}
+
+// Unblocked LU of the panel A[j:n, j:j+jb]; swaps stay inside the panel
+// columns, the pivot rows are recorded in ipiv[j:j+jb].  Returns -1 on a
+// zero pivot.
+static int factor_panel(double *A, int n, int lda, int j, int jb, int *ipiv)
+{
+    int jend = j + jb;
+
+    for (int k = j; k < jend; k++) {
+        int p = k;
+        double vmax = fabs(A[(size_t)k * lda + k]);
+        for (int i = k + 1; i < n; i++) {
+            double v = fabs(A[(size_t)i * lda + k]);
+            if (v > vmax) {
+                vmax = v;
+                p = i;
+            }
+        }
+        ipiv[k] = p;
+        if (vmax == 0.0) return -1;
+        swap_segment(A, lda, k, p, j, jend);
+
+        const double *urow = A + (size_t)k * lda;
+        double inv = 1.0 / urow[k];
+        for (int i = k + 1; i < n; i++) {
+            double *row = A + (size_t)i * lda;
+            double l = row[k] * inv;
+            row[k] = l;
+            for (int c = k + 1; c < jend; c++)
+                row[c] -= l * urow[c];
+        }
+    }
+    return 0;
+}
+
+// Apply the swaps of panel [j, j+jb) to the columns outside it
+static void apply_swaps(double *A, int n, int lda, int j, int jb, const int *ipiv)
+{
+    for (int k = j; k < j + jb; k++) {
+        swap_segment(A, lda, k, ipiv[k], 0, j);
+        swap_segment(A, lda, k, ipiv[k], j + jb, n);
+    }
+}
+
+// A12 <- L11^-1 A12 for rows [j, j+jb) and columns [c0, n)
+static void solve_u12(double *A, int n, int lda, int j, int jb, int c0)
+{
+    #pragma omp parallel for schedule(static)
+    for (int cb = c0; cb < n; cb += 256) {
+        int ce = (cb + 256 < n) ? cb + 256 : n;
+        for (int i = j + 1; i < j + jb; i++) {
+            double *row = A + (size_t)i * lda;
+            for (int k = j; k < i; k++) {
+                double l = row[k];
+                const double *urow = A + (size_t)k * lda;
+                for (int c = cb; c < ce; c++)
+                    row[c] -= l * urow[c];
+            }
+        }
+    }
+}
+
+// A = P L U in place (row-major).  Returns 0 or -1 if A is singular.
+static int lu_factor(double *A, int n, int lda, int nb, int *ipiv, const gemm_blocking_t *blk)
+{
+    double *negL = hpc_malloc((size_t)n * nb * sizeof(double));
+    int status = 0;
+
+    if (!negL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int jb = (nb < n) ? nb : n;
+    if (factor_panel(A, n, lda, 0, jb, ipiv) != 0) status = -1;
+    apply_swaps(A, n, lda, 0, jb, ipiv);
+
+    for (int j = 0; j + jb < n && status == 0; ) {
+        int j2 = j + jb;
+        int m2 = n - j2;
+        int jb2 = (nb < m2) ? nb : m2;
+
+        solve_u12(A, n, lda, j, jb, j2);
+
+        // -L21, contiguous, so the update is a plain C += A * B
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < m2; i++)
+            for (int k = 0; k < jb; k++)
+                negL[(size_t)i * jb + k] = -A[(size_t)(j2 + i) * lda + j + k];
+
+        const double *U12 = A + (size_t)j * lda;
+        double *A22 = A + (size_t)j2 * lda;
+        int panel_status = 0;
+
+        #pragma omp parallel
+        #pragma omp single
+        {
+            // Look-ahead: next panel first, then factorise it
+            #pragma omp task shared(panel_status)
+            {
+                gemm(m2, jb2, jb, negL, jb, U12 + j2, lda, A22 + j2, lda, blk);
+                panel_status = factor_panel(A, n, lda, j2, jb2, ipiv);
+            }
+            for (int c0 = j2 + jb2; c0 < n; c0 += UPDATE_COLS) {
+                int cw = (c0 + UPDATE_COLS < n) ? UPDATE_COLS : n - c0;
+                #pragma omp task firstprivate(c0, cw)
+                gemm(m2, cw, jb, negL, jb, U12 + c0, lda, A22 + c0, lda, blk);
+            }
+        }
+
+        if (panel_status != 0) status = -1;
+        apply_swaps(A, n, lda, j2, jb2, ipiv);
+        j = j2;
+        jb = jb2;
+    }
+
+    hpc_free(negL);
+    return status;
+}
+
+// Solve with the factors: x = U^-1 L^-1 P b
+static void lu_solve(const double *A, int n, int lda, const int *ipiv, double *x)
+{
+    for (int k = 0; k < n; k++) {
+        if (ipiv[k] != k) {
+            double t = x[k];
+            x[k] = x[ipiv[k]];
+            x[ipiv[k]] = t;
+        }
+    }
+    for (int i = 1; i < n; i++) {
+        const double *row = A + (size_t)i * lda;
+        double s = x[i];
+        for (int k = 0; k < i; k++) s -= row[k] * x[k];
+        x[i] = s;
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        const double *row = A + (size_t)i * lda;
+        double s = x[i];
+        for (int k = i + 1; k < n; k++) s -= row[k] * x[k];
+        x[i] = s / row[i];
+    }
+}
+
+// HPL scaled residual, regenerating A and b row by row
+static double scaled_residual(const double *x, int n)
+{
+    double r_max = 0.0, a_max = 0.0, b_max = 0.0, x_max = 0.0;
+
+    #pragma omp parallel for schedule(static) reduction(max:r_max, a_max, b_max)
+    for (int i = 0; i < n; i++) {
+        uint64_t s = row_state(i);
+        double ax = 0.0, a_row = 0.0;
+        for (int j = 0; j < n; j++) {
+            double a = next_value(&s);
+            ax += a * x[j];
+            a_row += fabs(a);
+        }
+        double b = next_value(&s);
+        r_max = fmax(r_max, fabs(ax - b));
+        a_max = fmax(a_max, a_row);
+        b_max = fmax(b_max, fabs(b));
+    }
+    for (int i = 0; i < n; i++) x_max = fmax(x_max, fabs(x[i]));
+
+    return r_max / (DBL_EPSILON * (a_max * x_max + b_max) * n);
+}
+
+// "1000,5000" -> {1000, 5000}; returns the count
+static int parse_list(const char *arg, int *out, int max)
+{
+    int count = 0;
+    char *copy = strdup(arg);
+    for (char *tok = strtok(copy, ","); tok && count < max; tok = strtok(NULL, ","))
+        if (atoi(tok) > 0) out[count++] = atoi(tok);
+    free(copy);
+    return count;
+}
+
+// ------------------------------------------------------------------
+// Harness cases
+// ------------------------------------------------------------------
+
+// Matrix and pivots, shared by the cases of one size (they run in
+// registration order, so A is reallocated once per size)
+typedef struct {
+    int n;
+    double *A;
+    int *ipiv;
+} lu_work_t;
+
+typedef struct {
+    lu_work_t *w;
+    const gemm_blocking_t *blk;
+    int n, nb, status;
+    double *x;           // b, then the solution of the last repetition
+    char name[32];
+} lu_case_t;
+
+static void ensure_size(lu_work_t *w, int n)
+{
+    if (w->n == n) return;
+    hpc_free(w->A);
+    hpc_free(w->ipiv);
+    w->A = hpc_malloc((size_t)n * n * sizeof(double));
+    w->ipiv = hpc_malloc((size_t)n * sizeof(int));
+    w->n = n;
+    if (!w->A || !w->ipiv) {
+        fprintf(stderr, "Memory allocation failed for N=%d\n", n);
+        exit(1);
+    }
+}
+
+// Untimed: fresh A and b before every repetition
+static void lu_setup(void *p)
+{
+    lu_case_t *c = p;
+    ensure_size(c->w, c->n);
+    generate_matrix(c->w->A, c->x, c->n, c->n);
+}
+
+static void lu_run(void *p)
+{
+    lu_case_t *c = p;
+    c->status = lu_factor(c->w->A, c->n, c->n, c->nb, c->w->ipiv, c->blk);
+    if (c->status == 0) lu_solve(c->w->A, c->n, c->n, c->w->ipiv, c->x);
+}
+
+int main(int argc, char *argv[])
+{
+    if (hpc_alloc_parse_args(&argc, argv) != 0)
+        return 1;
+    bench_defaults(0, 1, 1, 0.0);
+    if (bench_init("tp1_lu", &argc, argv) != 0)
+        return 1;
+
+    int sizes[32] = {1000, 2000, 4000};
+    int blocks[32] = {32, 64, 128, 256};
+    int n_sizes = 3, n_blocks = 4;
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "-n") == 0 && a + 1 < argc) {
+            n_sizes = parse_list(argv[++a], sizes, 32);
+        } else if (strcmp(argv[a], "-nb") == 0 && a + 1 < argc) {
+            n_blocks = parse_list(argv[++a], blocks, 32);
+        } else {
+            fprintf(stderr, "Usage: %s [-n N1,N2,...] [-nb NB1,NB2,...] "
+                            "[--alloc=malloc|aligned|thp|hugetlb] [--interleave] [harness options]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (n_sizes * n_blocks > BENCH_MAX_CASES) {
+        fprintf(stderr, "At most %d (N, NB) pairs\n", BENCH_MAX_CASES);
+        return 1;
+    }
+
+    gemm_blocking_t blk;
+    gemm_default_blocking(gemm_detect_isa(), &blk);
+
+    lu_work_t work = {0, NULL, NULL};
+    lu_case_t *cases = calloc((size_t)n_sizes * n_blocks, sizeof(lu_case_t));
+    if (!cases) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
+
+    for (int s = 0; s < n_sizes; s++) {
+        for (int t = 0; t < n_blocks; t++) {
+            lu_case_t *c = &cases[s * n_blocks + t];
+            int n = sizes[s];
+
+            c->w = &work;
+            c->blk = &blk;
+            c->n = n;
+            c->nb = blocks[t];
+            c->status = -1;
+            c->x = hpc_malloc((size_t)n * sizeof(double));
+            if (!c->x) {
+                fprintf(stderr, "Memory allocation failed for N=%d\n", n);
+                return 1;
+            }
+            snprintf(c->name, sizeof(c->name), "N=%d NB=%d", n, c->nb);
+
+            double flops = 2.0 / 3.0 * (double)n * n * n + 1.5 * (double)n * n;
+            bench_case_t bc = {c->name, lu_setup, lu_run, c, 0, flops, 0};
+            bench_add(&bc);
+        }
+    }
+
+    fprintf(stderr, "LU benchmark: %d thread(s), micro-kernel %s, alloc %s\n",
+            omp_get_max_threads(), gemm_isa_name(gemm_detect_isa()), hpc_alloc_describe());
+    bench_run();
+
+    printf("N,NB,Time_s,GFLOPS,Status\n");
+    for (int k = 0; k < n_sizes * n_blocks; k++) {
+        lu_case_t *c = &cases[k];
+        const bench_result_t *r = bench_result(c->name);
+        if (!r) continue;
+
+        double resid = (c->status == 0) ? scaled_residual(c->x, c->n) : INFINITY;
+        int passed = (resid < HPL_THRESHOLD);
+
+        fprintf(stderr, "N=%d NB=%d: ||Ax-b||_oo/(eps*(||A||_oo*||x||_oo+||b||_oo)*N) = %.7f ... %s\n",
+                c->n, c->nb, resid, passed ? "PASSED" : "FAILED");
+        printf("%d,%d,%.4f,%.4f,%s\n", c->n, c->nb, r->median, r->gflops,
+               passed ? "PASSED" : "FAILED");
+        fflush(stdout);
+    }
+
+    for (int k = 0; k < n_sizes * n_blocks; k++) hpc_free(cases[k].x);
+    free(cases);
+    hpc_free(work.A);
+    hpc_free(work.ipiv);
+    return 0;
+}
@@ -0,0 +1,348 @@
+/* ================================================================
+ * TP1 - Matmul block-size autotuner (see matmul_tune.h)
+ * ================================================================
+ *
+ * COMPILATION (needs gemm.c):
+ *   gcc -O3 -fopenmp -o mxm_bloc mxm_bloc.c gemm.c matmul_tune.c
+ * ================================================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "matmul_tune.h"
+
+/* A candidate whose first trial is this much slower than the best is dropped */
+#define TUNE_PRUNE_RATIO 1.25
+/* Extra trials for surviving candidates (the minimum time is kept) */
+#define TUNE_REPEATS 2
+/* Number of block shapes whose loop orders are explored */
+#define TUNE_TOP_SHAPES 3
+
+#define TUNE_MAX_CANDIDATES 1024
+#define TUNE_LINE 256
+
+typedef struct {
+    gemm_blocking_t blk;
+    double gflops;
+} tune_result_t;
+
+/* ----------------------------------------------------------------
+ * Machine key and file handling
+ * ---------------------------------------------------------------- */
+
+static long sys_cache(int name)
+{
+    long s = sysconf(name);
+    return (s > 0) ? s : 0;
+}
+
+static void machine_key(char *buf, size_t len)
+{
+    snprintf(buf, len, "%ld %ld %ld %s",
+             sys_cache(_SC_LEVEL1_DCACHE_SIZE),
+             sys_cache(_SC_LEVEL2_CACHE_SIZE),
+             sys_cache(_SC_LEVEL3_CACHE_SIZE),
+             gemm_isa_name(gemm_detect_isa()));
+}
+
+const char *matmul_tune_path(void)
+{
+    static char path[1024];
+    const char *env = getenv("MATMUL_TUNE_FILE");
+    const char *home = getenv("HOME");
+
+    if (env && env[0])
+        snprintf(path, sizeof(path), "%s", env);
+    else if (home && home[0])
+        snprintf(path, sizeof(path), "%s/.matmul_tune", home);
+    else
+        snprintf(path, sizeof(path), "matmul_tune.txt");
+    return path;
+}
+
+/*
+ * Split one data line into the machine key (first 4 fields, the ISA
+ * name may contain one space) and the tuned values.
+ * Returns 1 if the line is well formed.
+ */
+static int parse_line(const char *line, char *key, size_t key_len,
+                      gemm_blocking_t *blk, double *gflops)
+{
+    long l1, l2, l3;
+    char isa_a[32], isa_b[32], order[8];
+    int mc, kc, nc;
+    double g;
+
+    /* ISA names are "AVX-512 8x24", "AVX2+FMA 6x8", "scalar 4x4" */
+    if (sscanf(line, "%ld %ld %ld %31s %31s %d %d %d %7s %lf",
+               &l1, &l2, &l3, isa_a, isa_b, &mc, &kc, &nc, order, &g) != 10)
+        return 0;
+    if (gemm_order_parse(order) < 0 || mc <= 0 || kc <= 0 || nc <= 0)
+        return 0;
+
+    snprintf(key, key_len, "%ld %ld %ld %s %s", l1, l2, l3, isa_a, isa_b);
+    blk->mc = mc;
+    blk->kc = kc;
+    blk->nc = nc;
+    blk->order = gemm_order_parse(order);
+    *gflops = g;
+    return 1;
+}
+
+int matmul_tune_load(gemm_blocking_t *blk, double *gflops)
+{
+    FILE *f = fopen(matmul_tune_path(), "r");
+    char line[TUNE_LINE], key[TUNE_LINE], mine[TUNE_LINE];
+    int found = 0;
+
+    if (!f) return 0;
+    machine_key(mine, sizeof(mine));
+
+    while (fgets(line, sizeof(line), f)) {
+        gemm_blocking_t b;
+        double g;
+        if (line[0] == '#') continue;
+        if (parse_line(line, key, sizeof(key), &b, &g) && strcmp(key, mine) == 0) {
+            *blk = b;
+            if (gflops) *gflops = g;
+            found = 1;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+int matmul_tune_save(const gemm_blocking_t *blk, double gflops)
+{
+    const char *path = matmul_tune_path();
+    char mine[TUNE_LINE], key[TUNE_LINE], line[TUNE_LINE];
+    char tmp_path[1100];
+    FILE *in, *out;
+
+    machine_key(mine, sizeof(mine));
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    out = fopen(tmp_path, "w");
+    if (!out) {
+        fprintf(stderr, "[matmul_tune] Cannot write %s\n", tmp_path);
+        return -1;
+    }
+    fprintf(out, "# l1d l2 l3 isa mc kc nc order gflops\n");
+
+    /* Keep the entries of other machines */
+    in = fopen(path, "r");
+    if (in) {
+        while (fgets(line, sizeof(line), in)) {
+            gemm_blocking_t b;
+            double g;
+            if (line[0] == '#') continue;
+            if (parse_line(line, key, sizeof(key), &b, &g) && strcmp(key, mine) != 0)
+                fputs(line, out);
+        }
+        fclose(in);
+    }
+
+    fprintf(out, "%s %d %d %d %s %.2f\n", mine, blk->mc, blk->kc, blk->nc,
+            gemm_order_name(blk->order), gflops);
+    fclose(out);
+
+    if (rename(tmp_path, path) != 0) {
+        fprintf(stderr, "[matmul_tune] Cannot replace %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/* ----------------------------------------------------------------
+ * Search
+ * ---------------------------------------------------------------- */
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double time_once(int n, const double *A, const double *B, double *C,
+                        const gemm_blocking_t *blk)
+{
+    memset(C, 0, sizeof(double) * n * n);
+    double t0 = now();
+    gemm(n, n, n, A, n, B, n, C, n, blk);
+    return now() - t0;
+}
+
+/*
+ * Time one candidate.  The first trial is compared with the best
+ * time seen so far: if it is clearly worse the candidate is pruned
+ * (returns its single time), otherwise the minimum over
+ * 1 + TUNE_REPEATS trials is returned.
+ */
+static double time_candidate(int n, const double *A, const double *B, double *C,
+                             const gemm_blocking_t *blk, double best, int *pruned)
+{
+    double t = time_once(n, A, B, C, blk);
+
+    *pruned = (best > 0 && t > TUNE_PRUNE_RATIO * best);
+    if (*pruned) return t;
+
+    for (int r = 0; r < TUNE_REPEATS; r++) {
+        double tr = time_once(n, A, B, C, blk);
+        if (tr < t) t = tr;
+    }
+    return t;
+}
+
+static int contains(const int *v, int len, int x)
+{
+    for (int i = 0; i < len; i++)
+        if (v[i] == x) return 1;
+    return 0;
+}
+
+static int cmp_result(const void *a, const void *b)
+{
+    double ga = ((const tune_result_t *)a)->gflops;
+    double gb = ((const tune_result_t *)b)->gflops;
+    return (ga < gb) - (ga > gb);   /* descending */
+}
+
+double matmul_autotune(int n, gemm_blocking_t *best, int verbose)
+{
+    gemm_isa_t isa = gemm_detect_isa();
+    int mr, nr;
+    gemm_kernel_shape(isa, &mr, &nr);
+
+    long l1 = sys_cache(_SC_LEVEL1_DCACHE_SIZE);
+    long l2 = sys_cache(_SC_LEVEL2_CACHE_SIZE);
+    long l3 = sys_cache(_SC_LEVEL3_CACHE_SIZE);
+    if (l1 == 0) l1 = 32L * 1024;
+    if (l2 == 0) l2 = 1024L * 1024;
+    if (l3 == 0) l3 = 8L * 1024 * 1024;
+
+    /* Candidate extents per dimension (non-square shapes come from the product) */
+    static const int kc_list[] = {32, 64, 96, 128, 192, 256, 384, 512};
+    static const int mc_mult[] = {4, 8, 16, 32, 64, 128};
+    static const int nc_mult[] = {8, 32, 128, 512};
+    int mcs[16], ncs[16], n_mc = 0, n_nc = 0;
+
+    /* Extents larger than the problem behave the same: clamp and dedupe */
+    int m_full = ((n + mr - 1) / mr) * mr;
+    int n_full = ((n + nr - 1) / nr) * nr;
+    for (size_t i = 0; i < sizeof(mc_mult) / sizeof(mc_mult[0]); i++) {
+        int v = mc_mult[i] * mr;
+        if (v > m_full) v = m_full;
+        if (!contains(mcs, n_mc, v)) mcs[n_mc++] = v;
+    }
+    for (size_t i = 0; i < sizeof(nc_mult) / sizeof(nc_mult[0]); i++) {
+        int v = nc_mult[i] * nr;
+        if (v > n_full) v = n_full;
+        if (!contains(ncs, n_nc, v)) ncs[n_nc++] = v;
+    }
+
+    double *A = malloc(sizeof(double) * n * n);
+    double *B = malloc(sizeof(double) * n * n);
+    double *C = malloc(sizeof(double) * n * n);
+    tune_result_t *res = malloc(sizeof(tune_result_t) * TUNE_MAX_CANDIDATES);
+    if (!A || !B || !C || !res) {
+        fprintf(stderr, "[matmul_tune] Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < n * n; i++) {
+        A[i] = (double)(i % 97) * 0.01;
+        B[i] = (double)(i % 89) * 0.02;
+    }
+
+    double flops = 2.0 * n * (double)n * n;
+    double best_t = 0.0;
+    int n_res = 0, n_skip = 0, n_pruned = 0;
+
+    if (verbose)
+        printf("Autotuning %d x %d (%s): L1=%ldK L2=%ldK L3=%ldK\n",
+               n, n, gemm_isa_name(isa), l1 / 1024, l2 / 1024, l3 / 1024);
+
+    /* Stage 1: block shapes with the default JKI order */
+    for (size_t ik = 0; ik < sizeof(kc_list) / sizeof(kc_list[0]); ik++) {
+        int kc = kc_list[ik];
+        if (kc > n && ik > 0 && kc_list[ik - 1] >= n) continue;
+
+        for (int im = 0; im < n_mc; im++) {
+            for (int in = 0; in < n_nc; in++) {
+                gemm_blocking_t b = {mcs[im], kc, ncs[in], GEMM_ORDER_JKI};
+
+                /* Cache model: B micro-panel in L1, A block in L2, B panel in L3 */
+                if ((long)kc * nr * (long)sizeof(double) > l1 ||
+                    (long)b.mc * kc * (long)sizeof(double) > l2 ||
+                    (long)kc * b.nc * (long)sizeof(double) > l3) {
+                    n_skip++;
+                    continue;
+                }
+
+                int pruned;
+                double t = time_candidate(n, A, B, C, &b, best_t, &pruned);
+                if (pruned) {
+                    n_pruned++;
+                    continue;
+                }
+                if (best_t == 0.0 || t < best_t) best_t = t;
+                if (n_res < TUNE_MAX_CANDIDATES) {
+                    res[n_res].blk = b;
+                    res[n_res].gflops = flops / t / 1e9;
+                    n_res++;
+                }
+            }
+        }
+    }
+
+    if (n_res == 0) {
+        /* Cache model rejected everything: fall back to the defaults */
+        gemm_default_blocking(isa, best);
+        res[0].blk = *best;
+        best_t = time_once(n, A, B, C, best);
+        res[0].gflops = flops / best_t / 1e9;
+        n_res = 1;
+    }
+    qsort(res, n_res, sizeof(tune_result_t), cmp_result);
+
+    if (verbose) {
+        printf("Stage 1: %d shapes timed, %d pruned early, %d rejected by cache model\n",
+               n_res, n_pruned, n_skip);
+        for (int i = 0; i < n_res && i < TUNE_TOP_SHAPES; i++)
+            printf("  #%d MC=%-5d KC=%-4d NC=%-5d %7.2f GFLOPS\n", i + 1,
+                   res[i].blk.mc, res[i].blk.kc, res[i].blk.nc, res[i].gflops);
+    }
+
+    /* Stage 2: other loop orders on the fastest few shapes */
+    tune_result_t winner = res[0];
+    int top = (n_res < TUNE_TOP_SHAPES) ? n_res : TUNE_TOP_SHAPES;
+    for (int i = 0; i < top; i++) {
+        for (int o = 0; o < GEMM_ORDER_COUNT; o++) {
+            if (o == GEMM_ORDER_JKI) continue;
+            gemm_blocking_t b = res[i].blk;
+            b.order = o;
+
+            int pruned;
+            double t = time_candidate(n, A, B, C, &b, best_t, &pruned);
+            if (pruned) continue;
+            if (t < best_t) best_t = t;
+            double g = flops / t / 1e9;
+            if (g > winner.gflops) {
+                winner.blk = b;
+                winner.gflops = g;
+            }
+        }
+    }
+
+    if (verbose)
+        printf("Best: MC=%d KC=%d NC=%d order=%s -> %.2f GFLOPS\n",
+               winner.blk.mc, winner.blk.kc, winner.blk.nc,
+               gemm_order_name(winner.blk.order), winner.gflops);
+
+    *best = winner.blk;
+    free(A); free(B); free(C); free(res);
+    return winner.gflops;
+}
@@ -0,0 +1,49 @@
+/* ================================================================
+ * TP1 - Matmul block-size autotuner
+ * ================================================================
+ *
+ * Searches the GEMM blocking (MC x KC x NC block shape and block
+ * loop order, see gemm.h) on the current machine and keeps the
+ * winner in a small text file, one line per machine:
+ *
+ *   # l1d l2 l3 isa mc kc nc order gflops
+ *   49152 2097152 110100480 AVX-512 480 192 2016 JKI 41.27
+ *
+ * A machine is identified by its cache sizes and GEMM ISA, so one
+ * file can be shared (e.g. in $HOME) between different node types.
+ *
+ * File location, first match wins:
+ *   $MATMUL_TUNE_FILE, $HOME/.matmul_tune, ./matmul_tune.txt
+ *
+ * mxm_bloc --tune writes it; mxm_bloc, morton_bench (GEMM case) and
+ * TP3/ex4 --tiled (tile shape) start from it when it is present.
+ * ================================================================ */
+
+#ifndef MATMUL_TUNE_H
+#define MATMUL_TUNE_H
+
+#include "gemm.h"
+
+/* Path of the tuning file used by load/save */
+const char *matmul_tune_path(void);
+
+/*
+ * Load the tuned blocking for this machine.
+ * Returns 1 and fills blk (and *gflops if non-NULL) on success,
+ * 0 if the file or a matching line does not exist.
+ */
+int matmul_tune_load(gemm_blocking_t *blk, double *gflops);
+
+/* Store blk for this machine, replacing any older entry. 0 on success. */
+int matmul_tune_save(const gemm_blocking_t *blk, double gflops);
+
+/*
+ * Search the blocking for an n x n x n single-threaded gemm().
+ * Candidates that do not fit the cache model are skipped, and any
+ * candidate whose first trial is clearly slower than the best so far
+ * is dropped before its repeat trials.  Loop orders are only tried
+ * on the fastest few block shapes.  Returns the best GFLOPS.
+ */
+double matmul_autotune(int n, gemm_blocking_t *best, int verbose);
+
+#endif /* MATMUL_TUNE_H */
@@ -0,0 +1,537 @@
+/* ================================================================
+ * TP1 - Memory hierarchy probe (extends the ex1.c stride benchmark)
+ * ================================================================
+ *
+ * ex1.c reads one 320 MB array with strides 1..40 and times it with
+ * clock().  This tool measures the whole hierarchy:
+ *
+ *   stride  : 2D sweep, working-set size x stride, strided reads
+ *             (the ex1.c loop, repeated until the timing is stable)
+ *   latency : pointer chasing through a random cyclic permutation of
+ *             cache lines; one dependent load at a time, so the time
+ *             per step is the load-to-use latency of the level that
+ *             holds the working set
+ *   bw      : read / write / copy / triad kernels per working-set size,
+ *             with and without non-temporal (streaming) stores, for a
+ *             list of thread counts (aggregate bandwidth)
+ *
+ * Output is CSV on stdout, one row per measurement:
+ *   test,kernel,threads,bytes,stride,time_s,ns_per_access,gb_per_s
+ * For the latency test, gb_per_s is one cache line per dependent
+ * load.  The inferred cache capacities are appended as rows with
+ * test = "level" (bytes = detected capacity, ns = plateau latency);
+ * only jumps that match a cache size reported by the OS are kept.
+ * Progress and the human-readable summary go to stderr.
+ *
+ * COMPILATION:
+ *   gcc -O2 -fopenmp -o mem_probe mem_probe.c
+ *
+ * EXECUTION:
+ *   ./mem_probe                        (all tests, up to 512 MB)
+ *   ./mem_probe latency -max 64        (latency only, up to 64 MB)
+ *   ./mem_probe bw -t 1,2,4,8 > bw.csv
+ * ================================================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <omp.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define MAX_STRIDE 40        /* same largest stride as ex1.c            */
+#define LINE 64              /* cache line size in bytes                */
+#define MIN_BYTES (4 * 1024) /* smallest working set                    */
+#define TARGET_TIME 0.05     /* seconds of work per measurement point   */
+#define MAX_THREAD_LIST 32
+#define MAX_POINTS 64
+
+/* Keeps the compiler from discarding read-only loops */
+static volatile double sink;
+
+typedef enum { K_READ, K_WRITE, K_WRITE_NT, K_COPY, K_COPY_NT, K_TRIAD, K_TRIAD_NT, K_COUNT } kernel_t;
+
+static const char *kernel_names[K_COUNT] = {
+    "read", "write", "write_nt", "copy", "copy_nt", "triad", "triad_nt"
+};
+
+/* Bytes moved per element, as counted by STREAM (no write-allocate) */
+static const int kernel_bytes[K_COUNT] = { 8, 8, 8, 16, 16, 24, 24 };
+
+/* ----------------------------------------------------------------
+ * Helpers
+ * ---------------------------------------------------------------- */
+
+static void *alloc_lines(size_t bytes)
+{
+    size_t rounded = ((bytes + LINE - 1) / LINE) * LINE;
+    void *p = aligned_alloc(LINE, rounded);
+    if (!p) {
+        fprintf(stderr, "Memory allocation failed (%zu bytes)\n", bytes);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/* Working-set sizes: powers of two and the 1.5x points in between */
+static int build_sizes(size_t max_bytes, size_t *sizes)
+{
+    int n = 0;
+    for (size_t s = MIN_BYTES; s <= max_bytes && n < MAX_POINTS - 1; s *= 2) {
+        sizes[n++] = s;
+        if (s + s / 2 <= max_bytes) sizes[n++] = s + s / 2;
+    }
+    return n;
+}
+
+static void print_row(const char *test, const char *kernel, int threads,
+                      size_t bytes, int stride, double t, double accesses,
+                      double moved_bytes)
+{
+    printf("%s,%s,%d,%zu,%d,%.6e,%.4f,%.4f\n", test, kernel, threads, bytes,
+           stride, t, t * 1e9 / accesses, moved_bytes / t / 1e9);
+    fflush(stdout);
+}
+
+/* ----------------------------------------------------------------
+ * 1. Stride sweep (ex1.c loop, 2D over size and stride)
+ * ---------------------------------------------------------------- */
+static double strided_sum(const double *a, size_t n, int stride)
+{
+    double s0 = 0.0, s1 = 0.0;
+    size_t i = 0;
+    /* Two accumulators so the FP add latency does not hide the memory */
+    for (; i + stride < n; i += 2 * (size_t)stride) {
+        s0 += a[i];
+        s1 += a[i + stride];
+    }
+    for (; i < n; i += stride) s0 += a[i];
+    return s0 + s1;
+}
+
+static void run_stride(size_t max_bytes)
+{
+    size_t sizes[MAX_POINTS];
+    int n_sizes = build_sizes(max_bytes, sizes);
+    int strides[] = {1, 2, 4, 8, 16, 32, MAX_STRIDE};
+    int n_strides = sizeof(strides) / sizeof(strides[0]);
+
+    double *a = alloc_lines(max_bytes);
+    for (size_t i = 0; i < max_bytes / sizeof(double); i++) a[i] = 1.0;
+
+    fprintf(stderr, "[stride] %d sizes x %d strides\n", n_sizes, n_strides);
+    for (int s = 0; s < n_sizes; s++) {
+        size_t n = sizes[s] / sizeof(double);
+        for (int x = 0; x < n_strides; x++) {
+            int stride = strides[x];
+            double accesses = (double)((n + stride - 1) / stride);
+
+            /* Warm-up pass, then repeat until TARGET_TIME is reached */
+            sink = strided_sum(a, n, stride);
+            long reps = 0;
+            double t0 = omp_get_wtime(), t;
+            do {
+                sink = strided_sum(a, n, stride);
+                reps++;
+                t = omp_get_wtime() - t0;
+            } while (t < TARGET_TIME);
+
+            /* Useful bytes, as in ex1.c: 8 bytes per access */
+            print_row("stride", "read", 1, sizes[s], stride, t / reps,
+                      accesses, accesses * sizeof(double));
+        }
+    }
+    free(a);
+}
+
+/* ----------------------------------------------------------------
+ * 2. Pointer chasing latency
+ * ---------------------------------------------------------------- */
+static uint64_t xorshift(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+/*
+ * One pointer per cache line, linked in a single random cycle
+ * (Sattolo's algorithm) so the hardware prefetchers cannot guess
+ * the next address.  Returns the latency per load in ns.
+ */
+static double chase(void **lines, size_t n_lines, size_t *order)
+{
+    const size_t stride = LINE / sizeof(void *);
+    uint64_t rng = 0x9E3779B97F4A7C15ull;
+
+    for (size_t i = 0; i < n_lines; i++) order[i] = i;
+    for (size_t i = n_lines - 1; i > 0; i--) {
+        size_t j = xorshift(&rng) % i;
+        size_t tmp = order[i]; order[i] = order[j]; order[j] = tmp;
+    }
+    for (size_t i = 0; i < n_lines; i++) {
+        size_t from = order[i], to = order[(i + 1) % n_lines];
+        lines[from * stride] = &lines[to * stride];
+    }
+
+    void **p = &lines[order[0] * stride];
+    for (size_t i = 0; i < n_lines; i++) p = (void **)*p;   /* warm-up */
+
+    long steps = 0;
+    double t0 = omp_get_wtime(), t;
+    do {
+        for (int u = 0; u < 1024; u++) {
+            p = (void **)*p; p = (void **)*p; p = (void **)*p; p = (void **)*p;
+        }
+        steps += 4096;
+        t = omp_get_wtime() - t0;
+    } while (t < TARGET_TIME);
+
+    sink = (double)(uintptr_t)p;
+    return t * 1e9 / steps;
+}
+
+static int run_latency(size_t max_bytes, size_t *sizes, double *lat)
+{
+    int n_sizes = build_sizes(max_bytes, sizes);
+    void **lines = alloc_lines(max_bytes);
+    size_t *order = malloc((max_bytes / LINE) * sizeof(size_t));
+    if (!order) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(stderr, "[latency] %d sizes\n", n_sizes);
+    for (int s = 0; s < n_sizes; s++) {
+        lat[s] = chase(lines, sizes[s] / LINE, order);
+        printf("latency,chase,1,%zu,%d,%.6e,%.4f,%.4f\n", sizes[s], LINE,
+               lat[s] * 1e-9, lat[s], LINE / lat[s]);
+    }
+    fflush(stdout);
+
+    free(order);
+    free(lines);
+    return n_sizes;
+}
+
+/* ----------------------------------------------------------------
+ * 3. Bandwidth kernels
+ * ---------------------------------------------------------------- */
+static void stream_store(double *dst, size_t i, double v0, double v1)
+{
+#ifdef __SSE2__
+    _mm_stream_pd(dst + i, _mm_set_pd(v1, v0));
+#else
+    dst[i] = v0;
+    dst[i + 1] = v1;
+#endif
+}
+
+/* Runs kernel k on elements [lo, hi) of a, b, c (lo and hi even) */
+static double run_kernel(kernel_t k, double *a, double *b, double *c,
+                         size_t lo, size_t hi)
+{
+    const double s = 1.0001;
+    double r0 = 0, r1 = 0, r2 = 0, r3 = 0;
+
+    switch (k) {
+    case K_READ:
+        for (size_t i = lo; i < hi; i += 4) {
+            r0 += a[i]; r1 += a[i + 1]; r2 += a[i + 2]; r3 += a[i + 3];
+        }
+        break;
+    case K_WRITE:
+        for (size_t i = lo; i < hi; i++) a[i] = s;
+        break;
+    case K_WRITE_NT:
+        for (size_t i = lo; i < hi; i += 2) stream_store(a, i, s, s);
+        break;
+    case K_COPY:
+        for (size_t i = lo; i < hi; i++) b[i] = a[i];
+        break;
+    case K_COPY_NT:
+        for (size_t i = lo; i < hi; i += 2) stream_store(b, i, a[i], a[i + 1]);
+        break;
+    case K_TRIAD:
+        for (size_t i = lo; i < hi; i++) a[i] = b[i] + s * c[i];
+        break;
+    case K_TRIAD_NT:
+        for (size_t i = lo; i < hi; i += 2)
+            stream_store(a, i, b[i] + s * c[i], b[i + 1] + s * c[i + 1]);
+        break;
+    default:
+        break;
+    }
+#ifdef __SSE2__
+    _mm_sfence();
+#endif
+    return r0 + r1 + r2 + r3;
+}
+
+/*
+ * Each thread works on its own contiguous slice of the arrays (the
+ * same slice it first-touched), so the aggregate number is not
+ * limited by remote NUMA traffic.  bytes is the total footprint of
+ * all arrays used by the kernel.
+ */
+static double time_kernel(kernel_t k, double *a, double *b, double *c,
+                          size_t n, int threads)
+{
+    long reps = 1;
+    double t0 = 0.0, t1 = 0.0;
+
+    #pragma omp parallel num_threads(threads)
+    {
+        int tid = omp_get_thread_num();
+        size_t chunk = ((n / threads) / 4) * 4;
+        size_t lo = tid * chunk;
+        size_t hi = (tid == threads - 1) ? (n / 4) * 4 : lo + chunk;
+        double local = run_kernel(k, a, b, c, lo, hi);   /* warm-up */
+
+        /* One timed pass to size the repetition count */
+        #pragma omp barrier
+        #pragma omp single
+        t0 = omp_get_wtime();
+        local += run_kernel(k, a, b, c, lo, hi);
+        #pragma omp barrier
+        #pragma omp single
+        {
+            double once = omp_get_wtime() - t0;
+            reps = (once > 0) ? (long)(TARGET_TIME / once) + 1 : 1000;
+            t0 = omp_get_wtime();
+        }
+
+        /* Every thread runs the same number of passes, one barrier at the end */
+        for (long r = 0; r < reps; r++)
+            local += run_kernel(k, a, b, c, lo, hi);
+        #pragma omp barrier
+        #pragma omp single
+        t1 = omp_get_wtime();
+
+        #pragma omp atomic
+        sink += local;
+    }
+    return (t1 - t0) / reps;
+}
+
+static void run_bw(size_t max_bytes, const int *thread_list, int n_threads)
+{
+    size_t sizes[MAX_POINTS];
+    int n_sizes = build_sizes(max_bytes, sizes);
+    size_t n_max = max_bytes / sizeof(double);
+
+    double *a = alloc_lines(max_bytes);
+    double *b = alloc_lines(max_bytes);
+    double *c = alloc_lines(max_bytes);
+
+    /* Parallel first touch with the largest thread count */
+    int tmax = thread_list[n_threads - 1];
+    #pragma omp parallel for schedule(static) num_threads(tmax)
+    for (size_t i = 0; i < n_max; i++) {
+        a[i] = 1.0; b[i] = 2.0; c[i] = 3.0;
+    }
+
+    fprintf(stderr, "[bw] %d sizes x %d kernels x %d thread counts\n",
+            n_sizes, K_COUNT, n_threads);
+    for (int x = 0; x < n_threads; x++) {
+        int threads = thread_list[x];
+        for (int s = 0; s < n_sizes; s++) {
+            for (int k = 0; k < K_COUNT; k++) {
+                /* Split the working set over the arrays the kernel uses */
+                int arrays = kernel_bytes[k] / 8;
+                size_t n = sizes[s] / sizeof(double) / arrays;
+                if (n < (size_t)(4 * threads)) continue;
+
+                double t = time_kernel((kernel_t)k, a, b, c, n, threads);
+                print_row("bw", kernel_names[k], threads, sizes[s], 1, t,
+                          (double)n, (double)n * kernel_bytes[k]);
+            }
+        }
+    }
+    free(a); free(b); free(c);
+}
+
+/* ----------------------------------------------------------------
+ * Cache level detection from the latency curve
+ * ----------------------------------------------------------------
+ * A new level starts when the latency rises more than 40% above the
+ * plateau of the current one; its capacity is the last size before
+ * the jump.  While the curve keeps climbing (>10% per point) we are
+ * still in the same transition, so no further level is reported
+ * until it flattens again.
+ *
+ * A jump is only reported as a cache level when a data or unified
+ * cache of the OS (sysfs, else sysconf) is within a factor of 2 of
+ * its size; each OS level is matched once.  Other jumps (TLB reach,
+ * page walks, noise) are listed on stderr as not matched and left
+ * out of the CSV.  When the OS reports no cache sizes at all the
+ * jumps are reported unchecked, numbered in order.
+ * ---------------------------------------------------------------- */
+#define MAX_LEVELS 4
+
+/* "48K", "2048K", "32M" -> bytes, 0 if unreadable */
+static long read_size_file(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    long v = 0;
+    char unit = 0;
+    if (!f) return 0;
+    if (fscanf(f, "%ld%c", &v, &unit) < 1) v = 0;
+    fclose(f);
+    if (unit == 'K') v *= 1024;
+    else if (unit == 'M') v *= 1024 * 1024;
+    else if (unit == 'G') v *= 1024L * 1024 * 1024;
+    return v;
+}
+
+/* Data / unified cache size per level 1..MAX_LEVELS of cpu0 (0 = none) */
+static int os_cache_sizes(long *sys)
+{
+    int known = 0;
+    for (int l = 0; l < MAX_LEVELS; l++) sys[l] = 0;
+
+    for (int idx = 0; idx < 16; idx++) {
+        char path[128], type[32] = "";
+        int level = 0;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", idx);
+        FILE *f = fopen(path, "r");
+        if (!f) break;
+        if (fscanf(f, "%d", &level) != 1) level = 0;
+        fclose(f);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", idx);
+        if ((f = fopen(path, "r"))) {
+            if (fscanf(f, "%31s", type) != 1) type[0] = 0;
+            fclose(f);
+        }
+        if (level < 1 || level > MAX_LEVELS || strcmp(type, "Instruction") == 0) continue;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", idx);
+        sys[level - 1] = read_size_file(path);
+    }
+
+    long conf[MAX_LEVELS] = {
+        sysconf(_SC_LEVEL1_DCACHE_SIZE), sysconf(_SC_LEVEL2_CACHE_SIZE),
+        sysconf(_SC_LEVEL3_CACHE_SIZE), sysconf(_SC_LEVEL4_CACHE_SIZE)
+    };
+    for (int l = 0; l < MAX_LEVELS; l++) {
+        if (sys[l] <= 0 && conf[l] > 0) sys[l] = conf[l];
+        if (sys[l] > 0) known++;
+    }
+    return known;
+}
+
+static void report_levels(const size_t *sizes, const double *lat, int n)
+{
+    long sys[MAX_LEVELS];
+    int known = os_cache_sizes(sys);
+    int matched[MAX_LEVELS] = {0};
+    double plateau = lat[0];
+    int found = 0, rising = 0;
+
+    fprintf(stderr, "\n%-6s %-14s %-14s %-12s\n", "Level", "Detected", "OS reports", "Latency(ns)");
+    for (int s = 1; s < n; s++) {
+        if (rising) {
+            rising = (lat[s] > 1.1 * lat[s - 1]);
+            plateau = lat[s];
+            continue;
+        }
+        if (lat[s] > 1.4 * plateau) {
+            size_t cap = sizes[s - 1];
+            int level = -1;
+
+            if (known == 0) {
+                level = (found < MAX_LEVELS) ? found : -1;
+            } else {
+                for (int l = 0; l < MAX_LEVELS && level < 0; l++)
+                    if (!matched[l] && sys[l] > 0 &&
+                        (double)cap >= sys[l] / 2.0 && (double)cap <= sys[l] * 2.0)
+                        level = l;
+            }
+
+            if (level >= 0) {
+                char name[8];
+                snprintf(name, sizeof(name), "L%d", level + 1);
+                matched[level] = 1;
+                found++;
+                printf("level,%s,1,%zu,0,%.6e,%.4f,%.4f\n", name, cap,
+                       plateau * 1e-9, plateau, LINE / plateau);
+                fprintf(stderr, "%-6s %-14zu %-14ld %-12.2f\n", name, cap,
+                        sys[level] > 0 ? sys[level] : 0, plateau);
+            } else {
+                fprintf(stderr, "%-6s %-14zu %-14s %-12.2f (no cache of that size, ignored)\n",
+                        "-", cap, "-", plateau);
+            }
+            rising = 1;
+            plateau = lat[s];
+        }
+    }
+    printf("level,DRAM,1,%zu,0,%.6e,%.4f,%.4f\n", sizes[n - 1], lat[n - 1] * 1e-9,
+           lat[n - 1], LINE / lat[n - 1]);
+    fprintf(stderr, "%-6s %-14s %-14s %-12.2f\n", "DRAM", "-", "-", lat[n - 1]);
+}
+
+/* ----------------------------------------------------------------
+ * MAIN
+ * ---------------------------------------------------------------- */
+static int parse_threads(const char *arg, int *list)
+{
+    int n = 0;
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", arg);
+    for (char *tok = strtok(buf, ","); tok && n < MAX_THREAD_LIST; tok = strtok(NULL, ",")) {
+        int t = atoi(tok);
+        if (t > 0) list[n++] = t;
+    }
+    return n;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *mode = "all";
+    size_t max_mb = 512;
+    int thread_list[MAX_THREAD_LIST];
+    int n_threads = 0;
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "-max") == 0 && a + 1 < argc) {
+            max_mb = (size_t)atol(argv[++a]);
+        } else if (strcmp(argv[a], "-t") == 0 && a + 1 < argc) {
+            n_threads = parse_threads(argv[++a], thread_list);
+        } else if (argv[a][0] != '-') {
+            mode = argv[a];
+        } else {
+            fprintf(stderr, "Usage: %s [all|stride|latency|bw] [-max MB] [-t t1,t2,...]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (max_mb < 1) max_mb = 1;
+    size_t max_bytes = max_mb * 1024 * 1024;
+
+    /* Default thread list: 1, 2, 4, ... up to the OpenMP maximum */
+    if (n_threads == 0) {
+        int tmax = omp_get_max_threads();
+        for (int t = 1; t < tmax && n_threads < MAX_THREAD_LIST - 1; t *= 2)
+            thread_list[n_threads++] = t;
+        thread_list[n_threads++] = tmax;
+    }
+
+    printf("test,kernel,threads,bytes,stride,time_s,ns_per_access,gb_per_s\n");
+
+    int all = (strcmp(mode, "all") == 0);
+    if (all || strcmp(mode, "stride") == 0)
+        run_stride(max_bytes);
+    if (all || strcmp(mode, "latency") == 0) {
+        size_t sizes[MAX_POINTS];
+        double lat[MAX_POINTS];
+        int n = run_latency(max_bytes, sizes, lat);
+        report_levels(sizes, lat, n);
+    }
+    if (all || strcmp(mode, "bw") == 0)
+        run_bw(max_bytes, thread_list, n_threads);
+
+    return 0;
+}
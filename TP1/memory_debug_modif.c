@@ -1,17 +1,32 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#include "mem_pool.h"
+
+// Release: gcc -O2 -I../common -o memory_debug memory_debug_modif.c ../common/mem_pool.c
+// Debug:   gcc -O2 -DPOOL_DEBUG -I../common -o memory_debug memory_debug_modif.c ../common/mem_pool.c
+//          (add -DLEAK_DEMO to bring back the original missing free and see it reported)
 
 #define SIZE 5
 
-int* allocate_array(int size) {
-    int *arr = (int*)malloc(size * sizeof(int));
+// Scratch-buffer loop: one allocate/free cycle per "solver step"
+#define STEPS   200000
+#define SCRATCH 4096
+
+// The helpers take the caller's file and line (POOL_CALLER, see
+// mem_pool.h), so a leak is reported at the line of main() that made
+// the array, not inside the helper.
+int* allocate_array_at(int size, const char *file, int line) {
+    int *arr = (int*)pool_alloc_at(size * sizeof(int), file, line);
     if (!arr) {
         fprintf(stderr, "Memory allocation failed\n");
         exit(EXIT_FAILURE);
     }
     return arr;
 }
+#define allocate_array(size) allocate_array_at((size), POOL_CALLER)
 
 void initialize_array(int *arr, int size) {
     if (!arr) return;
@@ -29,24 +44,51 @@ void print_array(int *arr, int size) {
     printf("\n");
 }
 
-int* duplicate_array(int *arr, int size) {
+int* duplicate_array_at(int *arr, int size, const char *file, int line) {
     if (!arr) return NULL;
-    int *copy = (int*)malloc(size * sizeof(int));
+    int *copy = (int*)pool_dup_at(arr, size * sizeof(int), file, line);
     if (!copy) {
         fprintf(stderr, "Memory allocation failed\n");
         exit(EXIT_FAILURE);
     }
-    memcpy(copy, arr, size * sizeof(int));
     return copy;
 }
+#define duplicate_array(arr, size) duplicate_array_at((arr), (size), POOL_CALLER)
 
 // FIX 1: Implement the free function
 void free_memory(int *arr) {
     if (arr != NULL) {
-        free(arr);
+        pool_free(arr);
     }
 }
 
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Allocate, touch and release SCRATCH doubles per step, with malloc or the pool
+static double scratch_loop(int use_pool) {
+    double sink = 0.0;
+    double start = now_sec();
+    for (int s = 0; s < STEPS; s++) {
+        double *tmp = use_pool ? pool_alloc(SCRATCH * sizeof(double))
+                               : malloc(SCRATCH * sizeof(double));
+        if (!tmp) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        tmp[s % SCRATCH] = s;
+        sink += tmp[s % SCRATCH];
+        if (use_pool) pool_free(tmp);
+        else free(tmp);
+    }
+    double elapsed = now_sec() - start;
+    if (sink < 0) printf("%f\n", sink);   // keep the loop alive
+    return elapsed;
+}
+
 int main() {
     int *array = allocate_array(SIZE);
     initialize_array(array, SIZE);
@@ -57,7 +99,15 @@ int main() {
 
     // FIX 2: Free BOTH arrays
     free_memory(array);
-    free_memory(array_copy); 
+#ifndef LEAK_DEMO
+    free_memory(array_copy);
+#endif
+
+    double t_malloc = scratch_loop(0);
+    double t_pool = scratch_loop(1);
+    printf("\nScratch buffers: %d steps x %zu bytes\n", STEPS, SCRATCH * sizeof(double));
+    printf("malloc/free : %8.2f ns per step\n", t_malloc / STEPS * 1e9);
+    printf("pool        : %8.2f ns per step\n", t_pool / STEPS * 1e9);
 
-    return 0; 
+    return 0;
 }
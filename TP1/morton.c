@@ -0,0 +1,265 @@
+/* ================================================================
+ * TP1 - Cache-oblivious Morton (Z-order) tiled matrix layout
+ * (see morton.h)
+ * ================================================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "morton.h"
+
+/* Spread the low 16 bits of x so that bit b moves to bit 2b */
+static unsigned int spread_bits(unsigned int x)
+{
+    x &= 0x0000FFFFu;
+    x = (x | (x << 8)) & 0x00FF00FFu;
+    x = (x | (x << 4)) & 0x0F0F0F0Fu;
+    x = (x | (x << 2)) & 0x33333333u;
+    x = (x | (x << 1)) & 0x55555555u;
+    return x;
+}
+
+/* Z-order position of tile (r, c): column bits even, row bits odd */
+static size_t tile_index(int r, int c)
+{
+    return (size_t)(spread_bits((unsigned int)c) | (spread_bits((unsigned int)r) << 1));
+}
+
+static double *tile_ptr(const morton_matrix_t *M, int r, int c)
+{
+    return M->data + tile_index(r, c) * (size_t)M->tile * M->tile;
+}
+
+int morton_alloc(morton_matrix_t *M, int n, int tile)
+{
+    if (tile <= 0) tile = MORTON_TILE;
+
+    M->n = n;
+    M->tile = tile;
+    M->tiles = (n + tile - 1) / tile;
+    M->side = 1;
+    while (M->side < M->tiles) M->side *= 2;
+
+    size_t elems = (size_t)M->side * M->side * tile * tile;
+    size_t bytes = ((elems * sizeof(double) + 63) / 64) * 64;
+    M->data = (double *)aligned_alloc(64, bytes);
+    if (!M->data) {
+        fprintf(stderr, "[morton] Memory allocation failed\n");
+        return -1;
+    }
+    memset(M->data, 0, bytes);
+    return 0;
+}
+
+void morton_free(morton_matrix_t *M)
+{
+    free(M->data);
+    M->data = NULL;
+}
+
+void morton_from_rowmajor(morton_matrix_t *M, const double *src, int ld)
+{
+    int T = M->tile;
+
+    for (int r = 0; r < M->tiles; r++) {
+        int rows = (M->n - r * T < T) ? M->n - r * T : T;
+        for (int c = 0; c < M->tiles; c++) {
+            int cols = (M->n - c * T < T) ? M->n - c * T : T;
+            double *t = tile_ptr(M, r, c);
+            const double *s = src + (size_t)r * T * ld + (size_t)c * T;
+
+            for (int i = 0; i < rows; i++)
+                memcpy(t + i * T, s + (size_t)i * ld, cols * sizeof(double));
+            /* padding inside edge tiles stays zero from morton_alloc */
+        }
+    }
+}
+
+void morton_to_rowmajor(const morton_matrix_t *M, double *dst, int ld)
+{
+    int T = M->tile;
+
+    for (int r = 0; r < M->tiles; r++) {
+        int rows = (M->n - r * T < T) ? M->n - r * T : T;
+        for (int c = 0; c < M->tiles; c++) {
+            int cols = (M->n - c * T < T) ? M->n - c * T : T;
+            const double *t = tile_ptr(M, r, c);
+            double *d = dst + (size_t)r * T * ld + (size_t)c * T;
+
+            for (int i = 0; i < rows; i++)
+                memcpy(d + (size_t)i * ld, t + i * T, cols * sizeof(double));
+        }
+    }
+}
+
+double morton_get(const morton_matrix_t *M, int i, int j)
+{
+    int T = M->tile;
+    return tile_ptr(M, i / T, j / T)[(i % T) * T + (j % T)];
+}
+
+/* ----------------------------------------------------------------
+ * Leaf kernel: c[T x T] += a[T x T] * b[T x T], all contiguous.
+ * i-k-j order, the j loop is stride-1 and vectorises.  Portable
+ * fallback for CPUs without AVX2 or tile sizes the SIMD leaves
+ * below do not handle.
+ * ---------------------------------------------------------------- */
+static inline void leaf_multiply(int T, double *restrict c,
+                          const double *restrict a, const double *restrict b)
+{
+    for (int i = 0; i < T; i++) {
+        for (int k = 0; k < T; k++) {
+            double r = a[i * T + k];
+            for (int j = 0; j < T; j++)
+                c[i * T + j] += r * b[k * T + j];
+        }
+    }
+}
+
+/*
+ * SIMD leaves, one register block width each: a tile size T that is a
+ * multiple of the block width (which is also a multiple of its 4 rows)
+ * can use it, see select_leaf().  c is walked in register blocks that
+ * stay live across the whole k loop, so each b load feeds several FMAs
+ * instead of the load + store of c per FMA of the plain i-k-j loop.
+ *   AVX2+FMA : 4 rows x 8 cols  ( 8 ymm accumulators), T % 8 == 0
+ *   AVX-512F : 4 rows x 32 cols (16 zmm accumulators), T % 32 == 0
+ */
+typedef void (*leaf_fn)(int T, double *restrict c,
+                        const double *restrict a, const double *restrict b);
+
+__attribute__((target("avx2,fma")))
+static void leaf_avx2(int T, double *restrict c,
+                      const double *restrict a, const double *restrict b)
+{
+    for (int i = 0; i < T; i += 4) {
+        for (int j = 0; j < T; j += 8) {
+            __m256d c00 = _mm256_loadu_pd(c + (i + 0) * T + j), c01 = _mm256_loadu_pd(c + (i + 0) * T + j + 4);
+            __m256d c10 = _mm256_loadu_pd(c + (i + 1) * T + j), c11 = _mm256_loadu_pd(c + (i + 1) * T + j + 4);
+            __m256d c20 = _mm256_loadu_pd(c + (i + 2) * T + j), c21 = _mm256_loadu_pd(c + (i + 2) * T + j + 4);
+            __m256d c30 = _mm256_loadu_pd(c + (i + 3) * T + j), c31 = _mm256_loadu_pd(c + (i + 3) * T + j + 4);
+
+            for (int k = 0; k < T; k++) {
+                __m256d b0 = _mm256_loadu_pd(b + k * T + j);
+                __m256d b1 = _mm256_loadu_pd(b + k * T + j + 4);
+                __m256d ar;
+                ar = _mm256_broadcast_sd(a + (i + 0) * T + k);
+                c00 = _mm256_fmadd_pd(ar, b0, c00); c01 = _mm256_fmadd_pd(ar, b1, c01);
+                ar = _mm256_broadcast_sd(a + (i + 1) * T + k);
+                c10 = _mm256_fmadd_pd(ar, b0, c10); c11 = _mm256_fmadd_pd(ar, b1, c11);
+                ar = _mm256_broadcast_sd(a + (i + 2) * T + k);
+                c20 = _mm256_fmadd_pd(ar, b0, c20); c21 = _mm256_fmadd_pd(ar, b1, c21);
+                ar = _mm256_broadcast_sd(a + (i + 3) * T + k);
+                c30 = _mm256_fmadd_pd(ar, b0, c30); c31 = _mm256_fmadd_pd(ar, b1, c31);
+            }
+
+            _mm256_storeu_pd(c + (i + 0) * T + j, c00); _mm256_storeu_pd(c + (i + 0) * T + j + 4, c01);
+            _mm256_storeu_pd(c + (i + 1) * T + j, c10); _mm256_storeu_pd(c + (i + 1) * T + j + 4, c11);
+            _mm256_storeu_pd(c + (i + 2) * T + j, c20); _mm256_storeu_pd(c + (i + 2) * T + j + 4, c21);
+            _mm256_storeu_pd(c + (i + 3) * T + j, c30); _mm256_storeu_pd(c + (i + 3) * T + j + 4, c31);
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+static void leaf_avx512(int T, double *restrict c,
+                        const double *restrict a, const double *restrict b)
+{
+    for (int i = 0; i < T; i += 4) {
+        for (int j = 0; j < T; j += 32) {
+            __m512d acc[4][4];
+#pragma GCC unroll 4
+            for (int r = 0; r < 4; r++)
+#pragma GCC unroll 4
+                for (int v = 0; v < 4; v++)
+                    acc[r][v] = _mm512_loadu_pd(c + (i + r) * T + j + 8 * v);
+
+            for (int k = 0; k < T; k++) {
+                __m512d b0 = _mm512_loadu_pd(b + k * T + j);
+                __m512d b1 = _mm512_loadu_pd(b + k * T + j + 8);
+                __m512d b2 = _mm512_loadu_pd(b + k * T + j + 16);
+                __m512d b3 = _mm512_loadu_pd(b + k * T + j + 24);
+#pragma GCC unroll 4
+                for (int r = 0; r < 4; r++) {
+                    __m512d ar = _mm512_set1_pd(a[(i + r) * T + k]);
+                    acc[r][0] = _mm512_fmadd_pd(ar, b0, acc[r][0]);
+                    acc[r][1] = _mm512_fmadd_pd(ar, b1, acc[r][1]);
+                    acc[r][2] = _mm512_fmadd_pd(ar, b2, acc[r][2]);
+                    acc[r][3] = _mm512_fmadd_pd(ar, b3, acc[r][3]);
+                }
+            }
+
+#pragma GCC unroll 4
+            for (int r = 0; r < 4; r++)
+#pragma GCC unroll 4
+                for (int v = 0; v < 4; v++)
+                    _mm512_storeu_pd(c + (i + r) * T + j + 8 * v, acc[r][v]);
+        }
+    }
+}
+
+static void leaf_generic(int T, double *restrict c,
+                         const double *restrict a, const double *restrict b)
+{
+    leaf_multiply(T, c, a, b);
+}
+
+/* Widest leaf usable for tile size T on this CPU */
+static leaf_fn select_leaf(int T)
+{
+    __builtin_cpu_init();
+    if (T % 32 == 0 && __builtin_cpu_supports("avx512f"))
+        return leaf_avx512;
+    if (T % 8 == 0 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return leaf_avx2;
+    return leaf_generic;
+}
+
+/*
+ * Recursive step on blocks of s x s tiles whose top-left tile is
+ * (r0, c0) in C, (r0, k0) in A and (k0, c0) in B.  'valid' is the
+ * number of tiles per side that hold data: any block starting at or
+ * past it is pure padding and contributes nothing.
+ */
+static void multiply_rec(leaf_fn leaf, int T, int s, int valid,
+                         double *c, const double *a, const double *b,
+                         int r0, int c0, int k0)
+{
+    if (r0 >= valid || c0 >= valid || k0 >= valid)
+        return;
+
+    if (s == 1) {
+        leaf(T, c, a, b);
+        return;
+    }
+
+    int h = s / 2;
+    size_t q = (size_t)h * h * T * T;   /* elements in one quadrant */
+
+    const double *a00 = a,         *a01 = a + q,     *a10 = a + 2 * q, *a11 = a + 3 * q;
+    const double *b00 = b,         *b01 = b + q,     *b10 = b + 2 * q, *b11 = b + 3 * q;
+    double       *c00 = c,         *c01 = c + q,     *c10 = c + 2 * q, *c11 = c + 3 * q;
+
+    /* C_ij += A_i0 B_0j, then C_ij += A_i1 B_1j (k half first keeps B hot) */
+    multiply_rec(leaf, T, h, valid, c00, a00, b00, r0,     c0,     k0);
+    multiply_rec(leaf, T, h, valid, c01, a00, b01, r0,     c0 + h, k0);
+    multiply_rec(leaf, T, h, valid, c10, a10, b00, r0 + h, c0,     k0);
+    multiply_rec(leaf, T, h, valid, c11, a10, b01, r0 + h, c0 + h, k0);
+
+    multiply_rec(leaf, T, h, valid, c00, a01, b10, r0,     c0,     k0 + h);
+    multiply_rec(leaf, T, h, valid, c01, a01, b11, r0,     c0 + h, k0 + h);
+    multiply_rec(leaf, T, h, valid, c10, a11, b10, r0 + h, c0,     k0 + h);
+    multiply_rec(leaf, T, h, valid, c11, a11, b11, r0 + h, c0 + h, k0 + h);
+}
+
+void morton_multiply(morton_matrix_t *C, const morton_matrix_t *A,
+                     const morton_matrix_t *B)
+{
+    if (A->n != B->n || A->n != C->n || A->tile != B->tile || A->tile != C->tile) {
+        fprintf(stderr, "[morton] Mismatched operands\n");
+        exit(EXIT_FAILURE);
+    }
+    multiply_rec(select_leaf(C->tile), C->tile, C->side, C->tiles, C->data, A->data, B->data, 0, 0, 0);
+}
@@ -0,0 +1,56 @@
+/* ================================================================
+ * TP1 - Cache-oblivious Morton (Z-order) tiled matrix layout
+ * ================================================================
+ *
+ * An n x n matrix is cut into T x T leaf tiles (row-major inside a
+ * tile).  The tiles themselves are stored in Z-order: the tile at
+ * tile-row r, tile-col c lives at position interleave(r, c), with
+ * the column bit as the least significant one.  The tile grid is
+ * padded up to a power of two per side, so every recursive quadrant
+ * (top-left, top-right, bottom-left, bottom-right) is one contiguous
+ * quarter of its parent:
+ *
+ *      +----+----+
+ *      | 0  | 1  |      quadrant q of a block of s x s tiles
+ *      +----+----+      starts at  q * (s/2)^2 * T*T  elements
+ *      | 2  | 3  |
+ *      +----+----+
+ *
+ * Every level of the recursion therefore touches contiguous memory,
+ * whatever the cache or TLB sizes are.  Padding (elements beyond n)
+ * is kept at zero and quadrants made only of padding are skipped by
+ * the multiply.
+ * ================================================================ */
+
+#ifndef MORTON_H
+#define MORTON_H
+
+/* Default leaf tile: three 32x32 double tiles (24 KB) fit in L1 */
+#ifndef MORTON_TILE
+#define MORTON_TILE 32
+#endif
+
+typedef struct {
+    int n;          /* logical size (n x n)                        */
+    int tile;       /* leaf tile size T                            */
+    int tiles;      /* tiles per side actually holding data        */
+    int side;       /* tiles per side after padding (power of two) */
+    double *data;   /* side*side tiles of T*T doubles, Z-ordered   */
+} morton_matrix_t;
+
+/* Allocate a zeroed n x n Morton matrix (tile <= 0 selects MORTON_TILE) */
+int  morton_alloc(morton_matrix_t *M, int n, int tile);
+void morton_free(morton_matrix_t *M);
+
+/* Conversion from / to a row-major array with leading dimension ld */
+void morton_from_rowmajor(morton_matrix_t *M, const double *src, int ld);
+void morton_to_rowmajor(const morton_matrix_t *M, double *dst, int ld);
+
+/* Element access (for checks, not for inner loops) */
+double morton_get(const morton_matrix_t *M, int i, int j);
+
+/* C += A * B, all three with the same n and tile, divide and conquer */
+void morton_multiply(morton_matrix_t *C, const morton_matrix_t *A,
+                     const morton_matrix_t *B);
+
+#endif /* MORTON_H */
@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "gemm.h"
+#include "matmul_tune.h"
+#include "morton.h"
+#include "bench_harness.h"
+
+// Build: gcc -O3 -fopenmp -I../common -o morton_bench morton_bench.c morton.c gemm.c
+//            matmul_tune.c ../common/bench_harness.c ../common/perf_counters.c -lm
+//
+// Usage: ./morton_bench [harness options] [n1 n2 ...]
+// The default sizes are primes, so no block size of mxm_bloc.c divides them
+// and every kernel has to go through its edge-case path.
+//
+// Each kernel and size is one harness case ("gemm 1021", ...); the table
+// below uses the medians.
+
+// Helper: Fill matrix with random values
+void initialize_matrix(double *mat, int n) {
+    for (int i = 0; i < n * n; i++) {
+        mat[i] = (double)rand() / RAND_MAX;
+    }
+}
+
+// Helper: Clear result matrix
+void clear_matrix(double *mat, int n) {
+    for (int i = 0; i < n * n; i++) {
+        mat[i] = 0.0;
+    }
+}
+
+// Original scalar blocked kernel of mxm_bloc.c (row-major, i-k-j in the block)
+void mat_mul_block_scalar(double *A, double *B, double *C, int n, int b_size) {
+    for (int ii = 0; ii < n; ii += b_size) {
+        for (int kk = 0; kk < n; kk += b_size) {
+            for (int jj = 0; jj < n; jj += b_size) {
+                int i_limit = (ii + b_size > n) ? n : ii + b_size;
+                int k_limit = (kk + b_size > n) ? n : kk + b_size;
+                int j_limit = (jj + b_size > n) ? n : jj + b_size;
+
+                for (int i = ii; i < i_limit; i++) {
+                    for (int k = kk; k < k_limit; k++) {
+                        double r = A[i * n + k];
+                        for (int j = jj; j < j_limit; j++) {
+                            C[i * n + j] += r * B[k * n + j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Blocking of the GEMM case: the one saved by mxm_bloc --tune for this
+// machine, else the cache-derived default (set in main)
+static gemm_blocking_t gemm_blk;
+
+// Packed SIMD GEMM of gemm.c (what mxm_bloc.c runs)
+void mat_mul_gemm(double *A, double *B, double *C, int n) {
+    gemm(n, n, n, A, n, B, n, C, n, &gemm_blk);
+}
+
+// Helper: Largest |X - Y| over two row-major matrices
+double max_diff(const double *X, const double *Y, int n) {
+    double m = 0.0;
+    for (int i = 0; i < n * n; i++) {
+        double d = fabs(X[i] - Y[i]);
+        if (d > m) m = d;
+    }
+    return m;
+}
+
+// Scalar blocked kernel block size (as in the mxm_bloc sweep)
+#define SCALAR_BLOCK 64
+
+// Operands and results of one size
+typedef struct {
+    int n;
+    double *A, *B, *C_ref, *C_gemm, *C;
+    morton_matrix_t mA, mB, mC;
+    char names[4][32];
+} size_ctx_t;
+
+static const char *kernel_names[4] = {"scalar", "gemm", "morton", "morton+conv"};
+
+// Untimed setup: clear the output of the kernel about to run
+static void clear_ref(void *p)   { size_ctx_t *s = p; clear_matrix(s->C_ref, s->n); }
+static void clear_gemm(void *p)  { size_ctx_t *s = p; clear_matrix(s->C_gemm, s->n); }
+static void clear_morton(void *p) {
+    size_ctx_t *s = p;
+    memset(s->mC.data, 0, (size_t)s->mC.side * s->mC.side * s->mC.tile * s->mC.tile * sizeof(double));
+}
+
+// 1. Original scalar blocked kernel on row-major storage
+static void run_scalar(void *p) {
+    size_ctx_t *s = p;
+    mat_mul_block_scalar(s->A, s->B, s->C_ref, s->n, SCALAR_BLOCK);
+}
+
+// 2. Packed GEMM engine (gemm.c)
+static void run_gemm(void *p) {
+    size_ctx_t *s = p;
+    mat_mul_gemm(s->A, s->B, s->C_gemm, s->n);
+}
+
+// 3. Morton layout: multiply only, then with the conversions in and out
+static void run_morton(void *p) {
+    size_ctx_t *s = p;
+    morton_multiply(&s->mC, &s->mA, &s->mB);
+}
+
+static void run_morton_conv(void *p) {
+    size_ctx_t *s = p;
+    morton_from_rowmajor(&s->mA, s->A, s->n);
+    morton_from_rowmajor(&s->mB, s->B, s->n);
+    morton_multiply(&s->mC, &s->mA, &s->mB);
+    morton_to_rowmajor(&s->mC, s->C, s->n);
+}
+
+int main(int argc, char *argv[]) {
+    // Seconds per case for the larger sizes: no warm-up, 3 to 5 repetitions
+    bench_defaults(0, 3, 5, 10.0);
+    if (bench_init("tp1_morton", &argc, argv) != 0)
+        return 1;
+
+    int default_sizes[] = {509, 1021, 1531, 2039};
+    int num_sizes = sizeof(default_sizes) / sizeof(default_sizes[0]);
+    int *sizes = default_sizes;
+
+    if (argc > 1) {
+        num_sizes = argc - 1;
+        sizes = malloc(num_sizes * sizeof(int));
+        for (int x = 0; x < num_sizes; x++) sizes[x] = atoi(argv[x + 1]);
+    }
+
+    int tuned = matmul_tune_load(&gemm_blk, NULL);
+    if (!tuned)
+        gemm_default_blocking(gemm_detect_isa(), &gemm_blk);
+
+    size_ctx_t *ctx = calloc(num_sizes, sizeof(size_ctx_t));
+    if (!ctx) {
+        printf("Memory allocation failed!\n");
+        return 1;
+    }
+    void (*setups[4])(void *) = {clear_ref, clear_gemm, clear_morton, clear_morton};
+    void (*runs[4])(void *) = {run_scalar, run_gemm, run_morton, run_morton_conv};
+
+    for (int x = 0; x < num_sizes; x++) {
+        size_ctx_t *s = &ctx[x];
+        int n = s->n = sizes[x];
+        if (n <= 0) continue;
+        double flops = 2.0 * n * (double)n * n;
+
+        s->A = malloc((size_t)n * n * sizeof(double));
+        s->B = malloc((size_t)n * n * sizeof(double));
+        s->C_ref = malloc((size_t)n * n * sizeof(double));
+        s->C_gemm = malloc((size_t)n * n * sizeof(double));
+        s->C = malloc((size_t)n * n * sizeof(double));
+
+        if (!s->A || !s->B || !s->C_ref || !s->C_gemm || !s->C ||
+            morton_alloc(&s->mA, n, 0) || morton_alloc(&s->mB, n, 0) || morton_alloc(&s->mC, n, 0)) {
+            printf("Memory allocation failed!\n");
+            return 1;
+        }
+        initialize_matrix(s->A, n);
+        initialize_matrix(s->B, n);
+        morton_from_rowmajor(&s->mA, s->A, n);
+        morton_from_rowmajor(&s->mB, s->B, n);
+
+        for (int k = 0; k < 4; k++) {
+            snprintf(s->names[k], sizeof(s->names[k]), "%s %d", kernel_names[k], n);
+            bench_case_t c = {s->names[k], setups[k], runs[k], s, 0, flops, 0};
+            bench_add(&c);
+        }
+    }
+
+    printf("Morton tile: %d | Scalar block: %d | GEMM kernel: %s\n",
+           MORTON_TILE, SCALAR_BLOCK, gemm_isa_name(gemm_detect_isa()));
+    printf("GEMM blocking: MC=%d KC=%d NC=%d order=%s (%s)\n", gemm_blk.mc, gemm_blk.kc,
+           gemm_blk.nc, gemm_order_name(gemm_blk.order), tuned ? matmul_tune_path() : "default");
+    bench_run();
+
+    printf("\n------------------------------------------------------------------------------------------------\n");
+    printf("| N     | Scalar block    | Packed GEMM     | Morton multiply | Morton + convert | Max |error|  |\n");
+    printf("|       | sec    (GFLOPS) | sec    (GFLOPS) | sec    (GFLOPS) | sec    (GFLOPS)  |              |\n");
+    printf("------------------------------------------------------------------------------------------------\n");
+
+    for (int x = 0; x < num_sizes; x++) {
+        size_ctx_t *s = &ctx[x];
+        int n = s->n;
+        if (n <= 0) continue;
+
+        const bench_result_t *r[4];
+        int all = 1;
+        for (int k = 0; k < 4; k++) {
+            r[k] = bench_result(s->names[k]);
+            if (!r[k]) all = 0;
+        }
+        if (!all) continue;   // filtered out: no reference to check against
+
+        // Outputs of the last repetition of each kernel
+        double err = max_diff(s->C_gemm, s->C_ref, n);
+        double err_m = max_diff(s->C, s->C_ref, n);
+        if (err_m > err) err = err_m;
+
+        printf("| %-5d | %-6.3f (%5.2f) | %-6.3f (%5.2f) | %-6.3f (%5.2f) | %-6.3f (%5.2f)  | %-12.3e |\n",
+               n, r[0]->median, r[0]->gflops, r[1]->median, r[1]->gflops,
+               r[2]->median, r[2]->gflops, r[3]->median, r[3]->gflops, err);
+    }
+    printf("------------------------------------------------------------------------------------------------\n");
+
+    for (int x = 0; x < num_sizes; x++) {
+        size_ctx_t *s = &ctx[x];
+        if (s->n <= 0) continue;
+        morton_free(&s->mA); morton_free(&s->mB); morton_free(&s->mC);
+        free(s->A); free(s->B); free(s->C_ref); free(s->C_gemm); free(s->C);
+    }
+    free(ctx);
+    if (sizes != default_sizes) free(sizes);
+    return 0;
+}
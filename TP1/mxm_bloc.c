@@ -1,57 +1,187 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <omp.h>
+
+#include "gemm.h"
+#include "matmul_tune.h"
+#include "hpc_alloc.h"
+#include "bench_harness.h"
+
+// Build: gcc -O3 -fopenmp -I../common -o mxm_bloc mxm_bloc.c gemm.c matmul_tune.c ../common/hpc_alloc.c
+//            ../common/bench_harness.c ../common/perf_counters.c -lm
+//
+// Usage:
+//   ./mxm_bloc            tuned blocking if this machine has been tuned, else the sweep
+//   ./mxm_bloc --sweep    always run the block-size sweep
+//   ./mxm_bloc --tune [n] search the best blocking on an n x n problem, save it, run it
+//   plus the harness options (--reps=MIN:MAX, --json=FILE, ... see bench_harness.h)
+//
+// Every blocking is two harness cases, "<block>" (serial gemm) and
+// "<block> par" (gemm_parallel); the table below uses their medians.
 
 // CHANGE 1: Increase N to 2048 to exceed L3 Cache size (96MB total data)
+#ifndef N
 #define N 2048
+#endif
 
 // Helper: Fill matrix with random values
+// Rows are first-touched by the thread that later works on them
+// (same static split as gemm_parallel), so on a multi-socket node the
+// pages land on the socket that uses them instead of all on node 0.
+// rand_r with a per-row seed keeps the fill thread-safe and reproducible.
 void initialize_matrix(double *mat, int n) {
-    for (int i = 0; i < n * n; i++) {
-        mat[i] = (double)rand() / RAND_MAX;
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        unsigned int seed = 12345u + (unsigned int)i;
+        for (int j = 0; j < n; j++) {
+            mat[i * n + j] = (double)rand_r(&seed) / RAND_MAX;
+        }
     }
 }
 
-// Helper: Clear result matrix
+// Helper: Clear result matrix (parallel first touch, see above)
 void clear_matrix(double *mat, int n) {
-    for (int i = 0; i < n * n; i++) {
-        mat[i] = 0.0;
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            mat[i * n + j] = 0.0;
+        }
+    }
+}
+
+// Helper: Nominal core frequency in GHz (0 if unknown)
+double cpu_ghz(void) {
+    FILE *f = fopen("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq", "r");
+    long khz = 0;
+    if (f) {
+        if (fscanf(f, "%ld", &khz) != 1) khz = 0;
+        fclose(f);
+        if (khz > 0) return khz / 1e6;
+    }
+    f = fopen("/proc/cpuinfo", "r");
+    if (!f) return 0.0;
+    char line[256];
+    double mhz = 0.0;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "cpu MHz : %lf", &mhz) == 1) break;
+    }
+    fclose(f);
+    return mhz / 1e3;
+}
+
+// Helper: Largest error of a few C entries against a plain dot product
+double spot_check(double *A, double *B, double *C, int n) {
+    double max_err = 0.0;
+    for (int s = 0; s < 8; s++) {
+        int i = (s * 7919) % n, j = (s * 104729) % n;
+        double ref = 0.0;
+        for (int k = 0; k < n; k++) ref += A[i * n + k] * B[k * n + j];
+        double err = C[i * n + j] - ref;
+        if (err < 0) err = -err;
+        if (err > max_err) max_err = err;
     }
+    return max_err;
 }
 
 // ----------------------------------------------------------------------
-// Block Matrix Multiplication Function
+// Block Matrix Multiplication
 // ----------------------------------------------------------------------
-void mat_mul_block(double *A, double *B, double *C, int n, int b_size) {
-    // ii, jj, kk are the start indices of the BLOCKS
-    for (int ii = 0; ii < n; ii += b_size) {
-        for (int kk = 0; kk < n; kk += b_size) {
-            for (int jj = 0; jj < n; jj += b_size) {
-
-                // Handle edge cases if N is not divisible by b_size
-                int i_limit = (ii + b_size > n) ? n : ii + b_size;
-                int k_limit = (kk + b_size > n) ? n : kk + b_size;
-                int j_limit = (jj + b_size > n) ? n : jj + b_size;
-
-                // Standard multiplication INSIDE the block (i-k-j optimization)
-                for (int i = ii; i < i_limit; i++) {
-                    for (int k = kk; k < k_limit; k++) {
-                        double r = A[i * n + k]; // Load A once per inner loop
-                        for (int j = jj; j < j_limit; j++) {
-                            C[i * n + j] += r * B[k * n + j];
-                        }
-                    }
-                }
-            }
+// The block size of the sweep is the depth (KC) of the packed A/B panels,
+// i.e. the L1 block.  The L2 (MC) and L3 (NC) blocks come from the detected
+// cache sizes, and the inner MR x NR tile runs in a SIMD FMA micro-kernel
+// (see gemm.c).  gemm_parallel() packs each B panel once for the whole
+// team and shares the row blocks of C between OpenMP threads, each with
+// a private A buffer.
+
+// One blocking: operands, and the per-thread work of the last parallel run
+typedef struct {
+    double *A, *B, *C;
+    gemm_blocking_t blk;
+    gemm_thread_stats_t *stats;
+    char label[32], par_label[40];
+} row_ctx_t;
+
+// Untimed setup before every repetition
+static void reset_c(void *p) {
+    clear_matrix(((row_ctx_t *)p)->C, N); // Reset C for fair testing
+}
+
+static void run_serial(void *p) {
+    row_ctx_t *r = p;
+    gemm(N, N, N, r->A, N, r->B, N, r->C, N, &r->blk);
+}
+
+static void run_parallel(void *p) {
+    row_ctx_t *r = p;
+    gemm_parallel(N, N, N, r->A, N, r->B, N, r->C, N, &r->blk, r->stats);
+}
+
+// Print one table row from the serial and parallel medians
+void print_row(const row_ctx_t *row, int threads) {
+    const bench_result_t *rs = bench_result(row->label);
+    const bench_result_t *rp = bench_result(row->par_label);
+    if (!rs || !rp) return;
+
+    // Metrics setup
+    double data_size_bytes = 3.0 * N * N * sizeof(double); // For Bandwidth
+    double total_ops = 2.0 * N * N * N;                   // For GFLOPS
+
+    double time_taken = rs->median;
+
+    // Calculate Metrics
+    double bw_mb = (data_size_bytes / time_taken) / (1024.0 * 1024.0);
+    double gflops = (total_ops / time_taken) / 1e9;
+
+    double time_par = rp->median;
+    double gflops_par = (total_ops / time_par) / 1e9;
+    double efficiency = time_taken / (time_par * threads) * 100.0;
+
+    // Average of what each thread achieved while it was busy
+    double thr_gflops = 0.0;
+    int active = 0;
+    for (int t = 0; t < threads; t++) {
+        if (row->stats[t].seconds > 0) {
+            thr_gflops += row->stats[t].flops / row->stats[t].seconds / 1e9;
+            active++;
         }
     }
+    if (active > 0) thr_gflops /= active;
+
+    char cells[160];
+    perf_table_cells(&rs->perf, cells, sizeof(cells));
+
+    printf("| %-10s | %-10.4f | %-16.2f | %-20.2f | %-10.4f | %-11.2f | %-13.2f | %9.1f%% %s\n",
+           row->label, time_taken, bw_mb, gflops, time_par, gflops_par, thr_gflops, efficiency, cells);
 }
 
-int main() {
-    // Allocate memory
-    double *A = (double *)malloc(N * N * sizeof(double));
-    double *B = (double *)malloc(N * N * sizeof(double));
-    double *C = (double *)malloc(N * N * sizeof(double));
+int main(int argc, char *argv[]) {
+    if (hpc_alloc_parse_args(&argc, argv) != 0)
+        return 1;
+    // Seconds per run at N = 2048: no warm-up, 3 to 5 repetitions
+    bench_defaults(0, 3, 5, 20.0);
+    if (bench_init("tp1_mxm_bloc", &argc, argv) != 0)
+        return 1;
+
+    int force_sweep = 0, tune_n = 0;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--sweep") == 0) {
+            force_sweep = 1;
+        } else if (strcmp(argv[a], "--tune") == 0) {
+            tune_n = (N < 768) ? N : 768;
+            if (a + 1 < argc && atoi(argv[a + 1]) > 0) tune_n = atoi(argv[++a]);
+        } else {
+            printf("Usage: %s [--sweep] [--tune [n]] [--alloc=malloc|aligned|thp|hugetlb] [--interleave]"
+                   " [harness options]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Allocate memory (backing pages chosen by --alloc)
+    double *A = (double *)hpc_malloc((size_t)N * N * sizeof(double));
+    double *B = (double *)hpc_malloc((size_t)N * N * sizeof(double));
+    double *C = (double *)hpc_malloc((size_t)N * N * sizeof(double));
 
     if (!A || !B || !C) {
         printf("Memory allocation failed!\n");
@@ -62,39 +192,100 @@ int main() {
     initialize_matrix(A, N);
     initialize_matrix(B, N);
 
-    // List of block sizes to experiment with
-    int block_sizes[] = {16, 32, 64, 128, 256, 512, 1024};
+    // List of block sizes (KC) to experiment with, 0 = cache-derived default
+    int block_sizes[] = {16, 32, 64, 128, 256, 512, 1024, 0};
     int num_sizes = sizeof(block_sizes) / sizeof(block_sizes[0]);
 
-    printf("\nMatrix Size: %d x %d\n", N, N);
-    printf("Total Data Size: %.2f MB\n", 3.0 * N * N * sizeof(double) / (1024*1024));
-    printf("----------------------------------------------------------------------\n");
-    printf("| Block Size | Time (sec) | Bandwidth (MB/s) | Performance (GFLOPS) |\n");
-    printf("----------------------------------------------------------------------\n");
+    gemm_isa_t isa = gemm_detect_isa();
+    gemm_blocking_t def;
+    gemm_default_blocking(isa, &def);
+    double ghz = cpu_ghz();
 
-    // Metrics setup
-    double data_size_bytes = 3.0 * N * N * sizeof(double); // For Bandwidth
-    double total_ops = 2.0 * N * N * N;                   // For GFLOPS
+    // Tuned blocking: search now if asked, otherwise reuse a saved one
+    gemm_blocking_t tuned;
+    double tuned_gflops = 0.0;
+    int use_tuned = 0;
+    if (tune_n > 0) {
+        printf("\n");
+        tuned_gflops = matmul_autotune(tune_n, &tuned, 1);
+        if (matmul_tune_save(&tuned, tuned_gflops) == 0)
+            printf("Saved to %s\n", matmul_tune_path());
+        use_tuned = 1;
+    } else if (!force_sweep) {
+        use_tuned = matmul_tune_load(&tuned, &tuned_gflops);
+    }
 
-    for (int x = 0; x < num_sizes; x++) {
-        int b_size = block_sizes[x];
+    printf("\nMatrix Size: %d x %d\n", N, N);
+    printf("Total Data Size: %.2f MB (alloc: %s)\n", 3.0 * N * N * sizeof(double) / (1024*1024),
+           hpc_alloc_describe());
+    printf("Micro-kernel: %s | Default blocking MC=%d KC=%d NC=%d\n",
+           gemm_isa_name(isa), def.mc, def.kc, def.nc);
+    if (use_tuned)
+        printf("Tuned blocking (%s): MC=%d KC=%d NC=%d order=%s, skipping the sweep\n",
+               matmul_tune_path(), tuned.mc, tuned.kc, tuned.nc, gemm_order_name(tuned.order));
+    if (ghz > 0)
+        printf("Single-core peak: %.2f GFLOPS (%d flops/cycle @ %.2f GHz)\n",
+               gemm_flops_per_cycle(isa) * ghz, gemm_flops_per_cycle(isa), ghz);
+    int threads = omp_get_max_threads();
+    int num_rows = use_tuned ? 1 : num_sizes;
+    row_ctx_t *rows = calloc(num_rows, sizeof(row_ctx_t));
+    gemm_thread_stats_t *stats = calloc((size_t)num_rows * threads, sizeof(gemm_thread_stats_t));
+    if (!rows || !stats) {
+        printf("Memory allocation failed!\n");
+        return 1;
+    }
+    printf("Threads: %d (serial columns use 1 thread, parallel columns use %d)\n",
+           threads, threads);
 
-        clear_matrix(C, N); // Reset C for fair testing
+    for (int x = 0; x < num_rows; x++) {
+        row_ctx_t *row = &rows[x];
+        row->A = A; row->B = B; row->C = C;
+        row->stats = stats + (size_t)x * threads;
+        row->blk = def;
 
-        clock_t start = clock();
-        mat_mul_block(A, B, C, N, b_size);
-        clock_t end = clock();
+        if (use_tuned) {
+            row->blk = tuned;
+            snprintf(row->label, sizeof(row->label), "tuned");
+        } else if (block_sizes[x] > 0) {
+            row->blk.kc = block_sizes[x];
+            snprintf(row->label, sizeof(row->label), "%d", block_sizes[x]);
+        } else {
+            snprintf(row->label, sizeof(row->label), "auto %d", def.kc);
+        }
+        snprintf(row->par_label, sizeof(row->par_label), "%s par", row->label);
+
+        double flops = 2.0 * N * N * N, bytes = 3.0 * N * N * sizeof(double);
+        bench_case_t serial = {row->label, reset_c, run_serial, row, 1, flops, bytes};
+        bench_case_t par = {row->par_label, reset_c, run_parallel, row, threads, flops, bytes};
+        bench_add(&serial);
+        bench_add(&par);
+    }
+    bench_run();
 
-        double time_taken = ((double)(end - start)) / CLOCKS_PER_SEC;
-        
-        // Calculate Metrics
-        double bw_mb = (data_size_bytes / time_taken) / (1024.0 * 1024.0);
-        double gflops = (total_ops / time_taken) / 1e9;
+    const char *sep = "-------------------------------------------------------------------"
+                      "--------------------------------------------------------";
+    printf("\n%s%s\n", sep, perf_table_rule());
+    printf("| Block Size | Time (sec) | Bandwidth (MB/s) | Performance (GFLOPS) "
+           "| Par. Time  | Par. GFLOPS | GFLOPS/thread | Efficiency %s\n", perf_table_header());
+    printf("%s%s\n", sep, perf_table_rule());
+    for (int x = 0; x < num_rows; x++)
+        print_row(&rows[x], threads);
+    printf("%s%s\n", sep, perf_table_rule());
+    printf("Times are medians; counters (IPC ... DTLB miss) cover the first serial run.\n");
+    printf("Spot check max |error| (last run): %.3e\n", spot_check(A, B, C, N));
 
-        printf("| %-10d | %-10.4f | %-16.2f | %-20.2f |\n", b_size, time_taken, bw_mb, gflops);
+    // Per-thread breakdown of the last parallel run of the last blocking
+    const row_ctx_t *last = &rows[num_rows - 1];
+    printf("\nPer-thread work (%s blocking):\n", use_tuned ? "tuned" : "auto");
+    printf("| Thread | Tiles | Busy (sec) | GFLOPS |\n");
+    for (int t = 0; t < threads; t++) {
+        const gemm_thread_stats_t *st = &last->stats[t];
+        double g = (st->seconds > 0) ? st->flops / st->seconds / 1e9 : 0.0;
+        printf("| %-6d | %-5d | %-10.4f | %-6.2f |\n", t, st->tiles, st->seconds, g);
     }
-    printf("----------------------------------------------------------------------\n");
 
-    free(A); free(B); free(C);
+    free(stats);
+    free(rows);
+    hpc_free(A); hpc_free(B); hpc_free(C);
     return 0;
 }
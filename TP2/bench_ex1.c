@@ -2,6 +2,18 @@
 #include <stdlib.h>
 #include <time.h>
 
+#include "bench_harness.h"
+#include "simd_reduce.h"
+
+// Compile: gcc -O2 -I../common -DT=double -o bench_ex1 bench_ex1.c ../common/bench_harness.c
+//              ../common/perf_counters.c ../common/simd_reduce.c -lm
+//          (-DT=int -DIS_INT for the integer version; float, short, long long also work)
+// Usage:   ./bench_ex1 [--reps=MIN:MAX] [--json=FILE] [--csv=FILE] ... (see bench_harness.h)
+//
+// The type stays a compile-time choice on purpose: the exercise is to rebuild
+// with another -DT and compare the generated code.  bench_family.c runs every
+// type (and every unroll/accumulator/ISA shape) from one binary.
+
 // If T isn't defined by the compiler line, default to double
 #ifndef T
 #define T double
@@ -10,77 +22,141 @@
 // We need a larger N to measure fast integer operations
 #define N 10000000
 
-int main() {
-    // 1. Allocate Memory
-    T *a = malloc(N * sizeof(T));
-    T sum = 0;
-    double start, end;
-
-    // 2. Initialize
-    for (int i = 0; i < N; i++) a[i] = (T)1;
-
-    // Helper macro to print based on type
-    // We cast to double for floats, and long long for ints to handle everything safely
-    #ifdef IS_INT
-        #define PRINT_RES(u, s, t) printf("U %-2d: Sum = %-12lld | Time = %.4f ms\n", u, (long long)s, t)
-    #else
-        #define PRINT_RES(u, s, t) printf("U %-2d: Sum = %-12.1f | Time = %.4f ms\n", u, (double)s, t)
-    #endif
+// Shared by all unroll cases: the input and the last sum computed
+typedef struct {
+    T *a;
+    T sum;
+} sum_ctx_t;
 
-    printf("Benchmarking N = %d elements...\n", N);
-
-    // --- Unroll Factor 1 ---
-    sum = 0;
-    start = (double)clock() / CLOCKS_PER_SEC;
+// --- Unroll Factor 1 ---
+static void unroll_1(void *p) {
+    sum_ctx_t *x = p; T *a = x->a; T sum = 0;
     for (int i = 0; i < N; i++) { sum += a[i]; }
-    end = (double)clock() / CLOCKS_PER_SEC;
-    PRINT_RES(1, sum, (end - start) * 1000);
+    x->sum = sum;
+}
 
-    // --- Unroll Factor 2 ---
-    sum = 0;
-    start = (double)clock() / CLOCKS_PER_SEC;
+// --- Unroll Factor 2 ---
+static void unroll_2(void *p) {
+    sum_ctx_t *x = p; T *a = x->a; T sum = 0;
     for (int i = 0; i < N; i += 2) { sum += a[i] + a[i+1]; }
-    end = (double)clock() / CLOCKS_PER_SEC;
-    PRINT_RES(2, sum, (end - start) * 1000);
+    x->sum = sum;
+}
 
-    // --- Unroll Factor 4 ---
-    sum = 0;
-    start = (double)clock() / CLOCKS_PER_SEC;
+// --- Unroll Factor 4 ---
+static void unroll_4(void *p) {
+    sum_ctx_t *x = p; T *a = x->a; T sum = 0;
     for (int i = 0; i < N; i += 4) { sum += a[i] + a[i+1] + a[i+2] + a[i+3]; }
-    end = (double)clock() / CLOCKS_PER_SEC;
-    PRINT_RES(4, sum, (end - start) * 1000);
-
-    // --- Unroll Factor 8 ---
-    sum = 0;
-    start = (double)clock() / CLOCKS_PER_SEC;
-    for (int i = 0; i < N; i += 8) { 
-        sum += a[i] + a[i+1] + a[i+2] + a[i+3] + a[i+4] + a[i+5] + a[i+6] + a[i+7]; 
+    x->sum = sum;
+}
+
+// --- Unroll Factor 8 ---
+static void unroll_8(void *p) {
+    sum_ctx_t *x = p; T *a = x->a; T sum = 0;
+    for (int i = 0; i < N; i += 8) {
+        sum += a[i] + a[i+1] + a[i+2] + a[i+3] + a[i+4] + a[i+5] + a[i+6] + a[i+7];
     }
-    end = (double)clock() / CLOCKS_PER_SEC;
-    PRINT_RES(8, sum, (end - start) * 1000);
+    x->sum = sum;
+}
 
-    // --- Unroll Factor 16 ---
-    sum = 0;
-    start = (double)clock() / CLOCKS_PER_SEC;
-    for (int i = 0; i < N; i += 16) { 
+// --- Unroll Factor 16 ---
+static void unroll_16(void *p) {
+    sum_ctx_t *x = p; T *a = x->a; T sum = 0;
+    for (int i = 0; i < N; i += 16) {
         sum += a[i] + a[i+1] + a[i+2] + a[i+3] + a[i+4] + a[i+5] + a[i+6] + a[i+7] +
-               a[i+8] + a[i+9] + a[i+10] + a[i+11] + a[i+12] + a[i+13] + a[i+14] + a[i+15]; 
+               a[i+8] + a[i+9] + a[i+10] + a[i+11] + a[i+12] + a[i+13] + a[i+14] + a[i+15];
     }
-    end = (double)clock() / CLOCKS_PER_SEC;
-    PRINT_RES(16, sum, (end - start) * 1000);
+    x->sum = sum;
+}
 
-    // --- Unroll Factor 32 ---
-    sum = 0;
-    start = (double)clock() / CLOCKS_PER_SEC;
-    for (int i = 0; i < N; i += 32) { 
+// --- Unroll Factor 32 ---
+static void unroll_32(void *p) {
+    sum_ctx_t *x = p; T *a = x->a; T sum = 0;
+    for (int i = 0; i < N; i += 32) {
         sum += a[i] + a[i+1] + a[i+2] + a[i+3] + a[i+4] + a[i+5] + a[i+6] + a[i+7] +
                a[i+8] + a[i+9] + a[i+10] + a[i+11] + a[i+12] + a[i+13] + a[i+14] + a[i+15] +
                a[i+16] + a[i+17] + a[i+18] + a[i+19] + a[i+20] + a[i+21] + a[i+22] + a[i+23] +
-               a[i+24] + a[i+25] + a[i+26] + a[i+27] + a[i+28] + a[i+29] + a[i+30] + a[i+31]; 
+               a[i+24] + a[i+25] + a[i+26] + a[i+27] + a[i+28] + a[i+29] + a[i+30] + a[i+31];
+    }
+    x->sum = sum;
+}
+
+// --- Library: independent vector accumulators (simd_reduce.h) ---
+// The ISA is selected in the untimed setup of each case
+static void use_scalar(void *p) { (void)p; reduce_set_isa(REDUCE_ISA_SCALAR); }
+static void use_avx2(void *p)   { (void)p; reduce_set_isa(REDUCE_ISA_AVX2); }
+static void use_avx512(void *p) { (void)p; reduce_set_isa(REDUCE_ISA_AVX512); }
+
+static void lib_sum(void *p) {
+    sum_ctx_t *x = p;
+    x->sum = reduce_sum(x->a, N);
+}
+
+// The other operations of the library, on the same array
+static void lib_sumsq(void *p) { sum_ctx_t *x = p; x->sum = reduce_sumsq(x->a, N); }
+static void lib_max(void *p)   { sum_ctx_t *x = p; x->sum = reduce_max(x->a, N); }
+static void lib_dot(void *p)   { sum_ctx_t *x = p; x->sum = reduce_dot(x->a, x->a, N); }
+
+int main(int argc, char **argv) {
+    if (bench_init("bench_ex1", &argc, argv) != 0)
+        return 1;
+
+    // 1. Allocate Memory
+    sum_ctx_t ctx;
+    ctx.a = malloc(N * sizeof(T));
+    if (!ctx.a) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
+
+    // 2. Initialize
+    for (int i = 0; i < N; i++) ctx.a[i] = (T)1;
+
+    // 3. One case per unroll factor: N additions, N elements read
+    struct { const char *name; void (*fn)(void *); } variants[] = {
+        {"unroll_1", unroll_1},   {"unroll_2", unroll_2},   {"unroll_4", unroll_4},
+        {"unroll_8", unroll_8},   {"unroll_16", unroll_16}, {"unroll_32", unroll_32},
+    };
+    for (int v = 0; v < 6; v++) {
+        bench_case_t c = {variants[v].name, NULL, variants[v].fn, &ctx, 0,
+                          (double)N, (double)N * sizeof(T)};
+        bench_add(&c);
     }
-    end = (double)clock() / CLOCKS_PER_SEC;
-    PRINT_RES(32, sum, (end - start) * 1000);
 
-    free(a);
+    // 4. The library sum on every path this CPU has, then its other operations
+    //    (reduce_sum last: the sum printed below is checked against N)
+    reduce_isa_t best = reduce_isa_max();
+    struct { const char *name; void (*setup)(void *); reduce_isa_t isa; } paths[] = {
+        {"reduce_sum scalar", use_scalar, REDUCE_ISA_SCALAR},
+        {"reduce_sum avx2",   use_avx2,   REDUCE_ISA_AVX2},
+        {"reduce_sum avx512", use_avx512, REDUCE_ISA_AVX512},
+    };
+    for (int v = 0; v < 3; v++) {
+        if (paths[v].isa > best) continue;
+        bench_case_t c = {paths[v].name, paths[v].setup, lib_sum, &ctx, 0,
+                          (double)N, (double)N * sizeof(T)};
+        bench_add(&c);
+    }
+    void (*best_setup)(void *) = paths[best].setup;
+    bench_case_t ops[] = {
+        {"reduce_sumsq", best_setup, lib_sumsq, &ctx, 0, 2.0 * N, (double)N * sizeof(T)},
+        {"reduce_max",   best_setup, lib_max,   &ctx, 0, (double)N, (double)N * sizeof(T)},
+        {"reduce_dot",   best_setup, lib_dot,   &ctx, 0, 2.0 * N, 2.0 * N * sizeof(T)},
+        {"reduce_sum",   best_setup, lib_sum,   &ctx, 0, (double)N, (double)N * sizeof(T)},
+    };
+    for (int v = 0; v < 4; v++) bench_add(&ops[v]);
+
+    printf("Benchmarking N = %d elements...\n", N);
+    bench_run();
+
+    // Helper macro to print based on type
+    // We cast to double for floats, and long long for ints to handle everything safely
+    #ifdef IS_INT
+        #define PRINT_RES(s) printf("Last sum = %lld (expected %d)\n", (long long)s, N)
+    #else
+        #define PRINT_RES(s) printf("Last sum = %.1f (expected %d)\n", (double)s, N)
+    #endif
+    PRINT_RES(ctx.sum);
+
+    free(ctx.a);
     return 0;
 }
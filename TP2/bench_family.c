@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_harness.h"
+#include "kernel_family.h"
+
+// Compile: gcc -O2 -I../common -o bench_family bench_family.c ../common/kernel_family.c
+//              ../common/simd_reduce.c ../common/bench_harness.c ../common/perf_counters.c -lm -pthread
+// Usage:   ./bench_family [--filter=sum_d_] [--reps=MIN:MAX] [--csv=FILE] ... (see bench_harness.h)
+//
+// Every (type, unroll, accumulators, ISA) sum kernel of the simd_reduce.h
+// sum ladder in one binary -- no -DT rebuild per type -- then the fastest
+// variant of each type on this CPU (kfam_sum() makes the same choice in
+// production with its own short tuning run).
+
+#define N (1 << 22)
+
+typedef struct {
+    const kfam_variant_t *v;
+    const void *a;
+    double sum;
+} family_ctx_t;
+
+static void run_variant(void *p) {
+    family_ctx_t *x = p;
+    x->sum = x->v->fn(x->a, N);
+}
+
+int main(int argc, char **argv) {
+    // 240 cases: keep each one short
+    bench_defaults(1, 3, 10, 2.0);
+    if (bench_init("bench_family", &argc, argv) != 0)
+        return 1;
+
+    // One array of ones per type
+    void *arrays[KFAM_NTYPES];
+    for (int t = 0; t < KFAM_NTYPES; t++) {
+        arrays[t] = malloc(N * kfam_type_size(t));
+        if (!arrays[t]) {
+            fprintf(stderr, "Memory allocation failed\n");
+            return 1;
+        }
+        kfam_fill(t, arrays[t], N, 1);
+    }
+
+    int nv = reduce_sum_variant_count();
+    family_ctx_t *ctx = calloc(nv, sizeof(family_ctx_t));
+    for (int v = 0; v < nv; v++) {
+        const kfam_variant_t *k = reduce_sum_variant(v);
+        if (!kfam_supported(k)) continue;
+        ctx[v] = (family_ctx_t){k, arrays[k->type], 0.0};
+        bench_case_t c = {k->name, NULL, run_variant, &ctx[v], 0,
+                          (double)N, (double)N * kfam_type_size(k->type)};
+        bench_add(&c);
+    }
+
+    printf("Benchmarking N = %d elements, %d variants, best ISA %s...\n",
+           N, nv, reduce_isa_name(reduce_isa_max()));
+    bench_run();
+
+    // Fastest variant of each type (medians), and a check of its sum
+    printf("\n| %-10s | %-22s | %-10s | %-8s | %-12s |\n",
+           "Type", "Fastest variant", "Median (s)", "GB/s", "Sum");
+    for (int t = 0; t < KFAM_NTYPES; t++) {
+        const bench_result_t *win = NULL;
+        int win_v = -1;
+        for (int v = 0; v < nv; v++) {
+            const bench_result_t *r;
+            if (!ctx[v].v || ctx[v].v->type != (kfam_type_t)t) continue;
+            if (!(r = bench_result(ctx[v].v->name))) continue;
+            if (!win || r->median < win->median) { win = r; win_v = v; }
+        }
+        if (!win) continue;
+        printf("| %-10s | %-22s | %-10.6f | %-8.2f | %-12.0f |\n", kfam_type_name(t),
+               win->name, win->median, win->gbps, ctx[win_v].sum);
+    }
+    printf("(short sums wrap in 16 bits, like  short sum  does)\n");
+
+    for (int t = 0; t < KFAM_NTYPES; t++) free(arrays[t]);
+    free(ctx);
+    return 0;
+}
@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+#include "bench_harness.h"
+
+// Compile: gcc -O2 -I../common -o bench_ops bench_ops.c ../common/bench_harness.c
+//              ../common/perf_counters.c -lm
+// Usage:   ./bench_ops [--filter=fma] [--reps=MIN:MAX] [--csv=FILE] ... (see bench_harness.h)
+//
+// ex2_orig.c / ex2_opt.c time two dependent chains of one operation.
+// This runs K = 1 .. 12 independent chains of each core operation
+// (add, mul, fma, div, sqrt, and the sin / cos / sqrt of TP4/ex3.c):
+//
+//   K = 1       every op waits for the previous one   -> latency
+//   K large     ops overlap until the ports are full  -> reciprocal throughput
+//   latency / reciprocal throughput = ops in flight   -> accumulators a
+//                                                        kernel needs
+//
+// Scalar double ops; a vector op of W lanes does W of them per issue.
+// sqrt and sin feed back through "+ 1.0" (to stay away from the fast
+// paths at 1 and 0): the add latency is taken off their latency.
+
+#define N_ADD  20000000L
+#define N_DIV   5000000L
+#define N_LIBM  1000000L
+
+// Keeps each chain in its own register: no vectorization across chains
+#if defined(__x86_64__) || defined(__i386__)
+#define KEEP(v) __asm__ volatile("" : "+x"(v))
+#define FMA_ATTR __attribute__((target("fma")))
+#else
+#define KEEP(v) ((void)0)
+#define FMA_ATTR
+#endif
+
+/* ===== Kernels: K chains, unrolled by hand ===== */
+#define REP1(X)  X(0)
+#define REP2(X)  REP1(X) X(1)
+#define REP4(X)  REP2(X) X(2) X(3)
+#define REP6(X)  REP4(X) X(4) X(5)
+#define REP8(X)  REP6(X) X(6) X(7)
+#define REP10(X) REP8(X) X(8) X(9)
+#define REP12(X) REP10(X) X(10) X(11)
+
+#define DECL(n) double x##n = 1.0 + 0.01 * n;
+#define SUM(n)  + x##n
+
+#define STEP_add(n)  x##n = x##n + c;                   KEEP(x##n);
+#define STEP_mul(n)  x##n = x##n * c;                   KEEP(x##n);
+#define STEP_fma(n)  x##n = __builtin_fma(x##n, c, 1e-7); KEEP(x##n);
+#define STEP_div(n)  x##n = c / x##n;                   KEEP(x##n);
+#define STEP_sqrt(n) x##n = sqrt(x##n) + 1.0;           KEEP(x##n);
+#define STEP_sin(n)  x##n = sin(x##n) + 1.0;            KEEP(x##n);
+#define STEP_cos(n)  x##n = cos(x##n);                  KEEP(x##n);
+
+#define CHAIN_KERNEL(op, K, ATTR)                                   \
+    ATTR static double op##_k##K(long iters, double c) {            \
+        REP##K(DECL)                                                \
+        for (long i = 0; i < iters; i++) { REP##K(STEP_##op) }      \
+        (void)c;                                                    \
+        return 0.0 REP##K(SUM);                                     \
+    }
+
+#define CHAIN_KERNELS(op, ATTR)                                     \
+    CHAIN_KERNEL(op, 1, ATTR)  CHAIN_KERNEL(op, 2, ATTR)            \
+    CHAIN_KERNEL(op, 4, ATTR)  CHAIN_KERNEL(op, 6, ATTR)            \
+    CHAIN_KERNEL(op, 8, ATTR)  CHAIN_KERNEL(op, 10, ATTR)           \
+    CHAIN_KERNEL(op, 12, ATTR)
+
+#define CHAIN_ROW(op) {op##_k1, op##_k2, op##_k4, op##_k6, op##_k8, op##_k10, op##_k12}
+
+CHAIN_KERNELS(add, )
+CHAIN_KERNELS(mul, )
+CHAIN_KERNELS(fma, FMA_ATTR)
+CHAIN_KERNELS(div, )
+CHAIN_KERNELS(sqrt, )
+CHAIN_KERNELS(sin, )
+CHAIN_KERNELS(cos, )
+
+#define NK 7
+static const int chains[NK] = {1, 2, 4, 6, 8, 10, 12};
+
+typedef double (*chain_fn)(long iters, double c);
+
+typedef struct {
+    const char *name;
+    long        iters;
+    double      c;
+    int         plus_add;   // chain includes a "+ 1.0"
+    int         needs_fma;
+    chain_fn    fn[NK];
+} op_t;
+
+static const op_t ops[] = {
+    {"add",  N_ADD,  1e-7,      0, 0, CHAIN_ROW(add)},
+    {"mul",  N_ADD,  0.9999999, 0, 0, CHAIN_ROW(mul)},
+    {"fma",  N_ADD,  0.9999999, 0, 1, CHAIN_ROW(fma)},
+    {"div",  N_DIV,  2.5,       0, 0, CHAIN_ROW(div)},
+    {"sqrt", N_DIV,  0.0,       1, 0, CHAIN_ROW(sqrt)},
+    {"sin",  N_LIBM, 0.0,       1, 0, CHAIN_ROW(sin)},
+    {"cos",  N_LIBM, 0.0,       0, 0, CHAIN_ROW(cos)},
+};
+#define NOPS (int)(sizeof(ops) / sizeof(ops[0]))
+
+typedef struct {
+    const op_t *op;
+    int k;
+    double sink;
+} ops_ctx_t;
+
+static void run_chains(void *p) {
+    ops_ctx_t *x = p;
+    x->sink = x->op->fn[x->k](x->op->iters, x->op->c);
+}
+
+/* ===== Clock estimate: dependent imul, 3 cycles on x86 cores ===== */
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double estimate_ghz(void) {
+#if defined(__x86_64__)
+    const long iters = 50000000L;
+    double best = 0.0;
+    for (int rep = 0; rep < 3; rep++) {
+        long x = 1;
+        double t0 = now_sec();
+        for (long i = 0; i < iters; i++)
+            __asm__ volatile("imul %0, %0\n\timul %0, %0\n\timul %0, %0\n\timul %0, %0"
+                             : "+r"(x));
+        double ghz = 4.0 * 3.0 * iters / (now_sec() - t0) * 1e-9;
+        if (ghz > best) best = ghz;
+    }
+    return best;
+#else
+    return 0.0;
+#endif
+}
+
+// "12.3 (4.1)" : ns, and cycles when the clock is known
+static void fmt_time(char *buf, size_t len, double ns, double ghz) {
+    if (ghz > 0) snprintf(buf, len, "%6.2f (%5.1f)", ns, ns * ghz);
+    else         snprintf(buf, len, "%6.2f", ns);
+}
+
+int main(int argc, char **argv) {
+    bench_defaults(1, 3, 10, 1.0);
+    if (bench_init("bench_ops", &argc, argv) != 0)
+        return 1;
+
+    int have_fma = 1;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    have_fma = __builtin_cpu_supports("fma");
+#endif
+
+    static char names[NOPS][NK][16];
+    static ops_ctx_t ctx[NOPS][NK];
+    for (int o = 0; o < NOPS; o++) {
+        if (ops[o].needs_fma && !have_fma) continue;
+        for (int k = 0; k < NK; k++) {
+            snprintf(names[o][k], sizeof(names[o][k]), "%s k=%d", ops[o].name, chains[k]);
+            ctx[o][k] = (ops_ctx_t){&ops[o], k, 0.0};
+            bench_case_t c = {names[o][k], NULL, run_chains, &ctx[o][k], 0,
+                              (double)ops[o].iters * chains[k], 0};
+            bench_add(&c);
+        }
+    }
+
+    double ghz = estimate_ghz();
+    if (ghz > 0) printf("Clock estimate: %.2f GHz (dependent imul chain)\n", ghz);
+    else         printf("Clock estimate: n/a on this architecture, times in ns only\n");
+    bench_run();
+
+    // ns per op for every chain count (NAN when filtered out)
+    double t[NOPS][NK];
+    for (int o = 0; o < NOPS; o++)
+        for (int k = 0; k < NK; k++) {
+            const bench_result_t *r = names[o][k][0] ? bench_result(names[o][k]) : NULL;
+            t[o][k] = r ? r->median / ((double)ops[o].iters * chains[k]) * 1e9 : NAN;
+        }
+    double add_lat = t[0][0];
+
+    printf("\nns per op%s by number of independent chains:\n", ghz > 0 ? " (cycles)" : "");
+    printf("| %-5s |", "Op");
+    for (int k = 0; k < NK; k++) printf("    K=%-2d       |", chains[k]);
+    printf("\n");
+    for (int o = 0; o < NOPS; o++) {
+        if (isnan(t[o][0])) continue;
+        printf("| %-5s |", ops[o].name);
+        for (int k = 0; k < NK; k++) {
+            char buf[32];
+            fmt_time(buf, sizeof(buf), t[o][k], ghz);
+            printf(" %-13s |", isnan(t[o][k]) ? "-" : buf);
+        }
+        printf("\n");
+    }
+
+    printf("\n| %-5s | %-14s | %-14s | %-13s | %-15s |\n",
+           "Op", "Latency", "Recip. tput", "Ops in flight", "Chains to peak");
+    for (int o = 0; o < NOPS; o++) {
+        if (isnan(t[o][0])) continue;
+        double best = t[o][0];
+        for (int k = 1; k < NK; k++)
+            if (t[o][k] < best) best = t[o][k];
+        int need = chains[NK - 1];
+        for (int k = NK - 1; k >= 0; k--)
+            if (t[o][k] <= 1.05 * best) need = chains[k];
+
+        double lat = t[o][0] - (ops[o].plus_add && !isnan(add_lat) ? add_lat : 0.0);
+        char l[32], r[32];
+        fmt_time(l, sizeof(l), lat, ghz);
+        fmt_time(r, sizeof(r), best, ghz);
+        printf("| %-5s | %-14s | %-14s | %13.1f | %15d |\n", ops[o].name, l, r, lat / best, need);
+    }
+    printf("(Chains to peak: fewest K within 5%% of the best time per op -- the number of\n"
+           " independent accumulators a loop of that op needs; x W lanes for SIMD code)\n");
+    return 0;
+}
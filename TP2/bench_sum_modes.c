@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+
+#include "bench_harness.h"
+#include "repro_sum.h"
+
+// Compile: gcc -O2 -fopenmp -I../common -o bench_sum_modes bench_sum_modes.c
+//              ../common/repro_sum.c ../common/bench_harness.c ../common/perf_counters.c -lm
+// Usage:   ./bench_sum_modes [--reps=MIN:MAX] [--json=FILE] [--csv=FILE] ... (see bench_harness.h)
+//
+// Throughput of every summation mode (serial and OpenMP) against the
+// plain sum, then the OpenMP result of each mode for 1..64 threads:
+// only the binned mode (and the fixed-tree pairwise one) keeps the
+// same bits for every thread count.
+
+#define N (1 << 24)
+
+typedef struct {
+    double *a;
+    sum_mode_t mode;
+    double result;
+} sum_ctx_t;
+
+static void run_serial(void *p) { sum_ctx_t *x = p; x->result = sum_array(x->a, N, x->mode); }
+static void run_omp(void *p)    { sum_ctx_t *x = p; x->result = sum_array_omp(x->a, N, x->mode); }
+
+int main(int argc, char **argv) {
+    if (bench_init("sum_modes", &argc, argv) != 0)
+        return 1;
+
+    double *a = malloc(N * sizeof(double));
+    if (!a) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
+
+    // Both signs, magnitudes over 2^-20 .. 2^20: plenty of cancellation
+    srand(42);
+    for (int i = 0; i < N; i++) {
+        double m = (double)rand() / RAND_MAX - 0.5;
+        a[i] = ldexp(m, rand() % 41 - 20);
+    }
+
+    int threads = omp_get_max_threads();
+    sum_ctx_t ctx[2 * SUM_NMODES];
+    char names[2 * SUM_NMODES][32];
+
+    for (int m = 0; m < SUM_NMODES; m++) {
+        for (int par = 0; par < 2; par++) {
+            int c = 2 * m + par;
+            ctx[c] = (sum_ctx_t){a, (sum_mode_t)m, 0.0};
+            snprintf(names[c], sizeof(names[c]), "%s %s", sum_mode_name(m), par ? "omp" : "serial");
+            bench_case_t bc = {names[c], NULL, par ? run_omp : run_serial, &ctx[c],
+                               par ? threads : 1, (double)N, (double)N * sizeof(double)};
+            bench_add(&bc);
+        }
+    }
+
+    printf("Summing N = %d doubles | Threads: %d\n", N, threads);
+    bench_run();
+
+    // Cost relative to the plain sum (medians)
+    const bench_result_t *base[2] = {bench_result("plain serial"), bench_result("plain omp")};
+    printf("\n| %-10s | %-14s | %-14s |\n", "Mode", "x plain serial", "x plain omp");
+    for (int m = 0; m < SUM_NMODES; m++) {
+        const bench_result_t *r[2] = {bench_result(names[2 * m]), bench_result(names[2 * m + 1])};
+        printf("| %-10s |", sum_mode_name(m));
+        for (int par = 0; par < 2; par++) {
+            if (r[par] && base[par]) printf(" %14.2f |", r[par]->median / base[par]->median);
+            else printf(" %-14s |", "n/a");
+        }
+        printf("\n");
+    }
+
+    // Reproducibility across thread counts
+    int counts[] = {1, 2, 3, 8, 64};
+    printf("\n| %-10s | %-24s | %-24s | %s\n", "Mode", "1 thread", "64 threads", "same bits 1..64?");
+    for (int m = 0; m < SUM_NMODES; m++) {
+        double ref = 0.0, last = 0.0;
+        int same = 1;
+        for (int c = 0; c < 5; c++) {
+            omp_set_num_threads(counts[c]);
+            double s = sum_array_omp(a, N, (sum_mode_t)m);
+            if (c == 0) ref = s;
+            else if (memcmp(&s, &ref, sizeof(s)) != 0) same = 0;
+            last = s;
+        }
+        printf("| %-10s | %24.17g | %24.17g | %s\n", sum_mode_name(m), ref, last, same ? "yes" : "no");
+    }
+    omp_set_num_threads(threads);
+
+    free(a);
+    return 0;
+}
@@ -1,6 +1,18 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
+
+#include "simd_reduce.h"
+#include "repro_sum.h"
+#include "bench_harness.h"
+
+// Compile: gcc -O2 -I../common -DT=float -o ex1_generic ex1_generic.c ../common/simd_reduce.c
+//              ../common/repro_sum.c ../common/bench_harness.c ../common/perf_counters.c -lm
+//          (-DT=int -DIS_INT for the integer version)
+// Usage:   ./ex1_generic [--reps=MIN:MAX] [--json=FILE] [--csv=FILE] ... (see bench_harness.h)
+//
+// The type stays a compile-time choice on purpose: the exercise is to rebuild
+// with another -DT and compare the generated code.  bench_family.c runs every
+// type (and every unroll/accumulator/ISA shape) from one binary.
 
 // Default to float if no type is given
 #ifndef T
@@ -16,7 +28,42 @@
 
 #define N 10000000
 
-int main() {
+typedef struct {
+    T *a;
+    T sum;
+    double comp;
+} sum_ctx_t;
+
+static void run_plain(void *p) {
+    sum_ctx_t *c = p;
+    T sum = 0;
+
+    // Perform summation
+    for (int i = 0; i < N; i++) {
+        sum += c->a[i];
+    }
+    c->sum = sum;
+}
+
+// Same sum with the library: independent vector accumulators
+static void run_library(void *p) {
+    sum_ctx_t *c = p;
+    c->sum = reduce_sum(c->a, N);
+}
+
+#ifndef IS_INT
+// A float accumulator stops growing at 2^24 (x + 1 == x); the
+// compensated sum keeps the lost low bits and does not saturate
+static void run_neumaier(void *p) {
+    sum_ctx_t *c = p;
+    c->comp = _Generic((c->a), float *: sum_array_f, default: sum_array)(c->a, N, SUM_NEUMAIER);
+}
+#endif
+
+int main(int argc, char **argv) {
+    if (bench_init("tp2_ex1_generic", &argc, argv) != 0)
+        return 1;
+
     // 1. Allocate memory dynamically using generic Type T
     T *a = malloc(N * sizeof(T));
 
@@ -26,27 +73,40 @@ int main() {
         return 1;
     }
 
-    T sum = 0;
-    double start, end;
-
     // Initialize the array
     for (int i = 0; i < N; i++) {
         a[i] = (T)1; // Cast 1 to the correct type
     }
 
-    // Start timing
-    start = (double)clock() / CLOCKS_PER_SEC;
+    // One context per case, so every case keeps its own result
+    sum_ctx_t plain = {a, 0, 0.0}, lib = {a, 0, 0.0};
+    bench_case_t cases[] = {
+        {"plain",   NULL, run_plain,   &plain, 0, (double)N, (double)N * sizeof(T)},
+        {"library", NULL, run_library, &lib,   0, (double)N, (double)N * sizeof(T)},
+    };
+    bench_add(&cases[0]);
+    bench_add(&cases[1]);
+#ifndef IS_INT
+    sum_ctx_t comp = {a, 0, 0.0};
+    bench_case_t neumaier = {"neumaier", NULL, run_neumaier, &comp, 0, 4.0 * N, (double)N * sizeof(T)};
+    bench_add(&neumaier);
+#endif
+    bench_run();
 
-    // Perform summation
-    for (int i = 0; i < N; i++) {
-        sum += a[i];
+    // Print results (median times) using our smart macro
+    const bench_result_t *r;
+    if ((r = bench_result("plain")))
+        PRINT_RES(plain.sum, r->median * 1000);
+    if ((r = bench_result("library"))) {
+        printf("Library (%s): ", reduce_isa_name(reduce_isa()));
+        PRINT_RES(lib.sum, r->median * 1000);
     }
-
-    // End timing
-    end = (double)clock() / CLOCKS_PER_SEC;
-
-    // Print results using our smart macro
-    PRINT_RES(sum, (end - start) * 1000);
+#ifndef IS_INT
+    if ((r = bench_result("neumaier"))) {
+        printf("Compensated (Neumaier): ");
+        PRINT_RES(comp.comp, r->median * 1000);
+    }
+#endif
 
     // Free the allocated memory
     free(a);
@@ -1,8 +1,29 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
+#include <omp.h>
+
+#include "scaling.h"
+#include "scan.h"
 
 #define N 512 // Matrix size
 
+// Length of the stand-alone scan timing, well above SCAN_PAR_MIN
+#ifndef NOISE_LONG
+#define NOISE_LONG (1 << 24)
+#endif
+
+// Compile: gcc -O2 -fopenmp -I../common -o ex4 ex4.c ../common/scan.c ../common/scaling.c -lm
+// Usage:   ./ex4 [--scaling[=1,2,4,8]]
+//
+// The noise is an affine recurrence, so it is produced by the scan
+// engine (scan.h) and checked against generate_noise().  With N = 512
+// values the scan stays below SCAN_PAR_MIN and runs on one thread (in
+// SIMD steps); the last lines time the same recurrence over NOISE_LONG
+// values, where the threaded passes engage.
+// --scaling times the serial noise and the parallel matrix parts
+// across thread counts and fits Amdahl / Gustafson (scaling.h).
+
 /* ===== Generate noise (Strictly Sequential) ===== */
 void generate_noise(double *noise) {
     noise[0] = 1.0;
@@ -11,8 +32,14 @@ void generate_noise(double *noise) {
     }
 }
 
+/* ===== Same noise as a parallel scan ===== */
+void generate_noise_scan(double *noise) {
+    scan_affine(noise, N, 1.0, 1.0000001, 0.0);
+}
+
 /* ===== Matrices Initialization ===== */
 void init_matrix(double *M) {
+    #pragma omp parallel for
     for (int i = 0; i < N*N; i++) {
         M[i] = (double)(i % 100) * 0.01;
     }
@@ -20,6 +47,7 @@ void init_matrix(double *M) {
 
 /* ===== Matrix Multiplication (Highly Parallelizable) ===== */
 void matmul(double *A, double *B, double *C, double *noise) {
+    #pragma omp parallel for
     for (int i = 0; i < N; i++) {
         for (int j = 0; j < N; j++) {
             double sum = noise[i];
@@ -31,7 +59,34 @@ void matmul(double *A, double *B, double *C, double *noise) {
     }
 }
 
-int main() {
+/* ===== Both parts, tagged for the scaling sweep ===== */
+typedef struct {
+    double *A, *B, *C, *noise;
+} parts_t;
+
+static void run_parts(void *arg) {
+    parts_t *m = arg;
+    scale_region_t r;
+
+    // N elements: below SCAN_PAR_MIN the scan stays on one thread
+    scale_begin(&r, "noise", SCALE_SERIAL);
+    generate_noise_scan(m->noise);
+    scale_end(&r);
+
+    scale_begin(&r, "init_matrix", SCALE_PARALLEL);
+    init_matrix(m->A);
+    init_matrix(m->B);
+    scale_end(&r);
+
+    scale_begin(&r, "matmul", SCALE_PARALLEL);
+    matmul(m->A, m->B, m->C, m->noise);
+    scale_end(&r);
+}
+
+int main(int argc, char **argv) {
+    if (scale_parse_args(&argc, argv) != 0)
+        return 1;
+
     // Allocate memory
     double *A = malloc(N * N * sizeof(double));
     double *B = malloc(N * N * sizeof(double));
@@ -43,8 +98,20 @@ int main() {
         return 1;
     }
 
-    // 1. Sequential Part
-    generate_noise(noise);
+    if (scale_enabled()) {
+        parts_t m = {A, B, C, noise};
+        scale_sweep(run_parts, &m);
+        printf("C[0] = %f\n", C[0]);
+        scale_report(stdout);
+        free(A);
+        free(B);
+        free(C);
+        free(noise);
+        return 0;
+    }
+
+    // 1. Formerly sequential part
+    generate_noise_scan(noise);
 
     // 2. Parallelizable Parts
     init_matrix(A);
@@ -53,6 +120,29 @@ int main() {
 
     printf("C[0] = %f\n", C[0]);
 
+    double ref[N], err = 0.0;
+    generate_noise(ref);
+    for (int i = 0; i < N; i++) {
+        double d = fabs(noise[i] - ref[i]) / fabs(ref[i]);
+        if (d > err) err = d;
+    }
+    printf("Noise max rel. error vs generate_noise: %.2e\n", err);
+
+    // The scan where it runs in parallel: NOISE_LONG values
+    double *big = malloc((size_t)NOISE_LONG * sizeof(double));
+    if (big != NULL) {
+        double t0 = omp_get_wtime();
+        scan_affine_serial(big, NOISE_LONG, 1.0, 1.0000001, 0.0);
+        double t_serial = omp_get_wtime() - t0;
+        t0 = omp_get_wtime();
+        scan_affine(big, NOISE_LONG, 1.0, 1.0000001, 0.0);
+        double t_scan = omp_get_wtime() - t0;
+        printf("Noise x %d: serial %.4f s, scan on %d threads %.4f s (x%.2f), max rel. error %.2e\n",
+               NOISE_LONG, t_serial, omp_get_max_threads(), t_scan, t_serial / t_scan,
+               scan_check(big, NOISE_LONG, 1.0, 1.0000001, 0.0));
+        free(big);
+    }
+
     // Cleanup
     free(A);
     free(B);
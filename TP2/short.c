@@ -1,80 +1,167 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
+
+#include "simd_reduce.h"
+#include "bench_harness.h"
+
+// Compile: gcc -O2 -I../common -o short short.c ../common/simd_reduce.c
+//              ../common/bench_harness.c ../common/perf_counters.c -lm
+// Usage:   ./short [--reps=MIN:MAX] [--json=FILE] [--csv=FILE] ... (see bench_harness.h)
 
 #define N 10000000 // 100 Million
 
-int main() {
-    // 1. Array is SHORT (2 bytes)
-    short *a = malloc(N * sizeof(short));
-    
-    // 2. Accumulator is LONG (8 bytes) to prevent overflow
-    long long sum = 0;
-    
-    double start, end;
+typedef struct {
+    short *a;
+    signed char *a8;
+    int *a32;
+    int isa;           // library cases: path to select before the run
+    long long sum;     // result of the last run
+    char name[24];
+} short_ctx_t;
 
-    printf("Initializing %d shorts...\n", N);
-    for (int i = 0; i < N; i++) a[i] = 1;
+// 2. Accumulator is LONG (8 bytes) to prevent overflow
 
-    // --- Unroll Factor 1 ---
-    sum = 0;
-    start = (double)clock() / CLOCKS_PER_SEC;
-    for (int i = 0; i < N; i++) { 
-        sum += a[i]; 
+// --- Unroll Factor 1 ---
+static void run_u1(void *p) {
+    short_ctx_t *c = p;
+    short *a = c->a;
+    long long sum = 0;
+    for (int i = 0; i < N; i++) {
+        sum += a[i];
     }
-    end = (double)clock() / CLOCKS_PER_SEC;
-    printf("U 1 : Sum = %lld | Time = %.4f ms\n", sum, (end - start) * 1000);
-
-    // --- Unroll Factor 2 ---
-    sum = 0;
-    start = (double)clock() / CLOCKS_PER_SEC;
-    for (int i = 0; i < N; i += 2) { 
-        sum += a[i] + a[i+1]; 
+    c->sum = sum;
+}
+
+// --- Unroll Factor 2 ---
+static void run_u2(void *p) {
+    short_ctx_t *c = p;
+    short *a = c->a;
+    long long sum = 0;
+    for (int i = 0; i < N; i += 2) {
+        sum += a[i] + a[i+1];
     }
-    end = (double)clock() / CLOCKS_PER_SEC;
-    printf("U 2 : Sum = %lld | Time = %.4f ms\n", sum, (end - start) * 1000);
-
-    // --- Unroll Factor 4 ---
-    sum = 0;
-    start = (double)clock() / CLOCKS_PER_SEC;
-    for (int i = 0; i < N; i += 4) { 
-        sum += a[i] + a[i+1] + a[i+2] + a[i+3]; 
+    c->sum = sum;
+}
+
+// --- Unroll Factor 4 ---
+static void run_u4(void *p) {
+    short_ctx_t *c = p;
+    short *a = c->a;
+    long long sum = 0;
+    for (int i = 0; i < N; i += 4) {
+        sum += a[i] + a[i+1] + a[i+2] + a[i+3];
     }
-    end = (double)clock() / CLOCKS_PER_SEC;
-    printf("U 4 : Sum = %lld | Time = %.4f ms\n", sum, (end - start) * 1000);
-
-    // --- Unroll Factor 8 ---
-    sum = 0;
-    start = (double)clock() / CLOCKS_PER_SEC;
-    for (int i = 0; i < N; i += 8) { 
-        sum += a[i] + a[i+1] + a[i+2] + a[i+3] + 
-               a[i+4] + a[i+5] + a[i+6] + a[i+7]; 
+    c->sum = sum;
+}
+
+// --- Unroll Factor 8 ---
+static void run_u8(void *p) {
+    short_ctx_t *c = p;
+    short *a = c->a;
+    long long sum = 0;
+    for (int i = 0; i < N; i += 8) {
+        sum += a[i] + a[i+1] + a[i+2] + a[i+3] +
+               a[i+4] + a[i+5] + a[i+6] + a[i+7];
     }
-    end = (double)clock() / CLOCKS_PER_SEC;
-    printf("U 8 : Sum = %lld | Time = %.4f ms\n", sum, (end - start) * 1000);
+    c->sum = sum;
+}
 
-    // --- Unroll Factor 16 ---
-    sum = 0;
-    start = (double)clock() / CLOCKS_PER_SEC;
-    for (int i = 0; i < N; i += 16) { 
+// --- Unroll Factor 16 ---
+static void run_u16(void *p) {
+    short_ctx_t *c = p;
+    short *a = c->a;
+    long long sum = 0;
+    for (int i = 0; i < N; i += 16) {
         sum += a[i] + a[i+1] + a[i+2] + a[i+3] + a[i+4] + a[i+5] + a[i+6] + a[i+7] +
-               a[i+8] + a[i+9] + a[i+10] + a[i+11] + a[i+12] + a[i+13] + a[i+14] + a[i+15]; 
+               a[i+8] + a[i+9] + a[i+10] + a[i+11] + a[i+12] + a[i+13] + a[i+14] + a[i+15];
     }
-    end = (double)clock() / CLOCKS_PER_SEC;
-    printf("U 16: Sum = %lld | Time = %.4f ms\n", sum, (end - start) * 1000);
+    c->sum = sum;
+}
 
-    // --- Unroll Factor 32 ---
-    sum = 0;
-    start = (double)clock() / CLOCKS_PER_SEC;
-    for (int i = 0; i < N; i += 32) { 
+// --- Unroll Factor 32 ---
+static void run_u32(void *p) {
+    short_ctx_t *c = p;
+    short *a = c->a;
+    long long sum = 0;
+    for (int i = 0; i < N; i += 32) {
         sum += a[i] + a[i+1] + a[i+2] + a[i+3] + a[i+4] + a[i+5] + a[i+6] + a[i+7] +
                a[i+8] + a[i+9] + a[i+10] + a[i+11] + a[i+12] + a[i+13] + a[i+14] + a[i+15] +
                a[i+16] + a[i+17] + a[i+18] + a[i+19] + a[i+20] + a[i+21] + a[i+22] + a[i+23] +
-               a[i+24] + a[i+25] + a[i+26] + a[i+27] + a[i+28] + a[i+29] + a[i+30] + a[i+31]; 
+               a[i+24] + a[i+25] + a[i+26] + a[i+27] + a[i+28] + a[i+29] + a[i+30] + a[i+31];
+    }
+    c->sum = sum;
+}
+
+// --- Library: widening SIMD sum (vpmaddwd into int32, spilled to int64) ---
+static void select_isa(void *p) {
+    reduce_set_isa((reduce_isa_t)((short_ctx_t *)p)->isa);
+}
+
+static void run_wsum(void *p)   { short_ctx_t *c = p; c->sum = reduce_wsum(c->a, N); }
+static void run_wsum8(void *p)  { short_ctx_t *c = p; c->sum = reduce_wsum(c->a8, N); }
+static void run_wsum32(void *p) { short_ctx_t *c = p; c->sum = reduce_wsum(c->a32, N); }
+
+int main(int argc, char **argv) {
+    if (bench_init("tp2_short", &argc, argv) != 0)
+        return 1;
+
+    // 1. Array is SHORT (2 bytes)
+    short *a = malloc(N * sizeof(short));
+
+    // Same widening sums on 1-byte and 4-byte counts (wsum of int8 / int32)
+    signed char *a8 = malloc(N * sizeof(signed char));
+    int *a32 = malloc(N * sizeof(int));
+    if (!a || !a8 || !a32) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
+
+    printf("Initializing %d shorts...\n", N);
+    for (int i = 0; i < N; i++) { a[i] = 1; a8[i] = 1; a32[i] = 1; }
+
+    static short_ctx_t ctx[16];
+    int n_ctx = 0;
+    void (*unrolled[])(void *) = {run_u1, run_u2, run_u4, run_u8, run_u16, run_u32};
+    int factors[] = {1, 2, 4, 8, 16, 32};
+
+    for (int u = 0; u < 6; u++) {
+        short_ctx_t *c = &ctx[n_ctx++];
+        c->a = a;
+        snprintf(c->name, sizeof(c->name), "U %d", factors[u]);
+        bench_case_t bc = {c->name, NULL, unrolled[u], c, 0, (double)N, (double)N * sizeof(short)};
+        bench_add(&bc);
+    }
+    for (int isa = REDUCE_ISA_SCALAR; isa <= (int)reduce_isa_max(); isa++) {
+        short_ctx_t *c = &ctx[n_ctx++];
+        c->a = a;
+        c->isa = isa;
+        snprintf(c->name, sizeof(c->name), "W %s", reduce_isa_name((reduce_isa_t)isa));
+        bench_case_t bc = {c->name, select_isa, run_wsum, c, 0, (double)N, (double)N * sizeof(short)};
+        bench_add(&bc);
+    }
+    short_ctx_t *c8 = &ctx[n_ctx++], *c32 = &ctx[n_ctx++];
+    c8->a8 = a8;
+    c8->isa = reduce_isa_max();
+    snprintf(c8->name, sizeof(c8->name), "W int8");
+    c32->a32 = a32;
+    c32->isa = reduce_isa_max();
+    snprintf(c32->name, sizeof(c32->name), "W int32");
+    bench_case_t b8 = {c8->name, select_isa, run_wsum8, c8, 0, (double)N, (double)N};
+    bench_case_t b32 = {c32->name, select_isa, run_wsum32, c32, 0, (double)N, (double)N * sizeof(int)};
+    bench_add(&b8);
+    bench_add(&b32);
+
+    bench_run();
+
+    // Median times
+    for (int k = 0; k < n_ctx; k++) {
+        const bench_result_t *r = bench_result(ctx[k].name);
+        if (r)
+            printf("%-8s: Sum = %lld | Time = %.4f ms\n", ctx[k].name, ctx[k].sum, r->median * 1000);
     }
-    end = (double)clock() / CLOCKS_PER_SEC;
-    printf("U 32: Sum = %lld | Time = %.4f ms\n", sum, (end - start) * 1000);
 
+    free(a8);
+    free(a32);
     free(a);
     return 0;
 }
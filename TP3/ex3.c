@@ -1,6 +1,12 @@
 #include <stdio.h>
 #include <omp.h>
 
+#include "repro_sum.h"
+
+// Compile: gcc -O2 -fopenmp -I../common -o ex3 ex3.c ../common/repro_sum.c -lm
+
+REPRO_OMP_DECLARE
+
 static long num_steps = 100000000;
 double step;
 
@@ -25,4 +31,22 @@ int main () {
     
     printf("value : %f\n", pi);
     printf("Execution time: %f seconds\n", run_time);
+
+    // Same sum with binned accumulation: exact, so the same bits for
+    // every OMP_NUM_THREADS (the plain reduction changes in the last digits)
+    repro_acc_t acc;
+    repro_init(&acc);
+
+    starttime = omp_get_wtime();
+
+    #pragma omp parallel for reduction(binned:acc) private(x)
+    for (i = 0; i < num_steps; i++) {
+        x = (i + 0.5) * step;
+        repro_add(&acc, 4.0 / (1.0 + x * x));
+    }
+
+    run_time = omp_get_wtime() - starttime;
+
+    printf("value (binned) : %.17g\n", step * repro_value(&acc));
+    printf("Execution time (binned): %f seconds\n", run_time);
 }
@@ -1,11 +1,119 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <omp.h>
 
-int main() {
+#include "bench_harness.h"
+#include "matmul_tune.h"
+
+// Build: gcc -fopenmp -I../common -I../TP1 ex4.c ../TP1/matmul_tune.c ../TP1/gemm.c
+//            ../common/bench_harness.c ../common/perf_counters.c -lm -o matrix_mult
+// Usage: ./matrix_mult [--tiled] [harness options]
+//
+// The multiplication is timed by the benchmark harness (median of several
+// repetitions); ex4.sh reads the median from --csv=- .
+//
+// By default it is the plain collapse(2) loop, so that the schedule/chunk
+// grid of ex4.sh has n*m work items to share.  --tiled runs it cache-blocked
+// instead.  The tile shape comes from the TP1 tune file (mxm_bloc --tune,
+// see ../TP1/matmul_tune.h): KC is the depth of the k blocks, and the
+// MC x NC tile of c is halved along its longer side until there are at
+// least as many tiles as with the EX4_TILE x EX4_TILE fallback (1024 for
+// n = m = 1000), so the schedules still have enough work items to share.
+// Without a tune file for this machine the EX4_TILE cube is used.
+
+#ifndef EX4_TILE
+#define EX4_TILE 32
+#endif
+
+typedef struct {
+    int ti, tj, tk;    // rows and columns of a tile of c, depth of a k block
+} tile_shape_t;
+
+static tile_shape_t tile_shape(int n, int m, int *tuned) {
+    tile_shape_t t = {EX4_TILE, EX4_TILE, EX4_TILE};
+    gemm_blocking_t blk;
+
+    *tuned = matmul_tune_load(&blk, NULL);
+    if (!*tuned)
+        return t;
+
+    long want = (long)((n + EX4_TILE - 1) / EX4_TILE) * ((m + EX4_TILE - 1) / EX4_TILE);
+    t.ti = (blk.mc < n) ? blk.mc : n;
+    t.tj = (blk.nc < m) ? blk.nc : m;
+    t.tk = (blk.kc < n) ? blk.kc : n;
+    while ((long)((n + t.ti - 1) / t.ti) * ((m + t.tj - 1) / t.tj) < want &&
+           (t.ti > 1 || t.tj > 1)) {
+        if (t.tj >= t.ti) t.tj = (t.tj + 1) / 2;
+        else              t.ti = (t.ti + 1) / 2;
+    }
+    return t;
+}
+
+// Cache-blocked c += a*b.  Threads share the tiles of c, so no two threads
+// write the same element.
+void matmul_tiled(int n, int m, double *a, double *b, double *c, tile_shape_t t) {
+    int tiles_i = (n + t.ti - 1) / t.ti;
+    int tiles_j = (m + t.tj - 1) / t.tj;
+
+    #pragma omp parallel for schedule(runtime)
+    for (int tile = 0; tile < tiles_i * tiles_j; tile++) {
+        int ii = (tile / tiles_j) * t.ti;
+        int jj = (tile % tiles_j) * t.tj;
+        int i_limit = (ii + t.ti > n) ? n : ii + t.ti;
+        int j_limit = (jj + t.tj > m) ? m : jj + t.tj;
+
+        for (int kk = 0; kk < n; kk += t.tk) {
+            int k_limit = (kk + t.tk > n) ? n : kk + t.tk;
+            for (int i = ii; i < i_limit; i++) {
+                for (int k = kk; k < k_limit; k++) {
+                    double r = a[i * n + k];
+                    for (int j = jj; j < j_limit; j++) {
+                        c[i * m + j] += r * b[k * m + j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Operands of the timed case
+typedef struct {
+    int n, m, tiled;
+    double *a, *b, *c;
+    tile_shape_t tile;
+} mm_ctx_t;
+
+static void reset_c(void *p) {
+    mm_ctx_t *x = p;
+    memset(x->c, 0, (size_t)x->n * x->m * sizeof(double));
+}
+
+static void run_matmul(void *p) {
+    mm_ctx_t *x = p;
+    int n = x->n, m = x->m;
+    double *a = x->a, *b = x->b, *c = x->c;
+
+    if (x->tiled) {
+        matmul_tiled(n, m, a, b, c, x->tile);
+    } else {
+        #pragma omp parallel for collapse(2) schedule(runtime)
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < m; j++) {
+                for (int k = 0; k < n; k++) {
+                    c[i * m + j] += a[i * n + k] * b[k * m + j];
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
     int n = 1000;
     int m = 1000;
-    double start_time, run_time;
+
+    if (bench_init("tp3_ex4", &argc, argv) != 0)
+        return 1;
 
     double *a = (double *)malloc(n * n * sizeof(double));
     double *b = (double *)malloc(n * m * sizeof(double));
@@ -23,26 +131,32 @@ int main() {
         }
     }
 
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < m; j++) {
-            c[i * m + j] = 0;
+    mm_ctx_t ctx = {n, m, 0, a, b, c, {EX4_TILE, EX4_TILE, EX4_TILE}};
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tiled") == 0) {
+            ctx.tiled = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--tiled] [harness options]\n", argv[0]);
+            return 1;
         }
     }
-
-    start_time = omp_get_wtime();
-
-    #pragma omp parallel for collapse(2) schedule(runtime)
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < m; j++) {
-            for (int k = 0; k < n; k++) {
-                c[i * m + j] += a[i * n + k] * b[k * m + j];
-            }
-        }
+    if (ctx.tiled) {
+        int tuned;
+        ctx.tile = tile_shape(n, m, &tuned);
+        printf("Tile: %d x %d, k block %d (%s)\n", ctx.tile.ti, ctx.tile.tj, ctx.tile.tk,
+               tuned ? matmul_tune_path() : "no tune file, EX4_TILE");
     }
 
-    run_time = omp_get_wtime() - start_time;
+    // c is zeroed before every repetition; threads/schedule come from
+    // OMP_NUM_THREADS / OMP_SCHEDULE
+    bench_case_t mm = {"matmul", reset_c, run_matmul, &ctx, 0,
+                       2.0 * n * n * m, (double)(n * n + 2 * n * m) * sizeof(double)};
+    bench_add(&mm);
+    bench_run();
 
-    printf("Execution time: %f seconds\n", run_time);
+    const bench_result_t *r = bench_result("matmul");
+    if (r)
+        printf("Execution time: %f seconds (median of %d)\n", r->median, r->reps);
 
     free(a);
     free(b);
@@ -1,11 +1,18 @@
 #!/bin/bash
 
-gcc -fopenmp ex4.c -o matrix_mult
+# The same grid in one process, next to the schedule chosen online by
+# ../common/adapt_sched.h: ex4_adapt.c
+
+gcc -fopenmp -I../common -I../TP1 ex4.c ../TP1/matmul_tune.c ../TP1/gemm.c \
+    ../common/bench_harness.c ../common/perf_counters.c -lm -o matrix_mult
 
 if [ $? -ne 0 ]; then
     exit 1
 fi
 
+# Median of 3 repetitions, column 5 of the harness CSV
+REPS=${REPS:-3}
+
 printf "%-10s %-10s %-10s %-15s\n" "Threads" "Schedule" "Chunk" "Time"
 
 for threads in 1 2 4 8 16; do
@@ -16,7 +23,7 @@ for threads in 1 2 4 8 16; do
             
             export OMP_SCHEDULE="$sched,$chunk"
             
-            output=$(./matrix_mult | awk '{print $3}')
+            output=$(./matrix_mult --csv=- --reps=$REPS 2>/dev/null | awk -F, '$1=="tp3_ex4" {print $5}')
             
             printf "%-10s %-10s %-10s %-15s\n" "$threads" "$sched" "$chunk" "$output"
         done
@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include "adapt_sched.h"
+#include "bench_harness.h"
+
+// Build: gcc -O2 -fopenmp -I../common ex4_adapt.c ../common/adapt_sched.c
+//            ../common/bench_harness.c ../common/perf_counters.c -lm -o ex4_adapt
+// Usage: ./ex4_adapt [--n=N] [--threads=1,2,4,8,16] [harness options, e.g. --reps=3]
+//
+// The grid of ex4.sh (threads x static/dynamic/guided x chunk 1/10/100 on
+// the collapse(2) loop of ex4.c) in one process, next to adapt_sched.h
+// choosing the schedule online for the same loop:
+//
+//   adaptive   every repetition probes and decides again (the cost of
+//              the first call)
+//   cached     the decision of the first call is reused (later calls)
+//
+// The summary gives, per thread count, the best grid cell, the adaptive
+// choice and how far both adaptive times are from that best cell.
+
+#define MAX_T 16
+
+static const char *sched_names[3] = {"static", "dynamic", "guided"};
+static const omp_sched_t sched_kinds[3] = {omp_sched_static, omp_sched_dynamic, omp_sched_guided};
+static const int chunks[3] = {1, 10, 100};
+
+typedef struct {
+    int n, m;
+    double *a, *b, *c;
+    int sched, chunk;          // grid cell, or sched = -1: adaptive
+    int cached;
+    asched_choice_t choice;    // adaptive: decision of the last run
+} mm_ctx_t;
+
+static asched_site_t site = ASCHED_SITE("ex4 matmul");
+
+static void reset_c(void *p) {
+    mm_ctx_t *x = p;
+    memset(x->c, 0, (size_t)x->n * x->m * sizeof(double));
+    if (x->sched < 0 && !x->cached)
+        asched_reset(&site);
+}
+
+// Elements lo .. hi-1 of c, in the (i, j) order of the collapse(2) loop
+// and with the same inner loop, so only the schedule differs
+static void mm_range(long lo, long hi, void *p) {
+    mm_ctx_t *x = p;
+    int n = x->n, m = x->m;
+    double *a = x->a, *b = x->b, *c = x->c;
+    for (long e = lo; e < hi; e++) {
+        int i = (int)(e / m), j = (int)(e % m);
+        for (int k = 0; k < n; k++) {
+            c[i * m + j] += a[i * n + k] * b[k * m + j];
+        }
+    }
+}
+
+static void run_matmul(void *p) {
+    mm_ctx_t *x = p;
+    int n = x->n, m = x->m;
+    double *a = x->a, *b = x->b, *c = x->c;
+
+    if (x->sched < 0) {
+        asched_for(&site, (long)n * m, mm_range, x);
+        x->choice = *asched_choice(&site, (long)n * m, omp_get_max_threads());
+        return;
+    }
+    omp_set_schedule(sched_kinds[x->sched], x->chunk);
+    #pragma omp parallel for collapse(2) schedule(runtime)
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < m; j++) {
+            for (int k = 0; k < n; k++) {
+                c[i * m + j] += a[i * n + k] * b[k * m + j];
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    int n = 1000;
+    int threads[MAX_T] = {1, 2, 4, 8, 16}, nt = 5;
+
+    bench_defaults(1, 3, 3, 30.0);
+    if (bench_init("tp3_ex4_adapt", &argc, argv) != 0)
+        return 1;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--n=", 4) == 0) {
+            n = atoi(argv[i] + 4);
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            nt = 0;
+            for (char *s = argv[i] + 10; *s && nt < MAX_T; ) {
+                threads[nt++] = (int)strtol(s, &s, 10);
+                if (*s == ',') s++;
+                else if (*s) break;
+            }
+        } else {
+            fprintf(stderr, "Unknown option '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+    int m = n;
+    if (n <= 0 || nt == 0) {
+        fprintf(stderr, "Bad --n / --threads\n");
+        return 1;
+    }
+
+    double *a = (double *)malloc((size_t)n * n * sizeof(double));
+    double *b = (double *)malloc((size_t)n * m * sizeof(double));
+    double *c = (double *)malloc((size_t)n * m * sizeof(double));
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            a[i * n + j] = (i + 1) + (j + 1);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < m; j++)
+            b[i * m + j] = (i + 1) - (j + 1);
+
+    // 9 grid cells + adaptive + cached per thread count
+    static mm_ctx_t ctx[MAX_T][11];
+    static char names[MAX_T][11][40];
+    double flops = 2.0 * n * n * m, bytes = (double)(n * n + 2 * n * m) * sizeof(double);
+    for (int t = 0; t < nt; t++) {
+        for (int k = 0; k < 11; k++) {
+            mm_ctx_t *x = &ctx[t][k];
+            *x = (mm_ctx_t){n, m, a, b, c, -1, 0, k == 10, {0}};
+            if (k < 9) {
+                x->sched = k / 3;
+                x->chunk = chunks[k % 3];
+                snprintf(names[t][k], sizeof(names[t][k]), "t=%d %s,%d", threads[t],
+                         sched_names[x->sched], x->chunk);
+            } else {
+                snprintf(names[t][k], sizeof(names[t][k]), "t=%d %s", threads[t],
+                         k == 9 ? "adaptive" : "cached");
+            }
+            bench_case_t bc = {names[t][k], reset_c, run_matmul, x, threads[t], flops, bytes};
+            bench_add(&bc);
+        }
+    }
+    bench_run();
+
+    // The ex4.sh table
+    printf("\n%-10s %-10s %-10s %-15s\n", "Threads", "Schedule", "Chunk", "Time");
+    for (int t = 0; t < nt; t++)
+        for (int k = 0; k < 9; k++) {
+            const bench_result_t *r = bench_result(names[t][k]);
+            if (r)
+                printf("%-10d %-10s %-10d %-15f\n", threads[t], sched_names[k / 3],
+                       chunks[k % 3], r->median);
+        }
+
+    printf("\n| Threads | Best cell          | Time (s) | Adaptive choice        | Adaptive | Cached   | Rank |\n");
+    for (int t = 0; t < nt; t++) {
+        int best = -1;
+        for (int k = 0; k < 9; k++) {
+            const bench_result_t *r = bench_result(names[t][k]);
+            if (r && (best < 0 || r->median < bench_result(names[t][best])->median)) best = k;
+        }
+        const bench_result_t *ad = bench_result(names[t][9]), *ca = bench_result(names[t][10]);
+        const asched_choice_t *ch = &ctx[t][10].choice;
+        if (best < 0 || !ad || !ca)
+            continue;
+
+        // Where the cached run would sit among the 9 cells
+        double tb = bench_result(names[t][best])->median;
+        int rank = 1;
+        for (int k = 0; k < 9; k++)
+            if (bench_result(names[t][k]) && bench_result(names[t][k])->median < ca->median)
+                rank++;
+
+        char cell[32], choice[32];
+        snprintf(cell, sizeof(cell), "%s,%d", sched_names[best / 3], chunks[best % 3]);
+        if (ch->kind == ASCHED_STATIC && ch->chunk == 0)
+            snprintf(choice, sizeof(choice), "static (cv %.2f)", ch->cv);
+        else
+            snprintf(choice, sizeof(choice), "%s,%ld (cv %.2f)", asched_kind_name(ch->kind),
+                     ch->chunk, ch->cv);
+        printf("| %7d | %-18s | %8.4f | %-22s | %+7.1f%% | %+7.1f%% | %d/10 |\n", threads[t], cell,
+               tb, choice, 100.0 * (ad->median / tb - 1.0), 100.0 * (ca->median / tb - 1.0), rank);
+    }
+    printf("(Adaptive / Cached: time relative to the best cell; Rank: place of the cached\n"
+           " run among the 9 cells and itself)\n");
+
+    free(a);
+    free(b);
+    free(c);
+    return 0;
+}
@@ -6,6 +6,16 @@
 #include <float.h>
 #include <omp.h>
 
+#include "jacobi.h"
+
+// Compile: gcc -O3 -fopenmp -I../common ex5.c ../common/jacobi.c ../common/simd_reduce.c
+//              -lm -o jacobi_omp
+// Usage:   ./jacobi_omp [--orig]
+//
+// The solve runs on the jacobi.h engine (A transposed once so that rows are
+// contiguous, one parallel region, fused residual, swapped vectors);
+// --orig runs the original loop below instead, for comparison.
+
 #ifndef VAL_N
 #define VAL_N 2000
 #endif
@@ -19,11 +29,52 @@ void random_number(double* array, int size) {
     }
 }
 
-int main() {
-    int n = VAL_N, diag = VAL_D;
+// Original loop: column walk of a, two parallel regions and a memcpy per sweep
+static int jacobi_orig(int n, double *a, double *b, double *x, double *x_courant,
+                       double *norme_out) {
     int i, j, iteration = 0;
     double norme;
 
+    while (1) {
+        iteration++;
+
+        #pragma omp parallel for private(j)
+        for (i = 0; i < n; i++) {
+            x_courant[i] = 0;
+            for (j = 0; j < i; j++) {
+                x_courant[i] += a[j * n + i] * x[j];
+            }
+            for (j = i + 1; j < n; j++) {
+                x_courant[i] += a[j * n + i] * x[j];
+            }
+            x_courant[i] = (b[i] - x_courant[i]) / a[i * n + i];
+        }
+
+        double absmax = 0;
+        
+        #pragma omp parallel for reduction(max: absmax)
+        for (i = 0; i < n; i++) {
+            double curr = fabs(x[i] - x_courant[i]);
+            if (curr > absmax)
+                absmax = curr;
+        }
+        
+        norme = absmax / n;
+
+        if ((norme <= DBL_EPSILON) || (iteration >= n)) break;
+
+        memcpy(x, x_courant, n * sizeof(double));
+    }
+    *norme_out = norme;
+    return iteration;
+}
+
+int main(int argc, char **argv) {
+    int n = VAL_N, diag = VAL_D;
+    int i, iteration = 0;
+    double norme;
+    int orig = (argc > 1 && strcmp(argv[1], "--orig") == 0);
+
     double *a = (double*)malloc(n * n * sizeof(double));
     double *x = (double*)malloc(n * sizeof(double));
     double *x_courant = (double*)malloc(n * sizeof(double));
@@ -53,35 +104,18 @@ int main() {
     t_cpu_0 = omp_get_wtime();
     gettimeofday(&t_elapsed_0, NULL);
 
-    while (1) {
-        iteration++;
-
-        #pragma omp parallel for private(j)
-        for (i = 0; i < n; i++) {
-            x_courant[i] = 0;
-            for (j = 0; j < i; j++) {
-                x_courant[i] += a[j * n + i] * x[j];
-            }
-            for (j = i + 1; j < n; j++) {
-                x_courant[i] += a[j * n + i] * x[j];
-            }
-            x_courant[i] = (b[i] - x_courant[i]) / a[i * n + i];
+    jacobi_result_t res = {0, 0.0, 0.0, 0.0, 0.0};
+    if (orig) {
+        iteration = jacobi_orig(n, a, b, x, x_courant, &norme);
+    } else {
+        // a[j*n+i] is element (i, j) of the system: column-major for the engine
+        res = jacobi_solve(n, a, JACOBI_COL_MAJOR, b, x, DBL_EPSILON, n);
+        if (res.iterations < 0) {
+            fprintf(stderr, "Memory allocation failed!\n");
+            exit(EXIT_FAILURE);
         }
-
-        double absmax = 0;
-        
-        #pragma omp parallel for reduction(max: absmax)
-        for (i = 0; i < n; i++) {
-            double curr = fabs(x[i] - x_courant[i]);
-            if (curr > absmax)
-                absmax = curr;
-        }
-        
-        norme = absmax / n;
-
-        if ((norme <= DBL_EPSILON) || (iteration >= n)) break;
-
-        memcpy(x, x_courant, n * sizeof(double));
+        iteration = res.iterations;
+        norme = res.norm;
     }
 
     gettimeofday(&t_elapsed_1, NULL);
@@ -91,12 +125,22 @@ int main() {
     t_cpu_1 = omp_get_wtime();
     t_cpu = t_cpu_1 - t_cpu_0;
 
+    // 2 n^2 flops per sweep, counted over the whole run (transpose included)
+    double gflops = 2.0 * n * (double)n * iteration / t_elapsed * 1e-9;
+
     fprintf(stdout, "\nSystem size        : %5d\n"
+                    "Solver             : %s\n"
+                    "Threads            : %5d\n"
                     "Iterations         : %4d\n"
                     "Norme              : %10.3E\n"
                     "Elapsed time       : %10.3E sec.\n"
-                    "CPU time           : %10.3E sec.\n",
-                    n, iteration, norme, t_elapsed, t_cpu);
+                    "CPU time           : %10.3E sec.\n"
+                    "GFLOP/s            : %10.3f\n",
+                    n, orig ? "original" : "engine", omp_get_max_threads(), iteration,
+                    norme, t_elapsed, t_cpu, gflops);
+    if (!orig)
+        fprintf(stdout, "Transpose          : %10.3E sec. (sweeps %10.3E sec., %.3f GFLOP/s)\n",
+                res.transpose, res.seconds, res.gflops);
 
     free(a); free(x); free(x_courant); free(b);
     return EXIT_SUCCESS;
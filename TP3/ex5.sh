@@ -1,26 +1,32 @@
 #!/bin/bash
 
-gcc -fopenmp ex5.c -o jacobi_omp -O3
+gcc -fopenmp -I../common ex5.c ../common/jacobi.c ../common/simd_reduce.c -lm -o jacobi_omp -O3
 
 if [ $? -ne 0 ]; then
     echo "Compilation failed"
     exit 1
 fi
 
-echo "Threads Time" > results.txt
+# SOLVER=--orig runs the original loop instead of the jacobi.h engine
+SOLVER=${SOLVER:-}
+
+echo "Threads Time Iterations GFLOP/s" > results.txt
 
 echo "Running tests..."
 for t in 1 2 4 8 16; do
     export OMP_NUM_THREADS=$t
     echo "Running with $t threads..."
     
-    # Run the program and extract the CPU time line
-    output=$(./jacobi_omp | grep "CPU time")
+    # Run the program once, keep its output block
+    output=$(./jacobi_omp $SOLVER)
     
-    # Extract just the number (assumes format "... : 1.234E+01 sec.")
-    time_val=$(echo $output | awk '{print $4}')
+    # Extract just the numbers (formats "CPU time : 1.234E+01 sec.",
+    # "Iterations : 281", "GFLOP/s : 5.082")
+    time_val=$(echo "$output" | awk '/^CPU time/ {print $4}')
+    iter_val=$(echo "$output" | awk '/^Iterations/ {print $3}')
+    gflops_val=$(echo "$output" | awk '/^GFLOP\/s/ {print $3}')
     
-    echo "$t $time_val" >> results.txt
+    echo "$t $time_val $iter_val $gflops_val" >> results.txt
 done
 
 echo "Done. Results saved to results.txt"
@@ -2,6 +2,10 @@
 #include <stdlib.h>
 #include <omp.h>
 
+#include "repro_sum.h"
+
+// Compile: gcc -O2 -fopenmp -I../common -o ex2 ex2.c ../common/repro_sum.c -lm
+
 #define N 1000
 
 // Logic: A[i][j] = i + j
@@ -72,6 +76,15 @@ int main() {
     printf("Sum = %lf\n", sum);
     printf("Execution time (OpenMP) = %lf seconds\n", end - start);
 
+    // The reduction above depends on the thread count in general; the
+    // binned sum is exact and gives the same bits for any count
+    start = omp_get_wtime();
+    double repro = sum_array_omp(A, (size_t)N * N, SUM_BINNED);
+    end = omp_get_wtime();
+
+    printf("Sum (binned, reproducible) = %.17g\n", repro);
+    printf("Execution time (binned) = %lf seconds\n", end - start);
+
     free(A);
     return 0;
 }
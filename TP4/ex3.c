@@ -1,44 +1,177 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <omp.h>
 
-void task_light(int N) {
+#include "simd_reduce.h"
+#include "vmath.h"
+#include "wsteal.h"
+#include "cost_model.h"
+
+// Compile: gcc -O2 -fopenmp -I../common -o ex3 ex3.c ../common/vmath.c ../common/simd_reduce.c
+//              ../common/wsteal.c ../common/cost_model.c -lm
+//          (add -march=native for --math=simd)
+// Usage:   ./ex3 [--math=libm|vm|simd] [--costs=FILE]
+//
+//   libm  scalar sin / cos / sqrt calls (the original tasks)
+//   vm    batch vm_sin / vm_cos / vm_sqrt over blocks of arguments
+//         (vmath.h, SIMD path picked at run time)
+//   simd  the vm_*1 element functions in "omp simd" loops
+//
+// Strategy 7 learns the task costs: every run updates FILE (default
+// ex3_costs.txt, one model per --math mode) and the next run orders
+// and splits the tasks from it instead of fixed priorities.
+
+typedef enum { MATH_LIBM, MATH_VM, MATH_SIMD } math_mode_t;
+static const char *math_names[] = {"libm", "vm", "simd"};
+static math_mode_t math_mode = MATH_LIBM;
+
+// Results of the tasks (keeps the loops from being optimized away)
+static double task_sink[3];
+
+/* ===== Task bodies over [lo, hi), in the selected math mode ===== */
+#define VM_BLK 1000
+
+static double light_range(int lo, int hi) {
     double x = 0.0;
-    for (int i = 0; i < N; i++) {
-        x += sin(i * 0.001);
+    if (math_mode == MATH_LIBM) {
+        for (int i = lo; i < hi; i++)
+            x += sin(i * 0.001);
+    } else if (math_mode == MATH_SIMD) {
+        #pragma omp simd reduction(+:x)
+        for (int i = lo; i < hi; i++)
+            x += vm_sin1(i * 0.001);
+    } else {
+        double s[VM_BLK];
+        for (int i0 = lo; i0 < hi; i0 += VM_BLK) {
+            int len = (hi - i0 < VM_BLK) ? hi - i0 : VM_BLK;
+            for (int k = 0; k < len; k++) s[k] = (i0 + k) * 0.001;
+            vm_sin(s, s, len);
+            for (int k = 0; k < len; k++) x += s[k];
+        }
     }
+    return x;
 }
 
-void task_moderate(int N) {
+static double moderate_range(int lo, int hi) {
     double x = 0.0;
-    for (int i = 0; i < 5*N; i++) {
-        x += sqrt(i * 0.5) * cos(i * 0.001);
+    if (math_mode == MATH_LIBM) {
+        for (int i = lo; i < hi; i++)
+            x += sqrt(i * 0.5) * cos(i * 0.001);
+    } else if (math_mode == MATH_SIMD) {
+        #pragma omp simd reduction(+:x)
+        for (int i = lo; i < hi; i++)
+            x += vm_sqrt1(i * 0.5) * vm_cos1(i * 0.001);
+    } else {
+        double q[VM_BLK], c[VM_BLK];
+        for (int i0 = lo; i0 < hi; i0 += VM_BLK) {
+            int len = (hi - i0 < VM_BLK) ? hi - i0 : VM_BLK;
+            for (int k = 0; k < len; k++) {
+                q[k] = (i0 + k) * 0.5;
+                c[k] = (i0 + k) * 0.001;
+            }
+            vm_sqrt(q, q, len);
+            vm_cos(c, c, len);
+            for (int k = 0; k < len; k++) x += q[k] * c[k];
+        }
     }
+    return x;
 }
 
-void task_heavy(int N) {
+static double heavy_range(int lo, int hi) {
     double x = 0.0;
-    for (int i = 0; i < 20*N; i++) {
-        x += sqrt(i * 0.5) * cos(i * 0.001) * sin(i * 0.0001);
+    if (math_mode == MATH_LIBM) {
+        for (int i = lo; i < hi; i++)
+            x += sqrt(i * 0.5) * cos(i * 0.001) * sin(i * 0.0001);
+    } else if (math_mode == MATH_SIMD) {
+        #pragma omp simd reduction(+:x)
+        for (int i = lo; i < hi; i++)
+            x += vm_sqrt1(i * 0.5) * vm_cos1(i * 0.001) * vm_sin1(i * 0.0001);
+    } else {
+        double q[VM_BLK], c[VM_BLK], s[VM_BLK];
+        for (int i0 = lo; i0 < hi; i0 += VM_BLK) {
+            int len = (hi - i0 < VM_BLK) ? hi - i0 : VM_BLK;
+            for (int k = 0; k < len; k++) {
+                q[k] = (i0 + k) * 0.5;
+                c[k] = (i0 + k) * 0.001;
+                s[k] = (i0 + k) * 0.0001;
+            }
+            vm_sqrt(q, q, len);
+            vm_cos(c, c, len);
+            vm_sin(s, s, len);
+            for (int k = 0; k < len; k++) x += q[k] * c[k] * s[k];
+        }
     }
+    return x;
+}
+
+// Range bodies for the work-stealing runtime (strategy 6)
+static double ws_light(long lo, long hi, void *arg) {
+    (void)arg;
+    return light_range((int)lo, (int)hi);
 }
 
-int main() {
+static double ws_moderate(long lo, long hi, void *arg) {
+    (void)arg;
+    return moderate_range((int)lo, (int)hi);
+}
+
+static double ws_heavy(long lo, long hi, void *arg) {
+    (void)arg;
+    return heavy_range((int)lo, (int)hi);
+}
+
+void task_light(int N) {
+    task_sink[0] = light_range(0, N);
+}
+
+void task_moderate(int N) {
+    task_sink[1] = moderate_range(0, 5*N);
+}
+
+void task_heavy(int N) {
+    task_sink[2] = heavy_range(0, 20*N);
+}
+
+int main(int argc, char **argv) {
     int N = 1000000;
     double start, end;
+    const char *cost_file = "ex3_costs.txt";
+
+    for (int a = 1; a < argc; a++) {
+        if (strncmp(argv[a], "--costs=", 8) == 0) cost_file = argv[a] + 8;
+        if (strncmp(argv[a], "--math=", 7) != 0) continue;
+        int m = 0;
+        while (m < 3 && strcmp(argv[a] + 7, math_names[m]) != 0) m++;
+        if (m == 3) {
+            fprintf(stderr, "Unknown --math mode '%s' (libm|vm|simd)\n", argv[a] + 7);
+            return 1;
+        }
+        math_mode = (math_mode_t)m;
+    }
     
     printf("=== Load Balancing with OpenMP ===\n");
-    printf("N = %d, Threads = %d\n\n", N, omp_get_max_threads());
+    printf("N = %d, Threads = %d, Math = %s", N, omp_get_max_threads(), math_names[math_mode]);
+    if (math_mode == MATH_VM) printf(" (%s)", reduce_isa_name(reduce_isa()));
+    printf("\n\n");
     
-    // Sequential baseline
+    // Sequential baseline, per task: how much of the work is in C
+    double t_task[3];
     start = omp_get_wtime();
     task_light(N);
+    t_task[0] = omp_get_wtime() - start;
     task_moderate(N);
+    t_task[1] = omp_get_wtime() - start - t_task[0];
     task_heavy(N);
     end = omp_get_wtime();
+    t_task[2] = end - start - t_task[0] - t_task[1];
     double seq_time = end - start;
-    printf("Sequential: %.6f seconds\n\n", seq_time);
+    double t_strat[7];
+    printf("Sequential: %.6f seconds\n", seq_time);
+    printf("  A %.4f s, B %.4f s, C %.4f s: C is %.0f%% of the work, "
+           "sections speedup bound %.2fx\n\n", t_task[0], t_task[1], t_task[2],
+           100.0 * t_task[2] / seq_time, seq_time / t_task[2]);
     
     // ============================================
     // Strategy 1: Basic sections (unbalanced)
@@ -68,6 +201,7 @@ int main() {
     end = omp_get_wtime();
     printf("Time: %.6f s, Speedup: %.2fx\n\n", 
            end - start, seq_time / (end - start));
+    t_strat[0] = end - start;
     
     // ============================================
     // Strategy 2: Balanced sections (combine light tasks)
@@ -92,6 +226,7 @@ int main() {
     end = omp_get_wtime();
     printf("Time: %.6f s, Speedup: %.2fx\n\n", 
            end - start, seq_time / (end - start));
+    t_strat[1] = end - start;
     
     // ============================================
     // Strategy 3: Dynamic task scheduling
@@ -125,6 +260,7 @@ int main() {
     end = omp_get_wtime();
     printf("Time: %.6f s, Speedup: %.2fx\n\n", 
            end - start, seq_time / (end - start));
+    t_strat[2] = end - start;
     
     // ============================================
     // Strategy 4: Priority-based scheduling
@@ -158,6 +294,7 @@ int main() {
     end = omp_get_wtime();
     printf("Time: %.6f s, Speedup: %.2fx\n\n", 
            end - start, seq_time / (end - start));
+    t_strat[3] = end - start;
     
     // ============================================
     // Strategy 5: Parallel loop inside heavy task
@@ -168,15 +305,88 @@ int main() {
     task_light(N);
     task_moderate(N);
     
+    // Chunks of VM_BLK (= 1000) iterations, as schedule(dynamic, 1000)
     double x = 0.0;
-    #pragma omp parallel for reduction(+:x) schedule(dynamic, 1000)
-    for (int i = 0; i < 20*N; i++) {
-        x += sqrt(i * 0.5) * cos(i * 0.001) * sin(i * 0.0001);
+    int n_blk = (20*N + VM_BLK - 1) / VM_BLK;
+    #pragma omp parallel for reduction(+:x) schedule(dynamic)
+    for (int b = 0; b < n_blk; b++) {
+        int hi = (b + 1) * VM_BLK < 20*N ? (b + 1) * VM_BLK : 20*N;
+        x += heavy_range(b * VM_BLK, hi);
     }
     
     end = omp_get_wtime();
-    printf("Time: %.6f s, Speedup: %.2fx\n\n", 
+    printf("Time: %.6f s, Speedup: %.2fx\n", 
+           end - start, seq_time / (end - start));
+    printf("Heavy sum: %.10e (task C: %.10e)\n\n", x, task_sink[2]);
+    t_strat[4] = end - start;
+    
+    // ============================================
+    // Strategy 6: Work stealing (wsteal.h)
+    // ============================================
+    // The three tasks as they are, each a splittable range with the grain
+    // of strategy 5: no hand combining, idle threads steal pieces of C
+    printf("--- Strategy 6: Work Stealing (A, B, C as splittable jobs) ---\n");
+    ws_init(omp_get_max_threads());
+    ws_job_t jobs[3] = {{0, N, VM_BLK, ws_light, NULL, 0.0},
+                        {0, 5*N, VM_BLK, ws_moderate, NULL, 0.0},
+                        {0, 20*N, VM_BLK, ws_heavy, NULL, 0.0}};
+    ws_stats_reset();
+    start = omp_get_wtime();
+    ws_run_jobs(jobs, 3);
+    end = omp_get_wtime();
+    ws_stats_t st = ws_stats();
+    printf("Time: %.6f s, Speedup: %.2fx\n", 
            end - start, seq_time / (end - start));
+    printf("%d workers, %ld pieces, %ld steals\n", ws_nthreads(), st.tasks, st.steals);
+    printf("Sums: %.10e %.10e %.10e (tasks: %.10e %.10e %.10e)\n\n",
+           jobs[0].result, jobs[1].result, jobs[2].result,
+           task_sink[0], task_sink[1], task_sink[2]);
+    t_strat[5] = end - start;
+    ws_finalize();
+    
+    // ============================================
+    // Strategy 7: Learned costs, longest first (cost_model.h)
+    // ============================================
+    // Replaces the priority(100/50/10) guesses of strategy 4: the costs
+    // come from the previous runs, the heavy task is split to fit
+    printf("--- Strategy 7: Learned Cost Model (LPT) ---\n");
+    cost_model_t model;
+    if (cm_load(&model, cost_file) != 0)
+        fprintf(stderr, "Ignoring bad lines of %s\n", cost_file);
+    if (model.n == 0) printf("No history in %s yet: equal costs per unit\n", cost_file);
+    
+    // One set of types per math mode: the costs differ a lot between them
+    char type[3][CM_NAME_LEN];
+    const char *kinds[3] = {"light", "moderate", "heavy"};
+    for (int k = 0; k < 3; k++)
+        snprintf(type[k], sizeof(type[k]), "%s/%s", kinds[k], math_names[math_mode]);
+    cm_task_t cm_tasks[3] = {
+        {.name = type[0], .lo = 0, .hi = N,    .grain = VM_BLK, .fn = ws_light},
+        {.name = type[1], .lo = 0, .hi = 5*N,  .grain = VM_BLK, .fn = ws_moderate},
+        {.name = type[2], .lo = 0, .hi = 20*N, .grain = VM_BLK, .fn = ws_heavy}};
+    
+    double had_cost[3];
+    for (int k = 0; k < 3; k++) had_cost[k] = cm_cost(&model, type[k]);
+    t_strat[6] = cm_run(&model, cm_tasks, 3, stdout);
+    printf("Time: %.6f s, Speedup: %.2fx\n", 
+           t_strat[6], seq_time / t_strat[6]);
+    for (int k = 0; k < 3; k++) {
+        printf("  %-14s measured %.4f s", type[k], cm_tasks[k].measured);
+        if (had_cost[k] > 0)
+            printf(" (estimated %.4f s)", cm_tasks[k].estimate);
+        printf("\n");
+    }
+    if (cm_save(&model) == 0) printf("Updated %s:\n", cost_file);
+    cm_print(&model, stdout);
+    printf("\n");
+    
+    static const char *strat_names[7] = {"Basic sections", "Balanced sections", "Dynamic tasks",
+                                         "Priority tasks", "Heavy task split", "Work stealing",
+                                         "Learned costs"};
+    printf("| %-21s | %-10s | %-7s |\n", "Strategy", "Time (s)", "Speedup");
+    for (int k = 0; k < 7; k++)
+        printf("| %d. %-18s | %10.6f | %6.2fx |\n", k + 1, strat_names[k],
+               t_strat[k], seq_time / t_strat[k]);
     
     return 0;
 }
@@ -2,6 +2,21 @@
 #include <stdlib.h>
 #include <omp.h>
 
+#include "hpc_alloc.h"
+#include "bench_harness.h"
+#include "dmvm.h"
+
+// Compile: gcc -O2 -fopenmp -I../common -o ex4 ex4.c ../common/hpc_alloc.c
+//              ../common/bench_harness.c ../common/perf_counters.c
+//              ../common/dmvm.c ../common/simd_reduce.c -lm
+// Usage:   ./ex4 [--alloc=malloc|aligned|thp|hugetlb] [--interleave]
+//              [--reps=MIN:MAX] [--json=FILE] [--csv=FILE] ... (see bench_harness.h)
+
+// V4 / V5 / V6 use the dmvm.h engine: a row or column partition set up
+// once (no barrier per column), 4 columns per pass of the SIMD FMA loop,
+// and for V6 NRHS right-hand sides sharing every block of mat.
+#define NRHS 8
+
 // Version 1: Implicit Barrier (Safe but Slow)
 void dmvm_v1(int n, int m, double *lhs, double *rhs, double *mat) {
     #pragma omp parallel
@@ -54,16 +69,65 @@ void reset_lhs(int m, double *lhs) {
     for (int i = 0; i < m; i++) lhs[i] = 0.0;
 }
 
-int main(void) {
+// Operands shared by the harness cases
+typedef struct {
+    int n, m;
+    double *lhs, *rhs, *mat;
+    double *lhs_k, *rhs_k;   // NRHS vectors, for V6
+} dmvm_ctx_t;
+
+static void reset_case(void *p) { dmvm_ctx_t *x = p; reset_lhs(x->m, x->lhs); }
+static void reset_multi(void *p) { dmvm_ctx_t *x = p; reset_lhs(NRHS * x->m, x->lhs_k); }
+static void run_v1(void *p) { dmvm_ctx_t *x = p; dmvm_v1(x->n, x->m, x->lhs, x->rhs, x->mat); }
+static void run_v2(void *p) { dmvm_ctx_t *x = p; dmvm_v2(x->n, x->m, x->lhs, x->rhs, x->mat); }
+static void run_v3(void *p) { dmvm_ctx_t *x = p; dmvm_v3(x->n, x->m, x->lhs, x->rhs, x->mat); }
+static void run_v4(void *p) { dmvm_ctx_t *x = p; dmvm(x->m, x->n, x->mat, x->m, x->rhs, x->lhs, DMVM_ROWS); }
+static void run_v5(void *p) { dmvm_ctx_t *x = p; dmvm(x->m, x->n, x->mat, x->m, x->rhs, x->lhs, DMVM_COLS); }
+static void run_v6(void *p) {
+    dmvm_ctx_t *x = p;
+    dmvm_multi(x->m, x->n, NRHS, x->mat, x->m, x->rhs_k, x->n, x->lhs_k, x->m, DMVM_AUTO);
+}
+
+// Every element of lhs (count vectors) should be n: "OK" or "FAIL"
+static const char *check(int count, int m, const double *lhs, double n) {
+    for (int i = 0; i < count * m; i++)
+        if (lhs[i] != n) return "  FAIL";
+    return "  OK";
+}
+
+// One row of the speedup table, from the median of a case (per
+// right-hand side when the case does several)
+static void print_version(const char *label, const char *case_name, double time_seq,
+                          int threads, double FLOPs, const char *status, int per) {
+    const bench_result_t *r = bench_result(case_name);
+    if (!r) return;
+    double t = r->median / per;
+    printf("| %-7s | %8.4f | %6.2fx | %9.1f%% | %8.2f | %-6s |\n",
+           label, t, time_seq / t, (time_seq / t / threads) * 100, FLOPs / t / 1e6, status);
+}
+
+int main(int argc, char **argv) {
+    if (hpc_alloc_parse_args(&argc, argv) != 0)
+        return 1;
+    if (bench_init("tp4_ex4", &argc, argv) != 0)
+        return 1;
+
     const int n = 40000; // columns
     const int m = 600;   // rows
     
     // Total Floating Point Operations: 2 * N * M (Multiply + Add per element)
     double FLOPs = 2.0 * (double)n * (double)m;
 
-    double *mat = (double*)malloc(n * m * sizeof(double));
-    double *rhs = (double*)malloc(n * sizeof(double));
-    double *lhs = (double*)malloc(m * sizeof(double));
+    double *mat = (double*)hpc_malloc((size_t)n * m * sizeof(double));
+    double *rhs = (double*)hpc_malloc(n * sizeof(double));
+    double *lhs = (double*)hpc_malloc(m * sizeof(double));
+    double *rhs_k = (double*)hpc_malloc((size_t)NRHS * n * sizeof(double));
+    double *lhs_k = (double*)hpc_malloc((size_t)NRHS * m * sizeof(double));
+
+    if (!mat || !rhs || !lhs || !rhs_k || !lhs_k) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
 
     // Initialization
     for (int c = 0; c < n; ++c) {
@@ -71,64 +135,68 @@ int main(void) {
         for (int r = 0; r < m; ++r)
             mat[r + c*m] = 1.0; // All 1s for verification
     }
+    for (int i = 0; i < NRHS * n; i++) rhs_k[i] = 1.0;
 
-    printf("Matrix: %d x %d | Threads: %d\n", m, n, omp_get_max_threads());
-    printf("----------------------------------------------------------------\n");
-    printf("| Version | Time (s) | Speedup | Efficiency | MFLOP/s  | Status |\n");
-    printf("----------------------------------------------------------------\n");
-
-    double start, end, time_seq, time_v1, time_v2, time_v3;
+    int threads = omp_get_max_threads();
+    dmvm_ctx_t ctx = {n, m, lhs, rhs, mat, lhs_k, rhs_k};
+    double bytes = ((double)n * m + n + 2.0 * m) * sizeof(double);
+    double bytes_k = ((double)n * m + NRHS * (n + 2.0 * m)) * sizeof(double);
 
-    // --- SEQUENTIAL BASELINE (Run V1 with 1 thread) ---
+    // --- SEQUENTIAL BASELINE (V1 with 1 thread) ---
     // Note: Usually we write a separate sequential function, but V1 with 1 thread is equivalent.
-    omp_set_num_threads(1);
-    reset_lhs(m, lhs);
-    start = omp_get_wtime();
-    dmvm_v1(n, m, lhs, rhs, mat);
-    end = omp_get_wtime();
-    time_seq = end - start;
-    printf("| Seq     | %8.4f |   1.00x |    100%%    | %8.2f |   OK   |\n", 
-           time_seq, FLOPs/time_seq/1e6);
-
-    // Reset to max threads for parallel tests
-    int threads = omp_get_max_threads();
-    omp_set_num_threads(threads);
-
-    // --- VERSION 1: Implicit Barrier ---
-    reset_lhs(m, lhs);
-    start = omp_get_wtime();
-    dmvm_v1(n, m, lhs, rhs, mat);
-    end = omp_get_wtime();
-    time_v1 = end - start;
-    printf("| V1 Sync | %8.4f | %6.2fx | %9.1f%% | %8.2f |   OK   |\n", 
-           time_v1, time_seq/time_v1, (time_seq/time_v1/threads)*100, FLOPs/time_v1/1e6);
-
-    // --- VERSION 2: Dynamic + NoWait (Unsafe) ---
-    reset_lhs(m, lhs);
-    start = omp_get_wtime();
-    dmvm_v2(n, m, lhs, rhs, mat);
-    end = omp_get_wtime();
-    time_v2 = end - start;
-    printf("| V2 Dyn  | %8.4f | %6.2fx | %9.1f%% | %8.2f |  RACE  |\n", 
-           time_v2, time_seq/time_v2, (time_seq/time_v2/threads)*100, FLOPs/time_v2/1e6);
-
-    // --- VERSION 3: Static + NoWait (Best) ---
-    reset_lhs(m, lhs);
-    start = omp_get_wtime();
-    dmvm_v3(n, m, lhs, rhs, mat);
-    end = omp_get_wtime();
-    time_v3 = end - start;
-    printf("| V3 Stat | %8.4f | %6.2fx | %9.1f%% | %8.2f |   OK   |\n", 
-           time_v3, time_seq/time_v3, (time_seq/time_v3/threads)*100, FLOPs/time_v3/1e6);
+    bench_case_t cases[] = {
+        {"Seq",     reset_case, run_v1, &ctx, 1,       FLOPs, bytes},
+        {"V1 Sync", reset_case, run_v1, &ctx, threads, FLOPs, bytes},  // Implicit Barrier
+        {"V2 Dyn",  reset_case, run_v2, &ctx, threads, FLOPs, bytes},  // Dynamic + NoWait (Unsafe)
+        {"V3 Stat", reset_case, run_v3, &ctx, threads, FLOPs, bytes},  // Static + NoWait (Best)
+        {"V4 Rows", reset_case, run_v4, &ctx, threads, FLOPs, bytes},  // dmvm.h, row blocks
+        {"V5 Cols", reset_case, run_v5, &ctx, threads, FLOPs, bytes},  // dmvm.h, column blocks + tree
+        {"V6 Multi", reset_multi, run_v6, &ctx, threads, NRHS * FLOPs, bytes_k},  // NRHS vectors
+    };
+    for (int c = 0; c < 7; c++) bench_add(&cases[c]);
+
+    printf("Matrix: %d x %d | Threads: %d | Alloc: %s | dmvm auto: %s\n", m, n, threads,
+           hpc_alloc_describe(), dmvm_part_name(dmvm_auto_part(m, n, threads)));
+    bench_run();
+
+    // Speedup table on the medians
+    const bench_result_t *seq = bench_result("Seq");
+    double time_seq = seq ? seq->median : 0.0;
+
+    printf("\n----------------------------------------------------------------\n");
+    printf("| Version | Time (s) | Speedup | Efficiency | MFLOP/s  | Status |\n");
     printf("----------------------------------------------------------------\n");
+    if (seq)
+        printf("| Seq     | %8.4f |   1.00x |    100%%    | %8.2f |   OK   |\n",
+               time_seq, FLOPs / time_seq / 1e6);
+    if (seq) {
+        print_version("V1 Sync", "V1 Sync", time_seq, threads, FLOPs, "  OK", 1);
+        print_version("V2 Dyn", "V2 Dyn", time_seq, threads, FLOPs, " RACE", 1);
+        print_version("V3 Stat", "V3 Stat", time_seq, threads, FLOPs, "  OK", 1);
+
+        // The engine versions are checked on one more run each
+        reset_case(&ctx);
+        run_v4(&ctx);
+        print_version("V4 Rows", "V4 Rows", time_seq, threads, FLOPs, check(1, m, lhs, n), 1);
+        reset_case(&ctx);
+        run_v5(&ctx);
+        print_version("V5 Cols", "V5 Cols", time_seq, threads, FLOPs, check(1, m, lhs, n), 1);
+        reset_multi(&ctx);
+        run_v6(&ctx);
+        print_version("V6 /rhs", "V6 Multi", time_seq, threads, FLOPs, check(NRHS, m, lhs_k, n), NRHS);
+    }
+    printf("----------------------------------------------------------------\n");
+    printf("(V6: %d right-hand sides per call, time and MFLOP/s per right-hand side)\n", NRHS);
 
     // Verification (First element should be equal to N * 1.0 * 1.0 = 40000)
     printf("\nVerification (lhs[0]): Expected %.1f\n", (double)n);
-    printf("V1 Result: %.1f\n", lhs[0]); 
-    // Note: V2 result might be wrong here due to race condition
-
-    free(mat);
-    free(rhs);
-    free(lhs);
+    printf("Last run result: %.1f\n", lhs[0]);
+    // Note: V2 result might be wrong due to race condition
+
+    hpc_free(mat);
+    hpc_free(rhs);
+    hpc_free(lhs);
+    hpc_free(rhs_k);
+    hpc_free(lhs_k);
     return 0;
 }
@@ -3,6 +3,10 @@
 #include <math.h>
 #include <mpi.h>
 
+#include "repro_sum.h"   // after mpi.h: provides repro_mpi_reduce()
+
+// Compile: mpicc -I../common -o pi_approxi ex5.c ../common/repro_sum.c -lm
+
 int main(int argc, char* argv[]) {
     int rank, num_procs;
 
@@ -65,17 +69,35 @@ int main(int argc, char* argv[]) {
 
     double parallel_time = MPI_Wtime() - start_parallel;
 
+    // --- 2b. SAME SUM, BINNED: exact, so identical bits for any process count ---
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start_binned = MPI_Wtime();
+
+    repro_acc_t acc;
+    repro_init(&acc);
+    for (long long i = start_i; i < start_i + local_N; ++i) {
+        double x = (i + 0.5) / (double)N;
+        repro_add(&acc, 4.0 / (1.0 + x * x));
+    }
+    repro_mpi_reduce(&acc, 0, MPI_COMM_WORLD);
+
+    double binned_time = MPI_Wtime() - start_binned;
+
     // --- 3. PRINT RESULTS ---
     if (rank == 0) {
         double pi_parallel = global_sum / (double)N;
         double error = fabs(pi_parallel - M_PI);
 
         printf("\n--- PI CALCULATION RESULTS (N=%lld) ---\n", N);
+        double pi_binned = repro_value(&acc) / (double)N;
+
         printf("Calculated Pi (Parallel): %.15f\n", pi_parallel);
         printf("Error compared to M_PI:   %e\n", error);
+        printf("Calculated Pi (Binned):   %.17g (reproducible)\n", pi_binned);
         printf("\n--- PERFORMANCE ---\n");
         printf("Serial Time:   %f seconds\n", serial_time);
         printf("Parallel Time: %f seconds\n", parallel_time);
+        printf("Binned Time:   %f seconds\n", binned_time);
 
         double speedup = serial_time / parallel_time;
         printf("Speedup:       %f\n", speedup);
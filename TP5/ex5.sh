@@ -1,13 +1,13 @@
 #!/bin/bash
 
 
-mpicc -o pi_approxi ex5.c -lm
+mpicc -I../common -o pi_approxi ex5.c ../common/repro_sum.c -lm
 
 # Set iterations to 1 Billion
 N=1000000000
 echo "Starting Pi Calculation tests with N=$N iterations..."
 echo "--------------------------------------------------------"
-echo -e "Processes\tSpeedup\t\tEfficiency"
+echo -e "Processes\tSpeedup\t\tEfficiency\tPi (binned, same bits for every p)"
 echo "--------------------------------------------------------"
 
 # Loop through different numbers of processes
@@ -19,9 +19,10 @@ do
     # Extract the Speedup and Efficiency numbers using grep and awk
     speedup=$(echo "$output" | grep "Speedup:" | awk '{print $2}')
     efficiency=$(echo "$output" | grep "Efficiency:" | awk '{print $2}')
+    pi_binned=$(echo "$output" | grep "Pi (Binned):" | awk '{print $4}')
 
     # Print the values directly to the terminal screen
-    echo -e "$p\t\t$speedup\t$efficiency"
+    echo -e "$p\t\t$speedup\t$efficiency\t$pi_binned"
 done
 
 echo "--------------------------------------------------------"
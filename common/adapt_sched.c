@@ -0,0 +1,167 @@
+/* ================================================================
+ * Adaptive loop scheduling (see adapt_sched.h)
+ * ================================================================ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "adapt_sched.h"
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int max_threads(void)
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+const char *asched_kind_name(asched_kind_t k)
+{
+    static const char *names[] = {"static", "dynamic", "guided"};
+    return (k >= ASCHED_STATIC && k <= ASCHED_GUIDED) ? names[k] : "?";
+}
+
+/* Blocks of `chunk` iterations handed out one at a time with the
+ * runtime schedule: the same as schedule(kind, chunk) on the
+ * iterations, but the body sees whole chunks */
+void asched_run(asched_kind_t kind, long chunk, long lo, long hi, asched_fn fn, void *arg)
+{
+    long len = hi - lo;
+    if (len <= 0) return;
+    if (kind == ASCHED_STATIC && chunk <= 0) chunk = (len + max_threads() - 1) / max_threads();
+    if (chunk <= 0) chunk = 1;
+    long nb = (len + chunk - 1) / chunk;
+
+#ifdef _OPENMP
+    omp_sched_t saved;
+    int saved_chunk;
+    omp_get_schedule(&saved, &saved_chunk);
+    omp_set_schedule(kind == ASCHED_STATIC  ? omp_sched_static :
+                     kind == ASCHED_DYNAMIC ? omp_sched_dynamic : omp_sched_guided, 1);
+#endif
+    #pragma omp parallel for schedule(runtime)
+    for (long b = 0; b < nb; b++) {
+        long s = lo + b * chunk;
+        fn(s, (hi - s < chunk) ? hi : s + chunk, arg);
+    }
+#ifdef _OPENMP
+    omp_set_schedule(saved, saved_chunk);
+#endif
+}
+
+const asched_choice_t *asched_choice(const asched_site_t *site, long n, int threads)
+{
+    for (int i = 0; i < site->nchoices; i++)
+        if (site->c[i].n == n && site->c[i].threads == threads) return &site->c[i];
+    return NULL;
+}
+
+void asched_reset(asched_site_t *site)
+{
+    site->nchoices = 0;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Runs [0, probe_n) as timed dynamic chunks and fills the cost fields */
+static void probe(asched_choice_t *ch, long probe_n, int p, asched_fn fn, void *arg)
+{
+    long cp = probe_n / ((long)ASCHED_PROBE_CHUNKS * p);
+    if (cp < 1) cp = 1;
+    long nb = (probe_n + cp - 1) / cp;
+    double *t = malloc(sizeof(double) * nb);
+    if (!t) {
+        asched_run(ASCHED_DYNAMIC, cp, 0, probe_n, fn, arg);
+        ch->iter_cost = 0.0;
+        ch->cv = 0.0;
+        return;
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long b = 0; b < nb; b++) {
+        long s = b * cp, e = (probe_n - s < cp) ? probe_n : s + cp;
+        double t0 = now_sec();
+        fn(s, e, arg);
+        t[b] = (now_sec() - t0) / (e - s);
+    }
+
+    /* Mean for the cost; the spread from the median absolute deviation
+     * (x 1.4826 = stddev for normal data), so that a chunk stretched
+     * by an interrupt or a preemption does not count as imbalance */
+    double sum = 0.0;
+    for (long b = 0; b < nb; b++) sum += t[b];
+    ch->iter_cost = sum / nb;
+
+    qsort(t, nb, sizeof(double), cmp_double);
+    double med = t[nb / 2];
+    for (long b = 0; b < nb; b++) t[b] = fabs(t[b] - med);
+    qsort(t, nb, sizeof(double), cmp_double);
+    ch->cv = (nb > 1 && med > 0) ? 1.4826 * t[nb / 2] / med : 0.0;
+    free(t);
+}
+
+static void decide(asched_choice_t *ch, long rest, int p)
+{
+    long c_max = rest / ((long)ASCHED_CHUNKS * p);
+    long c = (ch->iter_cost > 0) ? (long)ceil(ASCHED_OVERHEAD / ASCHED_MAX_OVH / ch->iter_cost) : 1;
+    if (c > c_max) c = c_max;
+    if (c < 1) c = 1;
+
+    if (p == 1 || ch->cv < ASCHED_CV_STATIC) {
+        ch->kind = ASCHED_STATIC;
+        ch->chunk = 0;
+    } else {
+        ch->kind = (ch->cv < ASCHED_CV_GUIDED) ? ASCHED_GUIDED : ASCHED_DYNAMIC;
+        ch->chunk = c;
+    }
+}
+
+void asched_for(asched_site_t *site, long n, asched_fn fn, void *arg)
+{
+    int p = max_threads();
+    asched_choice_t *ch = (asched_choice_t *)asched_choice(site, n, p);
+
+    if (ch) {
+        ch->calls++;
+        asched_run(ch->kind, ch->chunk, 0, n, fn, arg);
+        return;
+    }
+
+    /* New (n, threads): the oldest slot is reused when full */
+    if (site->nchoices < ASCHED_SLOTS) {
+        ch = &site->c[site->nchoices++];
+    } else {
+        for (int i = 1; i < ASCHED_SLOTS; i++) site->c[i - 1] = site->c[i];
+        ch = &site->c[ASCHED_SLOTS - 1];
+    }
+    *ch = (asched_choice_t){.n = n, .threads = p, .calls = 1};
+
+    long probe_n = n / ASCHED_PROBE_DIV;
+    if (p == 1 || probe_n < (long)ASCHED_PROBE_CHUNKS * p) {
+        /* Nothing to balance, or too little to measure */
+        ch->kind = (p == 1) ? ASCHED_STATIC : ASCHED_DYNAMIC;
+        ch->chunk = (p == 1) ? 0 : 1;
+        asched_run(ch->kind, ch->chunk, 0, n, fn, arg);
+        return;
+    }
+
+    probe(ch, probe_n, p, fn, arg);
+    decide(ch, n - probe_n, p);
+    asched_run(ch->kind, ch->chunk, probe_n, n, fn, arg);
+}
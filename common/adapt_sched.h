@@ -0,0 +1,111 @@
+/* ================================================================
+ * Adaptive loop scheduling: static / guided / dynamic chosen online
+ * ================================================================
+ *
+ * schedule(runtime) + a shell script over OMP_SCHEDULE finds the best
+ * schedule by brute force, one process per setting.  asched_for()
+ * decides inside the run instead:
+ *
+ *   1. probe: the first n / ASCHED_PROBE_DIV iterations run as small
+ *      dynamic chunks, each one timed
+ *   2. from the probe, per iteration: mean cost t and spread
+ *      cv = 1.4826 MAD / median of the chunk costs (robust: a chunk
+ *      hit by a preemption is not taken for imbalance)
+ *        chunk   smallest one whose dispatch overhead (ASCHED_OVERHEAD
+ *                per chunk) stays under ASCHED_MAX_OVH of its work,
+ *                but at least ASCHED_CHUNKS chunks per thread remain
+ *        kind    static   (block)  cv < ASCHED_CV_STATIC, or 1 thread
+ *                guided   chunk    cv < ASCHED_CV_GUIDED
+ *                dynamic  chunk    otherwise
+ *   3. the rest of the loop runs with that choice
+ *
+ * The choice is cached in the call site, per (n, thread count): later
+ * calls skip the probe.  A call site is a static variable:
+ *
+ *   static asched_site_t site = ASCHED_SITE("matmul rows");
+ *   asched_for(&site, n, body, &args);       body(lo, hi, &args)
+ *
+ * The body gets ranges of iterations; every range is one chunk.
+ * asched_run() runs a loop with a fixed choice (what a schedule
+ * clause would do), e.g. to compare against.
+ *
+ * The probe only sees the first iterations: a cost that changes along
+ * the index (triangular loops) is caught as far as those show it.
+ * Call from serial code, like an "omp parallel for".
+ *
+ * COMPILATION: add  -fopenmp -I../common ../common/adapt_sched.c  to
+ * the compile line.
+ * ================================================================ */
+
+#ifndef ADAPT_SCHED_H
+#define ADAPT_SCHED_H
+
+#include <stddef.h>
+
+/* Share of the loop used for probing */
+#ifndef ASCHED_PROBE_DIV
+#define ASCHED_PROBE_DIV 8
+#endif
+
+/* Probe chunks per thread */
+#ifndef ASCHED_PROBE_CHUNKS
+#define ASCHED_PROBE_CHUNKS 8
+#endif
+
+/* Seconds to hand out one dynamic / guided chunk */
+#ifndef ASCHED_OVERHEAD
+#define ASCHED_OVERHEAD 2e-7
+#endif
+
+#ifndef ASCHED_MAX_OVH
+#define ASCHED_MAX_OVH 0.01
+#endif
+
+/* Chunks per thread a dynamic / guided loop keeps for balancing */
+#ifndef ASCHED_CHUNKS
+#define ASCHED_CHUNKS 4
+#endif
+
+#ifndef ASCHED_CV_STATIC
+#define ASCHED_CV_STATIC 0.1
+#endif
+
+#ifndef ASCHED_CV_GUIDED
+#define ASCHED_CV_GUIDED 0.5
+#endif
+
+/* Cached choices per call site */
+#define ASCHED_SLOTS 16
+
+typedef enum { ASCHED_STATIC = 0, ASCHED_DYNAMIC, ASCHED_GUIDED } asched_kind_t;
+
+typedef void (*asched_fn)(long lo, long hi, void *arg);
+
+typedef struct {
+    long          n;
+    int           threads;
+    asched_kind_t kind;
+    long          chunk;      /* 0 with static: one block per thread */
+    double        iter_cost;  /* seconds per iteration (probe mean)  */
+    double        cv;         /* spread of the probe chunk costs     */
+    long          calls;
+} asched_choice_t;
+
+typedef struct {
+    const char     *name;
+    int             nchoices;
+    asched_choice_t c[ASCHED_SLOTS];
+} asched_site_t;
+
+#define ASCHED_SITE(label) {(label), 0, {{0}}}
+
+const char *asched_kind_name(asched_kind_t k);
+
+void asched_for(asched_site_t *site, long n, asched_fn fn, void *arg);
+void asched_run(asched_kind_t kind, long chunk, long lo, long hi, asched_fn fn, void *arg);
+
+/* Cached choice for (n, threads), NULL if none yet */
+const asched_choice_t *asched_choice(const asched_site_t *site, long n, int threads);
+void asched_reset(asched_site_t *site);
+
+#endif /* ADAPT_SCHED_H */
@@ -0,0 +1,431 @@
+/* ================================================================
+ * Benchmark harness: repeated timing, statistics, JSON/CSV output
+ * (see bench_harness.h)
+ * ================================================================ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "bench_harness.h"
+
+typedef struct {
+    int    warmup, min_reps, max_reps;
+    double ci, max_time;
+    int    pin, list;
+    const char *filter, *json, *csv;
+} bench_config_t;
+
+static bench_config_t cfg = {1, 3, 30, 0.02, 10.0, 1, 0, NULL, NULL, NULL};
+static const char *suite_name = "bench";
+
+static bench_case_t   cases[BENCH_MAX_CASES];
+static bench_result_t results[BENCH_MAX_CASES];
+static int            selected[BENCH_MAX_CASES];
+static int            n_cases = 0;
+
+/* Two-sided 95% Student t quantiles for 1..30 degrees of freedom */
+static const double t95[31] = {
+    0.0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* ----------------------------------------------------------------
+ * Configuration
+ * ---------------------------------------------------------------- */
+
+void bench_defaults(int warmup, int min_reps, int max_reps, double max_time)
+{
+    cfg.warmup = warmup;
+    cfg.min_reps = min_reps;
+    cfg.max_reps = max_reps;
+    cfg.max_time = max_time;
+}
+
+int bench_init(const char *suite, int *argc, char **argv)
+{
+    int out = 1, status = 0;
+
+    suite_name = suite;
+    for (int a = 1; a < *argc; a++) {
+        const char *arg = argv[a];
+
+        if (strncmp(arg, "--warmup=", 9) == 0) {
+            cfg.warmup = atoi(arg + 9);
+        } else if (strncmp(arg, "--reps=", 7) == 0) {
+            int lo, hi;
+            if (sscanf(arg + 7, "%d:%d", &lo, &hi) == 2) {
+                cfg.min_reps = lo;
+                cfg.max_reps = hi;
+            } else {
+                cfg.min_reps = cfg.max_reps = atoi(arg + 7);
+            }
+        } else if (strncmp(arg, "--ci=", 5) == 0) {
+            cfg.ci = atof(arg + 5);
+        } else if (strncmp(arg, "--max-time=", 11) == 0) {
+            cfg.max_time = atof(arg + 11);
+        } else if (strncmp(arg, "--filter=", 9) == 0) {
+            cfg.filter = arg + 9;
+        } else if (strncmp(arg, "--json=", 7) == 0) {
+            cfg.json = arg + 7;
+        } else if (strncmp(arg, "--csv=", 6) == 0) {
+            cfg.csv = arg + 6;
+        } else if (strcmp(arg, "--no-pin") == 0) {
+            cfg.pin = 0;
+        } else if (strcmp(arg, "--list") == 0) {
+            cfg.list = 1;
+        } else {
+            argv[out++] = argv[a];
+        }
+    }
+    *argc = out;
+    argv[out] = NULL;
+
+    if (cfg.min_reps < 1 || cfg.max_reps < cfg.min_reps || cfg.warmup < 0) {
+        fprintf(stderr, "[bench] invalid --reps/--warmup (need 1 <= MIN <= MAX, warmup >= 0)\n");
+        status = -1;
+    }
+    return status;
+}
+
+int bench_add(const bench_case_t *c)
+{
+    if (n_cases == BENCH_MAX_CASES) {
+        fprintf(stderr, "[bench] too many cases (max %d)\n", BENCH_MAX_CASES);
+        exit(EXIT_FAILURE);
+    }
+    cases[n_cases] = *c;
+    return n_cases++;
+}
+
+const bench_result_t *bench_result(const char *name)
+{
+    for (int c = 0; c < n_cases; c++)
+        if (selected[c] && strcmp(cases[c].name, name) == 0)
+            return &results[c];
+    return NULL;
+}
+
+/* ----------------------------------------------------------------
+ * Thread placement
+ * ---------------------------------------------------------------- */
+
+/* Affinity of the process before the first case, and the largest
+ * team pinned since (restored by unpin_threads) */
+static cpu_set_t allowed;
+static int n_allowed = -1;
+static int pinned_team = 0;
+
+/* Thread t of the team goes to the t-th CPU of the allowed set */
+static void pin_threads(void)
+{
+    if (!cfg.pin || getenv("OMP_PROC_BIND")) return;
+    if (n_allowed < 0) {
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            n_allowed = 0;
+            return;
+        }
+        n_allowed = CPU_COUNT(&allowed);
+    }
+    if (n_allowed == 0) return;
+
+#ifdef _OPENMP
+    int team = omp_get_max_threads();
+    #pragma omp parallel
+#else
+    int team = 1;
+#endif
+    {
+        int t = 0;
+#ifdef _OPENMP
+        t = omp_get_thread_num();
+#endif
+        int target = t % n_allowed, seen = 0;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (!CPU_ISSET(cpu, &allowed)) continue;
+            if (seen++ == target) {
+                cpu_set_t one;
+                CPU_ZERO(&one);
+                CPU_SET(cpu, &one);
+                sched_setaffinity(0, sizeof(one), &one);
+                break;
+            }
+        }
+    }
+    if (team > pinned_team) pinned_team = team;
+}
+
+/* Give the master and the pool threads back the original CPU set, so
+ * code after bench_run() is not left on one CPU */
+static void unpin_threads(void)
+{
+    if (pinned_team == 0) return;
+
+#ifdef _OPENMP
+    #pragma omp parallel num_threads(pinned_team)
+#endif
+    sched_setaffinity(0, sizeof(allowed), &allowed);
+    pinned_team = 0;
+}
+
+/* ----------------------------------------------------------------
+ * Measurement
+ * ---------------------------------------------------------------- */
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void summarize(bench_result_t *r, double *t, int n)
+{
+    double sum = 0.0, sq = 0.0;
+
+    for (int i = 0; i < n; i++) sum += t[i];
+    r->mean = sum / n;
+    for (int i = 0; i < n; i++) sq += (t[i] - r->mean) * (t[i] - r->mean);
+    r->stddev = (n > 1) ? sqrt(sq / (n - 1)) : 0.0;
+
+    double tq = (n - 1 <= 30) ? t95[n - 1 > 0 ? n - 1 : 1] : 1.960;
+    r->ci_rel = (n > 1 && r->mean > 0) ? tq * r->stddev / sqrt((double)n) / r->mean : INFINITY;
+
+    qsort(t, n, sizeof(double), cmp_double);
+    r->min = t[0];
+    r->max = t[n - 1];
+    r->median = (n % 2) ? t[n / 2] : 0.5 * (t[n / 2 - 1] + t[n / 2]);
+}
+
+static void run_case(const bench_case_t *c, bench_result_t *r)
+{
+    double *t = malloc(cfg.max_reps * sizeof(double));
+    if (!t) {
+        fprintf(stderr, "[bench] Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+#ifdef _OPENMP
+    if (c->threads > 0) omp_set_num_threads(c->threads);
+    r->threads = omp_get_max_threads();
+#else
+    r->threads = 1;
+#endif
+    pin_threads();
+
+    for (int w = 0; w < cfg.warmup; w++) {
+        if (c->setup) c->setup(c->ctx);
+        c->run(c->ctx);
+    }
+
+    double budget_start = now_sec();
+    int n = 0;
+    r->converged = 0;
+    while (n < cfg.max_reps) {
+        if (c->setup) c->setup(c->ctx);
+
+        if (n == 0) {
+            perf_region_begin(&r->perf, c->name);
+            c->run(c->ctx);
+            perf_region_end(&r->perf);
+            t[n++] = r->perf.seconds;
+        } else {
+            double t0 = now_sec();
+            c->run(c->ctx);
+            t[n++] = now_sec() - t0;
+        }
+
+        if (n >= cfg.min_reps) {
+            bench_result_t tmp;
+            double *copy = malloc(n * sizeof(double));
+            memcpy(copy, t, n * sizeof(double));
+            summarize(&tmp, copy, n);
+            free(copy);
+            if (tmp.ci_rel <= cfg.ci) {
+                r->converged = 1;
+                break;
+            }
+            if (now_sec() - budget_start > cfg.max_time) break;
+        }
+    }
+
+    r->name = c->name;
+    r->reps = n;
+    summarize(r, t, n);
+    r->gflops = (c->flops > 0) ? c->flops / r->median / 1e9 : 0.0;
+    r->gbps = (c->bytes > 0) ? c->bytes / r->median / 1e9 : 0.0;
+    free(t);
+}
+
+/* ----------------------------------------------------------------
+ * Output
+ * ---------------------------------------------------------------- */
+
+static FILE *open_output(const char *path)
+{
+    if (strcmp(path, "-") == 0) return stdout;
+    FILE *f = fopen(path, "w");
+    if (!f) perror(path);
+    return f;
+}
+
+static void close_output(FILE *f)
+{
+    if (f && f != stdout) fclose(f);
+}
+
+/* Quoted JSON string: escapes quotes, backslashes and control characters */
+static void json_string(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s; s++) {
+        unsigned char ch = (unsigned char)*s;
+        if (ch == '"' || ch == '\\') fprintf(f, "\\%c", ch);
+        else if (ch == '\n') fputs("\\n", f);
+        else if (ch == '\t') fputs("\\t", f);
+        else if (ch < 0x20) fprintf(f, "\\u%04x", ch);
+        else fputc(ch, f);
+    }
+    fputc('"', f);
+}
+
+/* JSON numbers cannot be NaN/Inf */
+static void json_number(FILE *f, const char *key, double v, int last)
+{
+    if (isfinite(v)) fprintf(f, "\"%s\": %.9g%s", key, v, last ? "" : ", ");
+    else fprintf(f, "\"%s\": null%s", key, last ? "" : ", ");
+}
+
+static void write_json(const char *path)
+{
+    FILE *f = open_output(path);
+    char host[256] = "unknown";
+    if (!f) return;
+    gethostname(host, sizeof(host) - 1);
+
+    fprintf(f, "{\n  \"suite\": ");
+    json_string(f, suite_name);
+    fprintf(f, ",\n  \"host\": ");
+    json_string(f, host);
+    fprintf(f, ",\n  \"timestamp\": %ld,\n", (long)time(NULL));
+    fprintf(f, "  \"config\": {\"warmup\": %d, \"min_reps\": %d, \"max_reps\": %d, "
+               "\"ci\": %g, \"max_time\": %g, \"pinned\": %s},\n",
+            cfg.warmup, cfg.min_reps, cfg.max_reps, cfg.ci, cfg.max_time,
+            (cfg.pin && !getenv("OMP_PROC_BIND")) ? "true" : "false");
+    fprintf(f, "  \"cases\": [");
+
+    int first = 1;
+    for (int c = 0; c < n_cases; c++) {
+        if (!selected[c]) continue;
+        const bench_result_t *r = &results[c];
+        fprintf(f, "%s\n    {\"name\": ", first ? "" : ",");
+        json_string(f, r->name);
+        fprintf(f, ", \"threads\": %d, \"reps\": %d, \"converged\": %s, ",
+                r->threads, r->reps, r->converged ? "true" : "false");
+        json_number(f, "median_s", r->median, 0);
+        json_number(f, "min_s", r->min, 0);
+        json_number(f, "max_s", r->max, 0);
+        json_number(f, "mean_s", r->mean, 0);
+        json_number(f, "stddev_s", r->stddev, 0);
+        json_number(f, "ci_rel", r->ci_rel, 0);
+        json_number(f, "gflops", r->gflops, 0);
+        json_number(f, "gbps", r->gbps, 0);
+        fprintf(f, "\"counters\": {");
+        json_number(f, "ipc", perf_ipc(&r->perf) >= 0 ? perf_ipc(&r->perf) : NAN, 0);
+        json_number(f, "l1d_miss_rate", perf_l1d_miss_rate(&r->perf) >= 0 ? perf_l1d_miss_rate(&r->perf) : NAN, 0);
+        json_number(f, "llc_miss_rate", perf_llc_miss_rate(&r->perf) >= 0 ? perf_llc_miss_rate(&r->perf) : NAN, 0);
+        json_number(f, "dtlb_misses", perf_dtlb_misses(&r->perf) >= 0 ? perf_dtlb_misses(&r->perf) : NAN, 0);
+        json_number(f, "flop_per_byte", perf_flop_per_byte(&r->perf) >= 0 ? perf_flop_per_byte(&r->perf) : NAN, 1);
+        fprintf(f, "}}");
+        first = 0;
+    }
+    fprintf(f, "\n  ]\n}\n");
+    close_output(f);
+}
+
+static void write_csv(const char *path)
+{
+    FILE *f = open_output(path);
+    if (!f) return;
+
+    fprintf(f, "suite,case,threads,reps,median_s,min_s,max_s,mean_s,stddev_s,ci_rel,"
+               "gflops,gbps,converged\n");
+    for (int c = 0; c < n_cases; c++) {
+        if (!selected[c]) continue;
+        const bench_result_t *r = &results[c];
+        fprintf(f, "%s,%s,%d,%d,%.9g,%.9g,%.9g,%.9g,%.9g,%.6g,%.6g,%.6g,%d\n",
+                suite_name, r->name, r->threads, r->reps, r->median, r->min, r->max,
+                r->mean, r->stddev, r->ci_rel, r->gflops, r->gbps, r->converged);
+    }
+    close_output(f);
+}
+
+static void print_rule(FILE *out)
+{
+    fprintf(out, "------------------------------------------------------------------------"
+                 "-----------------------------------%s\n", perf_table_rule());
+}
+
+void bench_run(void)
+{
+    /* Machine-readable output on stdout pushes the table to stderr */
+    FILE *out = ((cfg.json && strcmp(cfg.json, "-") == 0) ||
+                 (cfg.csv && strcmp(cfg.csv, "-") == 0)) ? stderr : stdout;
+
+    for (int c = 0; c < n_cases; c++)
+        selected[c] = !cfg.filter || strstr(cases[c].name, cfg.filter) != NULL;
+
+    if (cfg.list) {
+        for (int c = 0; c < n_cases; c++)
+            if (selected[c]) printf("%s\n", cases[c].name);
+        exit(EXIT_SUCCESS);
+    }
+
+    fprintf(out, "Suite: %s | warm-up %d | reps %d..%d until CI95 <= %.1f%% (max %.0f s/case)\n",
+            suite_name, cfg.warmup, cfg.min_reps, cfg.max_reps, cfg.ci * 100, cfg.max_time);
+    print_rule(out);
+    fprintf(out, "| %-20s | Thr  | Reps | Median (s) | Min (s)    | Stddev (s) | CI95    "
+                 "| GFLOPS   | GB/s     %s\n", "Case", perf_table_header());
+    print_rule(out);
+
+    for (int c = 0; c < n_cases; c++) {
+        if (!selected[c]) continue;
+        bench_result_t *r = &results[c];
+        char ci[16], gf[16], bw[16], cells[160];
+
+        run_case(&cases[c], r);
+
+        if (isfinite(r->ci_rel)) snprintf(ci, sizeof(ci), "%5.1f%%%s", r->ci_rel * 100, r->converged ? "" : "*");
+        else snprintf(ci, sizeof(ci), "n/a");
+        if (r->gflops > 0) snprintf(gf, sizeof(gf), "%.3f", r->gflops);
+        else snprintf(gf, sizeof(gf), "-");
+        if (r->gbps > 0) snprintf(bw, sizeof(bw), "%.3f", r->gbps);
+        else snprintf(bw, sizeof(bw), "-");
+        perf_table_cells(&r->perf, cells, sizeof(cells));
+
+        fprintf(out, "| %-20s | %-4d | %-4d | %-10.6f | %-10.6f | %-10.6f | %-7s | %-8s | %-8s %s\n",
+                r->name, r->threads, r->reps, r->median, r->min, r->stddev, ci, gf, bw, cells);
+        fflush(out);
+    }
+    print_rule(out);
+    fprintf(out, "(* = CI target not reached within the repetition/time budget)\n");
+    unpin_threads();
+
+    if (cfg.json) write_json(cfg.json);
+    if (cfg.csv) write_csv(cfg.csv);
+}
@@ -0,0 +1,88 @@
+/* ================================================================
+ * Benchmark harness: repeated timing, statistics, JSON/CSV output
+ * ================================================================
+ *
+ * A program registers its kernels as named cases, then calls
+ * bench_run().  For every case the harness
+ *
+ *   1. sets the case's thread count and pins the threads (one per
+ *      allowed CPU, unless OMP_PROC_BIND is already set),
+ *   2. runs `warmup` untimed repetitions,
+ *   3. repeats the timed run until the 95% confidence interval of
+ *      the mean is within `ci` of the mean (at least min_reps, at
+ *      most max_reps repetitions or max_time seconds),
+ *   4. keeps median / min / max / mean / stddev, and the hardware
+ *      counters (perf_counters.h) of the first timed repetition.
+ *
+ * After the last case the threads get their original CPU set back.
+ * The thread count stays at that of the last case.
+ *
+ * setup() (optional) runs before every repetition and is not timed,
+ * e.g. to reset an output array.
+ *
+ * Results go to a table on stdout and, on request, to JSON and CSV
+ * files for the regression dashboards.  Command-line options (removed
+ * from argv by bench_init):
+ *
+ *   --warmup=N          untimed repetitions              (default 1)
+ *   --reps=N | MIN:MAX  timed repetitions                (default 3:30)
+ *   --ci=F              target relative CI half-width    (default 0.02)
+ *   --max-time=S        time budget per case in seconds  (default 10)
+ *   --filter=TEXT       only cases whose name contains TEXT
+ *   --json=FILE         write results as JSON ("-" = stdout)
+ *   --csv=FILE          write results as CSV  ("-" = stdout)
+ *   --no-pin            leave thread placement to the OS
+ *   --list              print the case names and exit
+ *
+ * When JSON or CSV goes to stdout the table is printed on stderr.
+ *
+ * COMPILATION: add  -I../common ../common/bench_harness.c
+ * ../common/perf_counters.c -lm  to the compile line.
+ * ================================================================ */
+
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include "perf_counters.h"
+
+#ifndef BENCH_MAX_CASES
+#define BENCH_MAX_CASES 256
+#endif
+
+typedef struct {
+    const char *name;
+    void (*setup)(void *ctx);   /* may be NULL                        */
+    void (*run)(void *ctx);     /* the timed kernel                   */
+    void *ctx;
+    int    threads;             /* 0 = leave the OpenMP setting alone */
+    double flops;               /* per run, 0 if not meaningful       */
+    double bytes;               /* per run (model), 0 if unknown      */
+} bench_case_t;
+
+typedef struct {
+    const char *name;
+    int    threads;
+    int    reps;
+    int    converged;           /* CI target reached                  */
+    double median, min, max, mean, stddev;
+    double ci_rel;              /* 95% CI half-width / mean           */
+    double gflops, gbps;        /* from the median, 0 if no model     */
+    perf_region_t perf;         /* counters of the first timed rep    */
+} bench_result_t;
+
+/* Per-program defaults, call before bench_init() */
+void bench_defaults(int warmup, int min_reps, int max_reps, double max_time);
+
+/* Parse and remove the harness options; returns 0, or -1 on a bad value */
+int  bench_init(const char *suite, int *argc, char **argv);
+
+/* Register a case (copied); returns its index */
+int  bench_add(const bench_case_t *c);
+
+/* Run every selected case, print the table, write JSON/CSV */
+void bench_run(void);
+
+/* Result of a case after bench_run(), NULL if it was filtered out */
+const bench_result_t *bench_result(const char *name);
+
+#endif /* BENCH_HARNESS_H */
@@ -0,0 +1,228 @@
+/* ================================================================
+ * Learned task costs and longest-first scheduling (see cost_model.h)
+ * ================================================================ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "cost_model.h"
+
+typedef struct {
+    int    task;
+    long   lo, hi;
+    double estimate;
+    double result;
+    double seconds;
+} piece_t;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int max_threads(void)
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/* ----------------------------------------------------------------
+ * Model
+ * ---------------------------------------------------------------- */
+
+static cm_entry_t *find(const cost_model_t *m, const char *name)
+{
+    for (int i = 0; i < m->n; i++)
+        if (strcmp(m->e[i].name, name) == 0) return (cm_entry_t *)&m->e[i];
+    return NULL;
+}
+
+int cm_load(cost_model_t *m, const char *path)
+{
+    memset(m, 0, sizeof(*m));
+    m->alpha = CM_ALPHA;
+    snprintf(m->path, sizeof(m->path), "%s", path);
+
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+
+    char line[256];
+    int rc = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        cm_entry_t e;
+        if (sscanf(line, "%31s %ld %lf", e.name, &e.samples, &e.per_unit) != 3 ||
+            e.per_unit <= 0.0) {
+            fprintf(stderr, "cm_load: %s: bad line '%s'\n", path, strtok(line, "\n"));
+            rc = -1;
+            continue;
+        }
+        if (m->n < CM_MAX_TYPES && !find(m, e.name)) m->e[m->n++] = e;
+    }
+    fclose(f);
+    return rc;
+}
+
+int cm_save(const cost_model_t *m)
+{
+    FILE *f = fopen(m->path, "w");
+    if (!f) {
+        perror(m->path);
+        return -1;
+    }
+    fprintf(f, "# name samples seconds_per_unit (EWMA, alpha = %g)\n", m->alpha);
+    for (int i = 0; i < m->n; i++)
+        fprintf(f, "%s %ld %.6e\n", m->e[i].name, m->e[i].samples, m->e[i].per_unit);
+    fclose(f);
+    return 0;
+}
+
+double cm_cost(const cost_model_t *m, const char *name)
+{
+    const cm_entry_t *e = find(m, name);
+    return e ? e->per_unit : -1.0;
+}
+
+void cm_record(cost_model_t *m, const char *name, long units, double seconds)
+{
+    if (units <= 0 || seconds <= 0.0) return;
+    double c = seconds / units;
+
+    cm_entry_t *e = find(m, name);
+    if (!e) {
+        if (m->n == CM_MAX_TYPES) return;
+        e = &m->e[m->n++];
+        snprintf(e->name, sizeof(e->name), "%s", name);
+        e->samples = 0;
+        e->per_unit = c;
+    }
+    e->per_unit = (e->samples == 0) ? c : m->alpha * c + (1.0 - m->alpha) * e->per_unit;
+    e->samples++;
+}
+
+void cm_print(const cost_model_t *m, FILE *f)
+{
+    fprintf(f, "| %-16s | %7s | %14s |\n", "Task type", "Samples", "ns per unit");
+    for (int i = 0; i < m->n; i++)
+        fprintf(f, "| %-16s | %7ld | %14.3f |\n", m->e[i].name, m->e[i].samples,
+                m->e[i].per_unit * 1e9);
+}
+
+/* ----------------------------------------------------------------
+ * Scheduling
+ * ---------------------------------------------------------------- */
+
+static int by_estimate(const void *a, const void *b)
+{
+    const piece_t *x = a, *y = b;
+    if (x->estimate != y->estimate) return (x->estimate < y->estimate) ? 1 : -1;
+    if (x->task != y->task) return x->task - y->task;
+    return (x->lo > y->lo) - (x->lo < y->lo);
+}
+
+static int by_position(const void *a, const void *b)
+{
+    const piece_t *x = a, *y = b;
+    if (x->task != y->task) return x->task - y->task;
+    return (x->lo > y->lo) - (x->lo < y->lo);
+}
+
+double cm_run(cost_model_t *m, cm_task_t *tasks, int ntasks, FILE *log)
+{
+    int p = max_threads();
+
+    /* 1. Estimates */
+    double known = 0.0;
+    int nknown = 0;
+    for (int k = 0; k < ntasks; k++) {
+        double c = cm_cost(m, tasks[k].name);
+        if (c > 0) {
+            known += c;
+            nknown++;
+        }
+    }
+    double fallback = nknown ? known / nknown : 1.0;   /* empty model: units */
+    double total = 0.0;
+    for (int k = 0; k < ntasks; k++) {
+        double c = cm_cost(m, tasks[k].name);
+        long units = tasks[k].hi - tasks[k].lo;
+        tasks[k].estimate = units > 0 ? (c > 0 ? c : fallback) * (double)units : 0.0;
+        total += tasks[k].estimate;
+    }
+
+    /* 2. Pieces of at most total / (p * CM_PIECES) */
+    double target = total / ((double)p * CM_PIECES);
+    long npieces = 0;
+    for (int k = 0; k < ntasks; k++) {
+        long units = tasks[k].hi - tasks[k].lo, grain = tasks[k].grain > 0 ? tasks[k].grain : 1;
+        long np = (target > 0 && p > 1) ? (long)(tasks[k].estimate / target + 0.999) : 1;
+        if (np > units / grain) np = units / grain;
+        if (np < 1) np = 1;
+        if (units <= 0) np = 0;                /* empty task: nothing to run */
+        tasks[k].pieces = (int)np;
+        npieces += np;
+    }
+
+    piece_t *pc = malloc(sizeof(piece_t) * (npieces > 0 ? npieces : 1));
+    if (!pc) return -1.0;
+    long n = 0;
+    for (int k = 0; k < ntasks; k++) {
+        long units = tasks[k].hi - tasks[k].lo, np = tasks[k].pieces;
+        for (long j = 0; j < np; j++) {
+            long lo = tasks[k].lo + units * j / np, hi = tasks[k].lo + units * (j + 1) / np;
+            pc[n++] = (piece_t){k, lo, hi, tasks[k].estimate * (hi - lo) / units, 0.0, 0.0};
+        }
+    }
+
+    /* 3. Longest first, next piece to the next free thread */
+    qsort(pc, npieces, sizeof(piece_t), by_estimate);
+    if (log) {
+        fprintf(log, "Plan (%d threads, longest first):", p);
+        for (int k = 0; k < ntasks; k++) {
+            if (tasks[k].pieces == 0)
+                fprintf(log, " %s empty", tasks[k].name);
+            else if (nknown)
+                fprintf(log, " %s %d x %.4f s", tasks[k].name, tasks[k].pieces,
+                        tasks[k].estimate / tasks[k].pieces);
+            else
+                fprintf(log, " %s %d x %ld units", tasks[k].name, tasks[k].pieces,
+                        (tasks[k].hi - tasks[k].lo) / tasks[k].pieces);
+            fprintf(log, "%s", k + 1 < ntasks ? "," : "\n");
+        }
+    }
+
+    double t0 = now_sec();
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long i = 0; i < npieces; i++) {
+        const cm_task_t *t = &tasks[pc[i].task];
+        double s = now_sec();
+        pc[i].result = t->fn(pc[i].lo, pc[i].hi, t->arg);
+        pc[i].seconds = now_sec() - s;
+    }
+    double wall = now_sec() - t0;
+
+    /* 4. Results in piece order, measured costs into the model */
+    qsort(pc, npieces, sizeof(piece_t), by_position);
+    for (int k = 0; k < ntasks; k++) {
+        tasks[k].result = 0.0;
+        tasks[k].measured = 0.0;
+    }
+    for (long i = 0; i < npieces; i++) {
+        tasks[pc[i].task].result += pc[i].result;
+        tasks[pc[i].task].measured += pc[i].seconds;
+    }
+    for (int k = 0; k < ntasks; k++)
+        cm_record(m, tasks[k].name, tasks[k].hi - tasks[k].lo, tasks[k].measured);
+
+    free(pc);
+    return wall;
+}
@@ -0,0 +1,104 @@
+/* ================================================================
+ * Learned task costs and longest-first scheduling
+ * ================================================================
+ *
+ * Instead of guessing task priorities, let the runs measure them.
+ * A cost model keeps, per named task type, an exponentially weighted
+ * average of the measured seconds per unit of work
+ *
+ *   c <- alpha * measured + (1 - alpha) * c      (first sample: c = measured)
+ *
+ * and is saved to a small text file between runs.  cm_run() uses it
+ * to schedule a set of tasks, each a range [lo, hi) of units:
+ *
+ *   1. estimate every task (units x c; types never seen get the mean
+ *      cost of the known ones, or 1 when the model is empty)
+ *   2. split tasks larger than total / (threads x CM_PIECES) into
+ *      pieces of about that size (never below the task's grain)
+ *   3. sort the pieces longest first and hand them out in that order
+ *      to whichever thread is free (LPT list scheduling: within 4/3
+ *      of the best finish time, closer with small pieces)
+ *   4. time every piece and feed the measured cost back into the model
+ *
+ *   cost_model_t m;
+ *   cm_load(&m, "ex3_costs.txt");             missing file: empty model
+ *   cm_task_t t[3] = {{"light", 0, N, 1000, light, NULL},
+ *                     {"moderate", 0, 5 * N, 1000, moderate, NULL},
+ *                     {"heavy", 0, 20 * N, 1000, heavy, NULL}};
+ *   cm_run(&m, t, 3, stdout);                 t[k].result, plan on stdout
+ *   cm_save(&m);
+ *
+ * Piece results are added in piece order, so a task's result only
+ * depends on how it was split.  Threads: OpenMP (one at a time without
+ * -fopenmp).  Measured times include any time the thread was
+ * descheduled, so learn on an unloaded machine.
+ *
+ * File format, one line per type:  name samples seconds_per_unit
+ *
+ * COMPILATION: add  -fopenmp -I../common ../common/cost_model.c  to
+ * the compile line.
+ * ================================================================ */
+
+#ifndef COST_MODEL_H
+#define COST_MODEL_H
+
+#include <stdio.h>
+
+#define CM_MAX_TYPES 32
+#define CM_NAME_LEN  32
+#define CM_PATH_LEN  256
+
+/* Weight of the newest run */
+#ifndef CM_ALPHA
+#define CM_ALPHA 0.3
+#endif
+
+/* Pieces per thread a large task is cut into */
+#ifndef CM_PIECES
+#define CM_PIECES 4
+#endif
+
+typedef double (*cm_body_fn)(long lo, long hi, void *arg);
+
+typedef struct {
+    char   name[CM_NAME_LEN];
+    long   samples;          /* runs that measured this type */
+    double per_unit;         /* seconds per unit             */
+} cm_entry_t;
+
+typedef struct {
+    char       path[CM_PATH_LEN];
+    double     alpha;
+    int        n;
+    cm_entry_t e[CM_MAX_TYPES];
+} cost_model_t;
+
+typedef struct {
+    const char *name;        /* task type: the key of the model */
+    long        lo, hi;      /* units of work                   */
+    long        grain;       /* smallest piece                  */
+    cm_body_fn  fn;
+    void       *arg;
+    double      result;      /* sum of fn over the pieces       */
+    double      estimate;    /* seconds, before the run         */
+    double      measured;    /* seconds, summed over pieces     */
+    int         pieces;
+} cm_task_t;
+
+/* Reads the model from path (kept for cm_save); a missing file gives
+ * an empty model.  0, or -1 on a malformed file */
+int cm_load(cost_model_t *m, const char *path);
+/* 0, or -1 when the file cannot be written */
+int cm_save(const cost_model_t *m);
+
+/* Seconds per unit of a type, or -1 when never measured */
+double cm_cost(const cost_model_t *m, const char *name);
+void   cm_record(cost_model_t *m, const char *name, long units, double seconds);
+
+/* Runs the tasks as described above, updates the model and returns
+ * the wall time; log (may be NULL) gets the plan */
+double cm_run(cost_model_t *m, cm_task_t *tasks, int ntasks, FILE *log);
+
+void cm_print(const cost_model_t *m, FILE *f);
+
+#endif /* COST_MODEL_H */
@@ -0,0 +1,199 @@
+/* ================================================================
+ * Dense matrix-vector product (see dmvm.h)
+ * ================================================================ */
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "dmvm.h"
+#include "simd_reduce.h"
+
+#define AVX2_TARGET   "avx2,fma"
+#define AVX512_TARGET "avx512f"
+
+/* ----------------------------------------------------------------
+ * Kernel: y[0..len) += A[0..len, 0..nc) x[0..nc), 4 columns a pass
+ * ---------------------------------------------------------------- */
+
+typedef void (*dmvm_kernel_t)(int len, int nc, const double *A, size_t lda,
+                              const double *x, double *y);
+
+#define DMVM_KERNEL(isa, ATTR)                                                      \
+    ATTR static void kernel_##isa(int len, int nc, const double *A, size_t lda,     \
+                                  const double *x, double *restrict y)              \
+    {                                                                               \
+        int j = 0;                                                                  \
+        for (; j + 4 <= nc; j += 4) {                                               \
+            const double *restrict a0 = A + j * lda, *restrict a1 = a0 + lda;       \
+            const double *restrict a2 = a1 + lda, *restrict a3 = a2 + lda;          \
+            double x0 = x[j], x1 = x[j + 1], x2 = x[j + 2], x3 = x[j + 3];          \
+            _Pragma("omp simd")                                                     \
+            for (int r = 0; r < len; r++)                                           \
+                y[r] += (a0[r] * x0 + a1[r] * x1) + (a2[r] * x2 + a3[r] * x3);      \
+        }                                                                           \
+        for (; j < nc; j++) {                                                       \
+            const double *restrict a0 = A + j * lda;                                \
+            double x0 = x[j];                                                       \
+            _Pragma("omp simd")                                                     \
+            for (int r = 0; r < len; r++) y[r] += a0[r] * x0;                       \
+        }                                                                           \
+    }
+
+DMVM_KERNEL(sse2, )
+DMVM_KERNEL(avx2, __attribute__((target(AVX2_TARGET))))
+DMVM_KERNEL(avx512, __attribute__((target(AVX512_TARGET))))
+
+static dmvm_kernel_t pick_kernel(void)
+{
+    switch (reduce_isa()) {
+    case REDUCE_ISA_AVX512: return kernel_avx512;
+    case REDUCE_ISA_AVX2:   return kernel_avx2;
+    default:                return kernel_sse2;
+    }
+}
+
+/* ----------------------------------------------------------------
+ * Blocked walk over rows [r0, r1) x columns [c0, c1)
+ * ---------------------------------------------------------------- */
+
+static void block_walk(dmvm_kernel_t kern, int r0, int r1, int c0, int c1, int k,
+                       const double *A, size_t lda, const double *X, size_t ldx,
+                       double *Y, size_t ldy)
+{
+    /* k slices of Y of mb rows each stay in L1 */
+    int mb = DMVM_Y_L1 / k;
+    mb = (mb < 64) ? 64 : mb & ~7;
+    int nb = (k == 1) ? c1 - c0 : DMVM_NB;   /* one vector: nothing to reuse */
+    if (nb < 1) nb = 1;
+
+    for (int i = r0; i < r1; i += mb) {
+        int len = (r1 - i < mb) ? r1 - i : mb;
+        for (int j = c0; j < c1; j += nb) {
+            int nc = (c1 - j < nb) ? c1 - j : nb;
+            for (int v = 0; v < k; v++)
+                kern(len, nc, A + i + j * lda, lda, X + j + v * ldx, Y + i + v * ldy);
+        }
+    }
+}
+
+/* [lo, hi) of 0 .. total for part t of p, boundaries on multiples of align */
+static void split(int total, int p, int t, int align, int *lo, int *hi)
+{
+    long per = ((long)total + p - 1) / p;
+    per = (per + align - 1) / align * align;
+    long a = per * t, b = a + per;
+    *lo = (int)(a < total ? a : total);
+    *hi = (int)(b < total ? b : total);
+}
+
+static int num_threads(void)
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+static int thread_id(void)
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+static int team_size(void)
+{
+#ifdef _OPENMP
+    return omp_get_num_threads();
+#else
+    return 1;
+#endif
+}
+
+/* ----------------------------------------------------------------
+ * Public API
+ * ---------------------------------------------------------------- */
+
+const char *dmvm_part_name(dmvm_part_t p)
+{
+    static const char *names[] = {"auto", "rows", "cols"};
+    return (p >= DMVM_AUTO && p <= DMVM_COLS) ? names[p] : "?";
+}
+
+dmvm_part_t dmvm_auto_part(int m, int n, int threads)
+{
+    if (threads <= 1) return DMVM_ROWS;
+    return (m / threads < DMVM_ROWS_MIN && n >= threads) ? DMVM_COLS : DMVM_ROWS;
+}
+
+void dmvm_multi(int m, int n, int k, const double *A, int lda,
+                const double *X, int ldx, double *Y, int ldy, dmvm_part_t part)
+{
+    if (m <= 0 || n <= 0 || k <= 0) return;
+    dmvm_kernel_t kern = pick_kernel();
+    int p = num_threads();
+    if (part == DMVM_AUTO) part = dmvm_auto_part(m, n, p);
+
+    if (part == DMVM_ROWS || p == 1) {
+        #pragma omp parallel
+        {
+            int r0, r1;
+            split(m, team_size(), thread_id(), 8, &r0, &r1);
+            block_walk(kern, r0, r1, 0, n, k, A, lda, X, ldx, Y, ldy);
+        }
+        return;
+    }
+
+    /* COLS: one m x k partial per thread, stride mp keeps them on
+     * separate lines */
+    size_t mp = ((size_t)m + 7) & ~(size_t)7;
+    double *part_buf = aligned_alloc(64, sizeof(double) * mp * k * p);
+    if (!part_buf) {
+        dmvm_multi(m, n, k, A, lda, X, ldx, Y, ldy, DMVM_ROWS);
+        return;
+    }
+
+    #pragma omp parallel
+    {
+        int t = thread_id(), nt = team_size();
+        double *mine = part_buf + (size_t)t * mp * k;
+        int c0, c1;
+
+        memset(mine, 0, sizeof(double) * mp * k);
+        split(n, nt, t, 1, &c0, &c1);
+        block_walk(kern, 0, m, c0, c1, k, A, lda, X, ldx, mine, mp);
+
+        /* Pairwise tree: after round s, partial t holds t .. t+2s-1 */
+        for (int s = 1; s < nt; s *= 2) {
+            #pragma omp barrier
+            if (t % (2 * s) == 0 && t + s < nt) {
+                const double *other = part_buf + (size_t)(t + s) * mp * k;
+                #pragma omp simd
+                for (size_t i = 0; i < mp * k; i++) mine[i] += other[i];
+            }
+        }
+        #pragma omp barrier
+
+        int r0, r1;
+        split(m, nt, t, 8, &r0, &r1);
+        for (int v = 0; v < k; v++) {
+            double *y = Y + (size_t)v * ldy;
+            const double *root = part_buf + (size_t)v * mp;
+            #pragma omp simd
+            for (int r = r0; r < r1; r++) y[r] += root[r];
+        }
+    }
+    free(part_buf);
+}
+
+void dmvm(int m, int n, const double *A, int lda, const double *x, double *y,
+          dmvm_part_t part)
+{
+    dmvm_multi(m, n, 1, A, lda, x, n, y, m, part);
+}
@@ -0,0 +1,73 @@
+/* ================================================================
+ * Dense matrix-vector product y += A x, and A X for several x
+ * ================================================================
+ *
+ * A is m x n, column-major with leading dimension lda >= m (the
+ * layout of TP4/ex4.c: element (r, c) at A[r + c * lda]).  Two ways
+ * to share the work, both without races or a barrier per column:
+ *
+ *   DMVM_ROWS   each thread owns a contiguous block of rows (rounded
+ *               to 8 rows = one cache line of y), runs over all
+ *               columns and writes only its own part of y
+ *   DMVM_COLS   each thread owns a contiguous block of columns, which
+ *               is one contiguous stretch of A, and accumulates into a
+ *               private m-long buffer; the buffers are then added in
+ *               a pairwise tree (log2(p) rounds, fixed order) and the
+ *               root is added to y by all threads, by rows
+ *   DMVM_AUTO   COLS when a row block would be under DMVM_ROWS_MIN
+ *               rows (short strips of every column, lines shared by
+ *               two threads), ROWS otherwise
+ *
+ * The inner loop adds 4 columns per pass (one load and store of y
+ * per 4 FMAs) and is compiled for SSE2, AVX2+FMA and AVX-512, picked
+ * at run time through reduce_isa() (REDUCE_ISA= also applies).
+ *
+ * dmvm_multi() computes Y += A X for k right-hand sides (X n x k,
+ * Y m x k, column-major): A is walked in blocks of DMVM_Y_L1 / k rows
+ * x DMVM_NB columns, and every block is used for all k vectors while
+ * it is in cache, so A crosses the memory bus once instead of k
+ * times.  dmvm() is dmvm_multi() with k = 1.
+ *
+ * Threads: OpenMP (serial without -fopenmp).  Results differ from
+ * the plain loop in the last bits (4-column sums; tree for COLS), but
+ * not between runs with the same thread count.
+ *
+ * COMPILATION: add  -fopenmp -I../common ../common/dmvm.c
+ * ../common/simd_reduce.c  to the compile line.
+ * ================================================================ */
+
+#ifndef DMVM_H
+#define DMVM_H
+
+/* Elements of Y kept in L1 while a block of A is used: rows per
+ * block = DMVM_Y_L1 / k */
+#ifndef DMVM_Y_L1
+#define DMVM_Y_L1 4096
+#endif
+
+/* Columns per block of A (reused for the k vectors) */
+#ifndef DMVM_NB
+#define DMVM_NB 64
+#endif
+
+/* Smallest row block worth giving a thread */
+#ifndef DMVM_ROWS_MIN
+#define DMVM_ROWS_MIN 256
+#endif
+
+typedef enum { DMVM_AUTO = 0, DMVM_ROWS, DMVM_COLS } dmvm_part_t;
+
+const char *dmvm_part_name(dmvm_part_t p);
+
+/* What DMVM_AUTO picks for this shape and thread count */
+dmvm_part_t dmvm_auto_part(int m, int n, int threads);
+
+/* y += A x */
+void dmvm(int m, int n, const double *A, int lda, const double *x, double *y,
+          dmvm_part_t part);
+
+/* Y[:, j] += A X[:, j], j < k */
+void dmvm_multi(int m, int n, int k, const double *A, int lda,
+                const double *X, int ldx, double *Y, int ldy, dmvm_part_t part);
+
+#endif /* DMVM_H */
@@ -0,0 +1,306 @@
+/* ================================================================
+ * Strided / indexed gather and scatter (see gather.h)
+ * ================================================================ */
+
+#include <stdlib.h>
+#include <immintrin.h>
+
+#include "gather.h"
+#include "simd_reduce.h"
+
+#define AVX2_TARGET   "avx2,fma"
+#define AVX512_TARGET "avx512f"
+
+static int g_pf = -1;
+
+int gather_set_prefetch(int dist)
+{
+    int old = gather_prefetch();
+    g_pf = dist < 0 ? 0 : dist;
+    return old;
+}
+
+int gather_prefetch(void)
+{
+    if (g_pf < 0) {
+        const char *env = getenv("GATHER_PF");
+        g_pf = env ? atoi(env) : GATHER_PF_DIST;
+        if (g_pf < 0) g_pf = 0;
+    }
+    return g_pf;
+}
+
+const char *gather_strategy_name(gather_strategy_t s)
+{
+    static const char *names[GATHER_NSTRATEGIES] = {"auto", "plain", "prefetch", "simd", "transpose"};
+    return (s >= 0 && s < GATHER_NSTRATEGIES) ? names[s] : "?";
+}
+
+/* AUTO: the hardware prefetcher handles strides below one line */
+static gather_strategy_t resolve(gather_strategy_t s, size_t stride)
+{
+    if (s != GATHER_AUTO) return s;
+    return (stride * sizeof(double) < 64) ? GATHER_PLAIN : GATHER_PREFETCH;
+}
+
+/* ----------------------------------------------------------------
+ * Scalar kernels.  pf_n >= n is how many elements may be prefetched
+ * (a blocked caller prefetches into its next block).  Prefetches go
+ * to all cache levels: the non-temporal hint (locality 0) lost lines
+ * before their load and ran slower than no prefetch at all.
+ * ---------------------------------------------------------------- */
+
+static void strided_plain(double *restrict dst, const double *restrict src, size_t n, size_t stride)
+{
+    for (size_t i = 0; i < n; i++) dst[i] = src[i * stride];
+}
+
+static void strided_prefetch(double *restrict dst, const double *restrict src, size_t n,
+                             size_t stride, size_t pf_n)
+{
+    size_t d = (size_t)gather_prefetch(), i = 0;
+    size_t stop = pf_n > d ? pf_n - d : 0;
+
+    for (; i < n && i < stop; i++) {
+        __builtin_prefetch(src + (i + d) * stride, 0, 3);
+        dst[i] = src[i * stride];
+    }
+    for (; i < n; i++) dst[i] = src[i * stride];
+}
+
+static void indexed_prefetch(double *restrict dst, const double *restrict src,
+                             const size_t *restrict idx, size_t n)
+{
+    size_t d = (size_t)gather_prefetch(), i = 0;
+
+    for (; i + d < n; i++) {
+        __builtin_prefetch(src + idx[i + d], 0, 3);
+        dst[i] = src[idx[i]];
+    }
+    for (; i < n; i++) dst[i] = src[idx[i]];
+}
+
+static void scatter_strided_prefetch(double *restrict dst, const double *restrict src,
+                                     size_t n, size_t stride)
+{
+    size_t d = (size_t)gather_prefetch(), i = 0;
+
+    for (; i + d < n; i++) {
+        __builtin_prefetch(dst + (i + d) * stride, 1, 3);
+        dst[i * stride] = src[i];
+    }
+    for (; i < n; i++) dst[i * stride] = src[i];
+}
+
+static void scatter_indexed_prefetch(double *dst, const double *src, const size_t *idx, size_t n)
+{
+    size_t d = (size_t)gather_prefetch(), i = 0;
+
+    for (; i + d < n; i++) {
+        __builtin_prefetch(dst + idx[i + d], 1, 3);
+        dst[idx[i]] = src[i];
+    }
+    for (; i < n; i++) dst[idx[i]] = src[i];
+}
+
+/* ----------------------------------------------------------------
+ * Gather / scatter instructions
+ * ---------------------------------------------------------------- */
+
+__attribute__((target(AVX2_TARGET)))
+static void strided_avx2(double *restrict dst, const double *restrict src, size_t n,
+                         size_t stride, size_t pf_n)
+{
+    size_t d = (size_t)gather_prefetch(), i = 0;
+    long long s = (long long)stride;
+    __m256i lanes = _mm256_setr_epi64x(0, s, 2 * s, 3 * s);
+
+    for (; i + 4 <= n; i += 4) {
+        if (d && i + d + 4 <= pf_n)
+            for (size_t k = 0; k < 4; k++) __builtin_prefetch(src + (i + d + k) * stride, 0, 3);
+        _mm256_storeu_pd(dst + i, _mm256_i64gather_pd(src + i * stride, lanes, 8));
+    }
+    for (; i < n; i++) dst[i] = src[i * stride];
+}
+
+__attribute__((target(AVX2_TARGET)))
+static void indexed_avx2(double *restrict dst, const double *restrict src,
+                         const size_t *restrict idx, size_t n)
+{
+    size_t d = (size_t)gather_prefetch(), i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        if (d && i + d + 4 <= n)
+            for (size_t k = 0; k < 4; k++) __builtin_prefetch(src + idx[i + d + k], 0, 3);
+        __m256i v = _mm256_loadu_si256((const __m256i *)(idx + i));
+        _mm256_storeu_pd(dst + i, _mm256_i64gather_pd(src, v, 8));
+    }
+    for (; i < n; i++) dst[i] = src[idx[i]];
+}
+
+__attribute__((target(AVX512_TARGET)))
+static void strided_avx512(double *restrict dst, const double *restrict src, size_t n,
+                           size_t stride, size_t pf_n)
+{
+    size_t d = (size_t)gather_prefetch(), i = 0;
+    long long s = (long long)stride;
+    __m512i lanes = _mm512_setr_epi64(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s);
+
+    for (; i + 8 <= n; i += 8) {
+        if (d && i + d + 8 <= pf_n)
+            for (size_t k = 0; k < 8; k++) __builtin_prefetch(src + (i + d + k) * stride, 0, 3);
+        _mm512_storeu_pd(dst + i, _mm512_i64gather_pd(lanes, src + i * stride, 8));
+    }
+    for (; i < n; i++) dst[i] = src[i * stride];
+}
+
+__attribute__((target(AVX512_TARGET)))
+static void indexed_avx512(double *restrict dst, const double *restrict src,
+                           const size_t *restrict idx, size_t n)
+{
+    size_t d = (size_t)gather_prefetch(), i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        if (d && i + d + 8 <= n)
+            for (size_t k = 0; k < 8; k++) __builtin_prefetch(src + idx[i + d + k], 0, 3);
+        __m512i v = _mm512_loadu_si512(idx + i);
+        _mm512_storeu_pd(dst + i, _mm512_i64gather_pd(v, src, 8));
+    }
+    for (; i < n; i++) dst[i] = src[idx[i]];
+}
+
+/* Lanes are written from the lowest up, so a repeated index keeps the
+ * last value, as in the scalar loop */
+__attribute__((target(AVX512_TARGET)))
+static void scatter_strided_avx512(double *restrict dst, const double *restrict src,
+                                   size_t n, size_t stride)
+{
+    long long s = (long long)stride;
+    __m512i lanes = _mm512_setr_epi64(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+        _mm512_i64scatter_pd(dst + i * stride, lanes, _mm512_loadu_pd(src + i), 8);
+    for (; i < n; i++) dst[i * stride] = src[i];
+}
+
+__attribute__((target(AVX512_TARGET)))
+static void scatter_indexed_avx512(double *dst, const double *src, const size_t *idx, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+        _mm512_i64scatter_pd(dst, _mm512_loadu_si512(idx + i), _mm512_loadu_pd(src + i), 8);
+    for (; i < n; i++) dst[idx[i]] = src[i];
+}
+
+/* ----------------------------------------------------------------
+ * Public API
+ * ---------------------------------------------------------------- */
+
+static void strided(double *dst, const double *src, size_t n, size_t stride,
+                    size_t pf_n, gather_strategy_t s)
+{
+    switch (resolve(s, stride)) {
+    case GATHER_PREFETCH:
+        strided_prefetch(dst, src, n, stride, pf_n);
+        break;
+    case GATHER_SIMD:
+        if (reduce_isa() == REDUCE_ISA_AVX512)    strided_avx512(dst, src, n, stride, pf_n);
+        else if (reduce_isa() == REDUCE_ISA_AVX2) strided_avx2(dst, src, n, stride, pf_n);
+        else                                      strided_prefetch(dst, src, n, stride, pf_n);
+        break;
+    case GATHER_TRANSPOSE:
+        gather_transpose(dst, src, n, stride, 1);
+        break;
+    default:
+        strided_plain(dst, src, n, stride);
+        break;
+    }
+}
+
+void gather_strided(double *dst, const double *src, size_t n, size_t stride,
+                    gather_strategy_t s)
+{
+    strided(dst, src, n, stride, n, s);
+}
+
+void gather_indexed(double *dst, const double *src, const size_t *idx, size_t n,
+                    gather_strategy_t s)
+{
+    switch (s) {
+    case GATHER_PLAIN:
+        for (size_t i = 0; i < n; i++) dst[i] = src[idx[i]];
+        break;
+    case GATHER_SIMD:
+        if (reduce_isa() == REDUCE_ISA_AVX512)    indexed_avx512(dst, src, idx, n);
+        else if (reduce_isa() == REDUCE_ISA_AVX2) indexed_avx2(dst, src, idx, n);
+        else                                      indexed_prefetch(dst, src, idx, n);
+        break;
+    default:   /* no layout to transpose: AUTO and TRANSPOSE prefetch */
+        indexed_prefetch(dst, src, idx, n);
+        break;
+    }
+}
+
+void scatter_strided(double *dst, const double *src, size_t n, size_t stride,
+                     gather_strategy_t s)
+{
+    s = resolve(s, stride);
+    if (s == GATHER_SIMD && reduce_isa() == REDUCE_ISA_AVX512)
+        scatter_strided_avx512(dst, src, n, stride);
+    else if (s == GATHER_PREFETCH || s == GATHER_SIMD)
+        scatter_strided_prefetch(dst, src, n, stride);
+    else
+        for (size_t i = 0; i < n; i++) dst[i * stride] = src[i];
+}
+
+void scatter_indexed(double *dst, const double *src, const size_t *idx, size_t n,
+                     gather_strategy_t s)
+{
+    if (s == GATHER_PLAIN)
+        for (size_t i = 0; i < n; i++) dst[idx[i]] = src[i];
+    else if (s == GATHER_SIMD && reduce_isa() == REDUCE_ISA_AVX512)
+        scatter_indexed_avx512(dst, src, idx, n);
+    else
+        scatter_indexed_prefetch(dst, src, idx, n);
+}
+
+void gather_transpose(double *dst, const double *src, size_t n, size_t stride,
+                      size_t ncols)
+{
+    if (ncols > stride) ncols = stride;
+
+    /* The first column brings the block's rows into cache, the other
+     * columns hit them; every column leaves as one sequential run */
+    for (size_t r0 = 0; r0 < n; r0 += GATHER_TBLOCK) {
+        size_t r1 = (n - r0 < GATHER_TBLOCK) ? n : r0 + GATHER_TBLOCK;
+        for (size_t c = 0; c < ncols; c++) {
+            double *restrict out = dst + c * n;
+            for (size_t r = r0; r < r1; r++) out[r] = src[r * stride + c];
+        }
+    }
+}
+
+#define GATHER_SUM_BLOCK 1024
+
+double gather_sum_strided(const double *src, size_t n, size_t stride, gather_strategy_t s)
+{
+    double buf[GATHER_SUM_BLOCK];
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+
+    for (size_t i0 = 0; i0 < n; i0 += GATHER_SUM_BLOCK) {
+        size_t len = (n - i0 < GATHER_SUM_BLOCK) ? n - i0 : GATHER_SUM_BLOCK;
+        strided(buf, src + i0 * stride, len, stride, n - i0, s);
+
+        size_t k = 0;
+        for (; k + 4 <= len; k += 4) {
+            s0 += buf[k];
+            s1 += buf[k + 1];
+            s2 += buf[k + 2];
+            s3 += buf[k + 3];
+        }
+        for (; k < len; k++) s0 += buf[k];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
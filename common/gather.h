@@ -0,0 +1,92 @@
+/* ================================================================
+ * Strided / indexed gather and scatter with software prefetch
+ * ================================================================
+ *
+ * Past a stride of one cache line every element read brings in a
+ * whole 64-byte line for 8 useful bytes, and the hardware prefetcher
+ * (which tracks consecutive lines, within a 4 KiB page) stops
+ * helping: each load waits for DRAM.  The strategies below attack
+ * the latency part of that loss; the bytes per element are set by
+ * the stride and cannot be recovered except by using the rest of
+ * the line (GATHER_TRANSPOSE).
+ *
+ *   GATHER_PLAIN      the loop as written
+ *   GATHER_PREFETCH   + __builtin_prefetch of the element pf_dist
+ *                     iterations ahead, so that many misses are in
+ *                     flight instead of the few the out-of-order window
+ *                     finds on its own
+ *   GATHER_SIMD       AVX2 / AVX-512 gather instructions (reduce_isa()
+ *                     picks the path) + the same prefetch; scatter
+ *                     instructions exist on AVX-512 only
+ *   GATHER_TRANSPOSE  strided only: the array is seen as rows of
+ *                     `stride` doubles and ncols columns are extracted
+ *                     together, GATHER_TBLOCK rows at a time (blocked
+ *                     transpose, each column stored as one sequential
+ *                     run), so every line fetched is used ncols times;
+ *                     worth it when the caller needs those columns
+ *   GATHER_AUTO       PLAIN below a stride of one line, PREFETCH above
+ *                     (what the TP1/gather_bench.c sweep shows on the
+ *                     machines we have; hardware gathers rarely beat
+ *                     scalar loads once the data is not in cache)
+ *
+ * The prefetch distance (in elements, default GATHER_PF_DIST) is set
+ * with gather_set_prefetch() or the GATHER_PF environment variable;
+ * the best value grows with memory latency x bandwidth.
+ *
+ * COMPILATION: add  -I../common ../common/gather.c
+ * ../common/simd_reduce.c  to the compile line.
+ * ================================================================ */
+
+#ifndef GATHER_H
+#define GATHER_H
+
+#include <stddef.h>
+
+#ifndef GATHER_PF_DIST
+#define GATHER_PF_DIST 32
+#endif
+
+/* Rows per block of the transpose strategy */
+#ifndef GATHER_TBLOCK
+#define GATHER_TBLOCK 64
+#endif
+
+typedef enum {
+    GATHER_AUTO = 0,
+    GATHER_PLAIN,
+    GATHER_PREFETCH,
+    GATHER_SIMD,
+    GATHER_TRANSPOSE,
+    GATHER_NSTRATEGIES
+} gather_strategy_t;
+
+const char *gather_strategy_name(gather_strategy_t s);
+
+/* Prefetch distance in elements (0 disables); returns the previous one */
+int gather_set_prefetch(int dist);
+int gather_prefetch(void);
+
+/* dst[i] = src[i * stride], i < n (TRANSPOSE: as ncols = 1) */
+void gather_strided(double *dst, const double *src, size_t n, size_t stride,
+                    gather_strategy_t s);
+/* dst[i] = src[idx[i]] */
+void gather_indexed(double *dst, const double *src, const size_t *idx, size_t n,
+                    gather_strategy_t s);
+/* dst[i * stride] = src[i] */
+void scatter_strided(double *dst, const double *src, size_t n, size_t stride,
+                     gather_strategy_t s);
+/* dst[idx[i]] = src[i]; a repeated index keeps the last value */
+void scatter_indexed(double *dst, const double *src, const size_t *idx, size_t n,
+                     gather_strategy_t s);
+
+/* Columns 0 .. ncols-1 of the n x stride row-major array src, column
+ * c to dst[c * n .. c * n + n) (ncols <= stride) */
+void gather_transpose(double *dst, const double *src, size_t n, size_t stride,
+                      size_t ncols);
+
+/* Sum of src[i * stride], i < n, through the chosen strategy (gathers
+ * into an L1 buffer, then a 4-accumulator sum) */
+double gather_sum_strided(const double *src, size_t n, size_t stride,
+                          gather_strategy_t s);
+
+#endif /* GATHER_H */
@@ -0,0 +1,242 @@
+/* ================================================================
+ * Shared allocation layer for the large benchmark arrays
+ * (see hpc_alloc.h)
+ * ================================================================ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "hpc_alloc.h"
+
+#define HUGE_2M (2UL * 1024 * 1024)
+
+/* MPOL_INTERLEAVE from <numaif.h>, without a libnuma dependency */
+#define HPC_MPOL_INTERLEAVE 3
+#define HPC_MAX_NODES 1024
+
+/*
+ * Every block is preceded by one cache line holding how it was
+ * obtained, so hpc_free() can release it correctly.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t mode;
+    void    *base;     /* start of the malloc block or mapping */
+    size_t   length;   /* mapping length (mmap modes only)     */
+} block_header_t;
+
+#define HPC_MAGIC 0x48504341u   /* "HPCA" */
+
+static hpc_alloc_mode_t g_mode = HPC_ALLOC_MALLOC;
+static int g_interleave = 0;
+static int g_hugetlb_warned = 0;
+
+static const char *mode_names[] = {"malloc", "aligned", "thp", "hugetlb"};
+
+/* ----------------------------------------------------------------
+ * Policy
+ * ---------------------------------------------------------------- */
+
+void hpc_alloc_set_mode(hpc_alloc_mode_t mode, int interleave)
+{
+    g_mode = mode;
+    g_interleave = interleave;
+}
+
+hpc_alloc_mode_t hpc_alloc_get_mode(void)
+{
+    return g_mode;
+}
+
+int hpc_alloc_parse_args(int *argc, char **argv)
+{
+    int out = 1, status = 0;
+
+    for (int a = 1; a < *argc; a++) {
+        if (strncmp(argv[a], "--alloc=", 8) == 0) {
+            const char *v = argv[a] + 8;
+            int found = 0;
+            for (int m = 0; m < 4; m++) {
+                if (strcmp(v, mode_names[m]) == 0) {
+                    g_mode = (hpc_alloc_mode_t)m;
+                    found = 1;
+                }
+            }
+            if (!found) {
+                fprintf(stderr, "Unknown --alloc mode '%s' (malloc|aligned|thp|hugetlb)\n", v);
+                status = -1;
+            }
+        } else if (strcmp(argv[a], "--interleave") == 0) {
+            g_interleave = 1;
+        } else {
+            argv[out++] = argv[a];
+        }
+    }
+    *argc = out;
+    argv[out] = NULL;
+    return status;
+}
+
+const char *hpc_alloc_describe(void)
+{
+    static char buf[64];
+    snprintf(buf, sizeof(buf), "%s%s", mode_names[g_mode],
+             g_interleave ? "+interleave" : "");
+    return buf;
+}
+
+/* ----------------------------------------------------------------
+ * NUMA interleaving
+ * ---------------------------------------------------------------- */
+
+/* Build a mask of the online nodes from /sys; returns the highest node + 1 */
+static int online_nodes(unsigned long *mask, int words)
+{
+    FILE *f = fopen("/sys/devices/system/node/online", "r");
+    char buf[256];
+    int max_node = 0;
+
+    memset(mask, 0, words * sizeof(unsigned long));
+    if (!f) return 0;
+    if (!fgets(buf, sizeof(buf), f)) {
+        fclose(f);
+        return 0;
+    }
+    fclose(f);
+
+    /* Format: "0", "0-3", "0-1,4-5" */
+    for (char *tok = strtok(buf, ",\n"); tok; tok = strtok(NULL, ",\n")) {
+        int lo, hi;
+        if (sscanf(tok, "%d-%d", &lo, &hi) != 2) {
+            lo = hi = atoi(tok);
+        }
+        for (int nd = lo; nd <= hi && nd < words * (int)(8 * sizeof(unsigned long)); nd++) {
+            mask[nd / (8 * sizeof(unsigned long))] |= 1UL << (nd % (8 * sizeof(unsigned long)));
+            if (nd + 1 > max_node) max_node = nd + 1;
+        }
+    }
+    return max_node;
+}
+
+static void interleave_range(void *addr, size_t len)
+{
+    unsigned long mask[HPC_MAX_NODES / (8 * sizeof(unsigned long))];
+    int words = sizeof(mask) / sizeof(mask[0]);
+    int nodes = online_nodes(mask, words);
+
+    if (nodes <= 1) return;   /* nothing to spread over */
+    if (syscall(SYS_mbind, addr, len, HPC_MPOL_INTERLEAVE, mask,
+                (unsigned long)HPC_MAX_NODES, 0) != 0)
+        perror("[hpc_alloc] mbind(MPOL_INTERLEAVE)");
+}
+
+/* ----------------------------------------------------------------
+ * Allocation
+ * ---------------------------------------------------------------- */
+
+static void *finish_block(void *base, size_t length, hpc_alloc_mode_t mode, char *data)
+{
+    block_header_t *h = (block_header_t *)(data - HPC_ALLOC_ALIGN);
+    h->magic = HPC_MAGIC;
+    h->mode = mode;
+    h->base = base;
+    h->length = length;
+    return data;
+}
+
+static void *alloc_mapped(size_t bytes, int hugetlb)
+{
+    size_t need = bytes + HPC_ALLOC_ALIGN;
+
+    if (hugetlb) {
+        size_t length = ((need + HUGE_2M - 1) / HUGE_2M) * HUGE_2M;
+        void *base = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base != MAP_FAILED) {
+            if (g_interleave) interleave_range(base, length);
+            return finish_block(base, length, HPC_ALLOC_HUGETLB,
+                                (char *)base + HPC_ALLOC_ALIGN);
+        }
+        if (!g_hugetlb_warned) {
+            fprintf(stderr, "[hpc_alloc] MAP_HUGETLB failed (no reserved 2 MiB pages?), "
+                            "falling back to thp\n");
+            g_hugetlb_warned = 1;
+        }
+    }
+
+    /* Over-map by 2 MiB so the data can start on a huge page boundary */
+    size_t length = ((need + HUGE_2M - 1) / HUGE_2M) * HUGE_2M + HUGE_2M;
+    char *base = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return NULL;
+
+    char *aligned = (char *)(((uintptr_t)base + HUGE_2M - 1) & ~(uintptr_t)(HUGE_2M - 1));
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, length - (aligned - base), MADV_HUGEPAGE);
+#endif
+    if (g_interleave) interleave_range(aligned, length - (aligned - base));
+    return finish_block(base, length, HPC_ALLOC_THP, aligned + HPC_ALLOC_ALIGN);
+}
+
+void *hpc_malloc(size_t bytes)
+{
+    if (bytes == 0) bytes = 1;
+
+    if (g_mode == HPC_ALLOC_THP || g_mode == HPC_ALLOC_HUGETLB)
+        return alloc_mapped(bytes, g_mode == HPC_ALLOC_HUGETLB);
+
+    /* malloc / aligned: one spare cache line in front for the header */
+    size_t total = bytes + 2 * HPC_ALLOC_ALIGN;
+    char *base = (g_mode == HPC_ALLOC_ALIGNED)
+                     ? aligned_alloc(HPC_ALLOC_ALIGN, ((total + HPC_ALLOC_ALIGN - 1) / HPC_ALLOC_ALIGN) * HPC_ALLOC_ALIGN)
+                     : malloc(total);
+    if (!base) return NULL;
+
+    char *data = (char *)(((uintptr_t)base + 2 * HPC_ALLOC_ALIGN - 1) & ~(uintptr_t)(HPC_ALLOC_ALIGN - 1));
+    if (g_interleave && bytes >= HUGE_2M) {
+        /* Only whole pages can get a policy; the first touch decides the rest */
+        long page = sysconf(_SC_PAGESIZE);
+        uintptr_t lo = ((uintptr_t)data + page - 1) & ~(uintptr_t)(page - 1);
+        uintptr_t hi = ((uintptr_t)data + bytes) & ~(uintptr_t)(page - 1);
+        if (hi > lo) interleave_range((void *)lo, hi - lo);
+    }
+    return finish_block(base, 0, g_mode, data);
+}
+
+void *hpc_calloc(size_t count, size_t size)
+{
+    size_t bytes = count * size;
+    if (size != 0 && bytes / size != count) return NULL;   /* overflow */
+
+    void *p = hpc_malloc(bytes);
+    if (!p) return NULL;
+
+    /* Fresh anonymous mappings are already zero */
+    hpc_alloc_mode_t mode = ((block_header_t *)((char *)p - HPC_ALLOC_ALIGN))->mode;
+    if (mode == HPC_ALLOC_MALLOC || mode == HPC_ALLOC_ALIGNED)
+        memset(p, 0, bytes);
+    return p;
+}
+
+void hpc_free(void *p)
+{
+    if (!p) return;
+
+    block_header_t *h = (block_header_t *)((char *)p - HPC_ALLOC_ALIGN);
+    if (h->magic != HPC_MAGIC) {
+        fprintf(stderr, "[hpc_alloc] hpc_free: pointer %p was not allocated by hpc_malloc\n", p);
+        abort();
+    }
+    h->magic = 0;
+
+    if (h->mode == HPC_ALLOC_THP || h->mode == HPC_ALLOC_HUGETLB)
+        munmap(h->base, h->length);
+    else
+        free(h->base);
+}
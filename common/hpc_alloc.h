@@ -0,0 +1,65 @@
+/* ================================================================
+ * Shared allocation layer for the large benchmark arrays
+ * ================================================================
+ *
+ * All blocks are at least 64-byte aligned (one cache line, one
+ * AVX-512 vector).  The backing memory is chosen once per program,
+ * normally from the command line:
+ *
+ *   --alloc=malloc    (default) one malloc() of the size plus two cache
+ *                     lines, the data 64-byte aligned after the block
+ *                     header; 4 KiB pages unless the system THP mode is
+ *                     "always".  hpc_calloc() zeroes with memset, so the
+ *                     pages are touched at allocation, unlike calloc
+ *   --alloc=aligned   64-byte aligned_alloc, 4 KiB pages
+ *   --alloc=thp       2 MiB aligned anonymous mmap + madvise(MADV_HUGEPAGE)
+ *                     (transparent huge pages, "madvise" mode is enough)
+ *   --alloc=hugetlb   explicit 2 MiB pages, mmap(MAP_HUGETLB); needs
+ *                     reserved pages (vm.nr_hugepages), falls back to
+ *                     thp with a warning otherwise
+ *   --interleave      spread the pages round-robin over all NUMA nodes
+ *                     (mbind MPOL_INTERLEAVE; ignored on 1-node systems)
+ *
+ * Blocks must be released with hpc_free(), whatever the mode.
+ *
+ * To show the effect of the page size next to the throughput, time
+ * the kernel in a perf_counters.h region and print
+ * perf_dtlb_misses().
+ *
+ * COMPILATION: add  -I../common ../common/hpc_alloc.c  to the
+ * compile line of the benchmark.
+ * ================================================================ */
+
+#ifndef HPC_ALLOC_H
+#define HPC_ALLOC_H
+
+#include <stddef.h>
+
+typedef enum {
+    HPC_ALLOC_MALLOC = 0,
+    HPC_ALLOC_ALIGNED,
+    HPC_ALLOC_THP,
+    HPC_ALLOC_HUGETLB
+} hpc_alloc_mode_t;
+
+#define HPC_ALLOC_ALIGN 64
+
+/* Global policy (default: malloc, no interleave) */
+void hpc_alloc_set_mode(hpc_alloc_mode_t mode, int interleave);
+hpc_alloc_mode_t hpc_alloc_get_mode(void);
+
+/*
+ * Consume --alloc=... and --interleave from argv (argc/argv are
+ * compacted so the program's own argument parsing is unchanged).
+ * Returns 0, or -1 on an unknown --alloc value.
+ */
+int hpc_alloc_parse_args(int *argc, char **argv);
+
+/* "thp+interleave" etc., for the benchmark header */
+const char *hpc_alloc_describe(void);
+
+void *hpc_malloc(size_t bytes);
+void *hpc_calloc(size_t count, size_t size);   /* zero-filled */
+void  hpc_free(void *p);
+
+#endif /* HPC_ALLOC_H */
@@ -0,0 +1,146 @@
+/* ================================================================
+ * Jacobi solver (see jacobi.h)
+ * ================================================================ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "jacobi.h"
+#include "simd_reduce.h"
+
+#define JACOBI_TILE 64
+
+/* Per-thread maxima, one cache line each */
+#define SLOT_STRIDE 8
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int max_threads(void)
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/* dst[i*n+j] = src[j*n+i], tile by tile */
+static void transpose(int n, const double *src, double *dst)
+{
+    #pragma omp parallel for schedule(static)
+    for (int ii = 0; ii < n; ii += JACOBI_TILE) {
+        int i1 = (ii + JACOBI_TILE < n) ? ii + JACOBI_TILE : n;
+        for (int jj = 0; jj < n; jj += JACOBI_TILE) {
+            int j1 = (jj + JACOBI_TILE < n) ? jj + JACOBI_TILE : n;
+            for (int i = ii; i < i1; i++)
+                for (int j = jj; j < j1; j++)
+                    dst[(size_t)i * n + j] = src[(size_t)j * n + i];
+        }
+    }
+}
+
+jacobi_result_t jacobi_solve(int n, const double *A, jacobi_layout_t layout,
+                             const double *b, double *x, double tol, int max_iter)
+{
+    jacobi_result_t res = {0, 0.0, 0.0, 0.0, 0.0};
+    int p = max_threads();
+    double *rows = NULL;
+
+    if (n <= 0) return res;
+    double *xw = aligned_alloc(64, sizeof(double) * (((size_t)n + 7) & ~(size_t)7));
+    double *slot = aligned_alloc(64, sizeof(double) * 2 * SLOT_STRIDE * p);
+    if (layout == JACOBI_COL_MAJOR)
+        rows = aligned_alloc(64, sizeof(double) * ((((size_t)n * n) + 7) & ~(size_t)7));
+    if (!xw || !slot || (layout == JACOBI_COL_MAJOR && !rows)) {
+        free(xw);
+        free(slot);
+        free(rows);
+        res.iterations = -1;
+        return res;
+    }
+
+    double t0 = now_sec();
+    if (rows) {
+        transpose(n, A, rows);
+        A = rows;
+    }
+    double t1 = now_sec();
+    res.transpose = t1 - t0;
+
+    int iterations = 0;
+    double norm = 0.0;
+    double *final_x = x;
+
+    /* The first call picks the SIMD path and caches it in a static:
+     * do it here, not concurrently from every thread */
+    reduce_isa();
+
+    #pragma omp parallel
+    {
+        double *xo = x, *xn = xw;
+        int it = 0;
+#ifdef _OPENMP
+        int t = omp_get_thread_num(), nt = omp_get_num_threads();
+#else
+        int t = 0, nt = 1;
+#endif
+
+        for (;;) {
+            it++;
+            double local = 0.0;
+
+            #pragma omp for schedule(static) nowait
+            for (int i = 0; i < n; i++) {
+                const double *row = A + (size_t)i * n;
+                double s = reduce_dot_d(row, xo, (size_t)i) +
+                           reduce_dot_d(row + i + 1, xo + i + 1, (size_t)(n - i - 1));
+                double xi = (b[i] - s) / row[i];
+                double d = fabs(xi - xo[i]);
+                xn[i] = xi;
+                if (d > local) local = d;         /* as ex5.c: a NaN is skipped */
+            }
+
+            double *my_slot = slot + (it & 1) * SLOT_STRIDE * p;
+            my_slot[t * SLOT_STRIDE] = local;
+            #pragma omp barrier
+
+            double gmax = 0.0;
+            for (int k = 0; k < nt; k++)
+                if (my_slot[k * SLOT_STRIDE] > gmax) gmax = my_slot[k * SLOT_STRIDE];
+
+            double *tmp = xo;
+            xo = xn;
+            xn = tmp;
+
+            if (gmax / n <= tol || it >= max_iter) {
+                if (t == 0) {
+                    iterations = it;
+                    norm = gmax / n;
+                    final_x = xo;
+                }
+                break;
+            }
+        }
+    }
+    res.seconds = now_sec() - t1;
+
+    if (final_x != x) memcpy(x, final_x, sizeof(double) * n);
+    res.iterations = iterations;
+    res.norm = norm;
+    res.gflops = res.seconds > 0 ? 2.0 * n * (double)n * iterations / res.seconds * 1e-9 : 0.0;
+
+    free(xw);
+    free(slot);
+    free(rows);
+    return res;
+}
@@ -0,0 +1,55 @@
+/* ================================================================
+ * Jacobi solver for A x = b (dense, diagonally dominant A)
+ * ================================================================
+ *
+ *   x_new[i] = (b[i] - sum_{j != i} A[i][j] x[j]) / A[i][i]
+ *
+ * repeated until max_i |x_new[i] - x[i]| / n <= tol, or max_iter
+ * sweeps (the test of TP3/ex5.c).  Compared to the loop of ex5.c:
+ *
+ *   layout     A is used row-major, so that a row is one contiguous
+ *              dot product; a column-major A (ex5.c's a[j*n+i]) is
+ *              transposed once, by 64 x 64 tiles, before the sweeps
+ *   dot        reduce_dot_d() of simd_reduce.h (several SIMD
+ *              accumulators, AVX2 / AVX-512 chosen at run time) on
+ *              the two parts of the row left and right of the
+ *              diagonal, as the two j loops of ex5.c
+ *   residual   computed in the same pass as x_new (no second loop)
+ *   vectors    x and x_new are swapped, not copied
+ *   threads    one parallel region for the whole solve: rows are
+ *              split statically, and one barrier per sweep both
+ *              publishes x_new and gathers the per-thread maxima (in
+ *              two alternating slot arrays, so a thread that is
+ *              already in the next sweep cannot overwrite a maximum
+ *              another thread is still reading)
+ *
+ * Every thread reads all slots and takes the same decision to stop,
+ * so no extra barrier or single section is needed.  The maximum is
+ * taken as in ex5.c (d > max, so a NaN difference is skipped): a
+ * diverging iteration (A not diagonally dominant enough) runs the
+ * max_iter sweeps and reports the same INF norm as the original.
+ *
+ * COMPILATION: add  -fopenmp -I../common ../common/jacobi.c
+ * ../common/simd_reduce.c  to the compile line.
+ * ================================================================ */
+
+#ifndef JACOBI_H
+#define JACOBI_H
+
+typedef enum { JACOBI_ROW_MAJOR = 0, JACOBI_COL_MAJOR } jacobi_layout_t;
+
+typedef struct {
+    int    iterations;
+    double norm;         /* max |x_new - x| / n of the last sweep */
+    double seconds;      /* sweeps only (without the transpose)   */
+    double transpose;    /* seconds spent transposing A           */
+    double gflops;       /* 2 n^2 flops per sweep                 */
+} jacobi_result_t;
+
+/* A is n x n; element (i, j) is A[i*n+j] (ROW_MAJOR) or A[j*n+i]
+ * (COL_MAJOR).  x holds the initial guess and receives the last
+ * iterate.  Returns iterations = -1 when out of memory */
+jacobi_result_t jacobi_solve(int n, const double *A, jacobi_layout_t layout,
+                             const double *b, double *x, double tol, int max_iter);
+
+#endif /* JACOBI_H */
@@ -0,0 +1,137 @@
+/* ================================================================
+ * Tuned dispatch over the family of sum kernels (see kernel_family.h)
+ * ================================================================
+ *
+ * The kernels and their table live in simd_reduce.c; this file only
+ * times them and remembers the winner of each type.
+ * ================================================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "kernel_family.h"
+
+int kfam_supported(const kfam_variant_t *v)
+{
+    return v->isa <= reduce_isa_max();
+}
+
+/* ----------------------------------------------------------------
+ * Types
+ * ---------------------------------------------------------------- */
+
+#define KFAM_TYPE_NAME(unused, sfx, T) #T,
+#define KFAM_TYPE_SIZE(unused, sfx, T) sizeof(T),
+static const char *type_names[KFAM_NTYPES] = { REDUCE_TYPES(KFAM_TYPE_NAME, ~) };
+static const size_t type_sizes[KFAM_NTYPES] = { REDUCE_TYPES(KFAM_TYPE_SIZE, ~) };
+
+const char *kfam_type_name(kfam_type_t t)
+{
+    return (t < KFAM_NTYPES) ? type_names[t] : "???";
+}
+
+size_t kfam_type_size(kfam_type_t t)
+{
+    return (t < KFAM_NTYPES) ? type_sizes[t] : 0;
+}
+
+#define KFAM_FILL_CASE(unused, sfx, T)                                  \
+    case REDUCE_TYPE_##sfx:                                             \
+        for (size_t i = 0; i < n; i++) ((T *)a)[i] = (T)v;              \
+        break;
+
+void kfam_fill(kfam_type_t t, void *a, size_t n, int v)
+{
+    switch (t) {
+    REDUCE_TYPES(KFAM_FILL_CASE, ~)
+    default: break;
+    }
+}
+
+/* ----------------------------------------------------------------
+ * Tuning and dispatch
+ * ---------------------------------------------------------------- */
+
+/* Winner per type, published once tuned; the lock serialises the
+ * tuning runs so that threads arriving together tune only once */
+static _Atomic(const kfam_variant_t *) best[KFAM_NTYPES];
+static pthread_mutex_t tune_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Keeps the optimiser from dropping the timed calls */
+static volatile double sink;
+
+/* Caller holds tune_lock */
+static const kfam_variant_t *tune_locked(kfam_type_t t, const void *a, size_t n, int reps)
+{
+    const kfam_variant_t *win = NULL;
+    double win_time = 0.0;
+
+    for (int v = 0; v < reduce_sum_variant_count(); v++) {
+        const kfam_variant_t *k = reduce_sum_variant(v);
+        if (k->type != t || !kfam_supported(k)) continue;
+
+        double t_min = 0.0;
+        sink = k->fn(a, n);                 /* warm-up */
+        for (int r = 0; r < reps; r++) {
+            double t0 = now_sec();
+            sink = k->fn(a, n);
+            double dt = now_sec() - t0;
+            if (r == 0 || dt < t_min) t_min = dt;
+        }
+        if (!win || t_min < win_time) {
+            win = k;
+            win_time = t_min;
+        }
+    }
+
+    atomic_store_explicit(&best[t], win, memory_order_release);
+    return win;
+}
+
+const kfam_variant_t *kfam_tune(kfam_type_t t, const void *a, size_t n, int reps)
+{
+    if (t >= KFAM_NTYPES) return NULL;
+
+    pthread_mutex_lock(&tune_lock);
+    const kfam_variant_t *win = tune_locked(t, a, n, reps);
+    pthread_mutex_unlock(&tune_lock);
+    return win;
+}
+
+const kfam_variant_t *kfam_best(kfam_type_t t)
+{
+    if (t >= KFAM_NTYPES) return NULL;
+
+    const kfam_variant_t *win = atomic_load_explicit(&best[t], memory_order_acquire);
+    if (win) return win;
+
+    pthread_mutex_lock(&tune_lock);
+    win = atomic_load_explicit(&best[t], memory_order_relaxed);   /* tuned while we waited? */
+    if (!win) {
+        void *a = malloc(KFAM_TUNE_N * kfam_type_size(t));
+        if (a) {
+            kfam_fill(t, a, KFAM_TUNE_N, 1);
+            win = tune_locked(t, a, KFAM_TUNE_N, 3);
+            free(a);
+        }
+    }
+    pthread_mutex_unlock(&tune_lock);
+    return win;
+}
+
+double kfam_sum(kfam_type_t t, const void *a, size_t n)
+{
+    const kfam_variant_t *k = kfam_best(t);
+    return k ? k->fn(a, n) : 0.0;
+}
@@ -0,0 +1,64 @@
+/* ================================================================
+ * Tuned dispatch over the family of sum kernels
+ * ================================================================
+ *
+ * One binary holds every (type, unroll, accumulators, ISA) variant
+ * of  s = a[0] + ... + a[n-1]: the sum ladder of simd_reduce.h,
+ * built from the same body as reduce_sum, instead of one build per
+ * -DT and one hand-copied loop per unroll factor.
+ *
+ *   type          float, double, int, short, long long
+ *   unroll U      1, 2, 4, 8, 16, 32 vectors (or scalars) per iteration
+ *   accumulators  A independent partial sums, 1 <= A <= min(U, 8)
+ *   ISA           scalar, AVX2 (256-bit), AVX-512 (512-bit)
+ *
+ * reduce_sum_variant() lists them; names read
+ * sum_<type>_u<U>_a<A>_<isa>,  e.g. sum_d_u8_a4_avx2.  With A = 1 the unrolled loop is still one
+ * dependency chain (the TP2 unroll ladder); A > 1 is what breaks it.
+ * Integer sums wrap in the element type; every kernel returns its
+ * result converted to double.
+ *
+ * kfam_tune() times every variant of a type that this CPU can run
+ * and keeps the fastest; kfam_sum() then dispatches to it (tuning
+ * on first use if needed), which is the production entry point.
+ * The winners are shared by all threads: a first kfam_sum() from
+ * several threads at once tunes once, the others wait for it.
+ *
+ * COMPILATION: add  -I../common ../common/kernel_family.c
+ * ../common/simd_reduce.c -pthread  to the compile line.
+ * ================================================================ */
+
+#ifndef KERNEL_FAMILY_H
+#define KERNEL_FAMILY_H
+
+#include <stddef.h>
+
+#include "simd_reduce.h"
+
+/* The family is simd_reduce's sum ladder, under this module's names */
+typedef reduce_type_t    kfam_type_t;
+typedef reduce_variant_t kfam_variant_t;
+
+#define KFAM_NTYPES REDUCE_NTYPES
+
+/* Can this CPU run it (ISA <= reduce_isa_max()) */
+int kfam_supported(const kfam_variant_t *v);
+
+const char *kfam_type_name(kfam_type_t t);     /* "float", ...      */
+size_t      kfam_type_size(kfam_type_t t);
+/* Fill a[0..n) of type t with the value v */
+void        kfam_fill(kfam_type_t t, void *a, size_t n, int v);
+
+/* Time every supported variant of type t on a (reps runs each, the
+ * fastest run counts), remember and return the winner */
+const kfam_variant_t *kfam_tune(kfam_type_t t, const void *a, size_t n, int reps);
+/* Winner for type t, tuned on KFAM_TUNE_N elements on first use */
+const kfam_variant_t *kfam_best(kfam_type_t t);
+/* Production entry point: sum with the best variant */
+double kfam_sum(kfam_type_t t, const void *a, size_t n);
+
+#ifndef KFAM_TUNE_N
+#define KFAM_TUNE_N (1 << 20)
+#endif
+
+#endif /* KERNEL_FAMILY_H */
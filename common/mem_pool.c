@@ -0,0 +1,272 @@
+/* ================================================================
+ * Size-classed pool allocator with leak tracking
+ * (see mem_pool.h)
+ * ================================================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "mem_pool.h"
+
+#define POOL_LARGE  (-1)
+
+/*
+ * One cache line in front of every block.  'next' links free blocks
+ * of a class; the debug fields are only written with POOL_DEBUG.
+ */
+typedef struct pool_header {
+    struct pool_header *next;
+    void    *base;      /* large blocks: what aligned_alloc returned */
+    size_t   size;      /* requested bytes (debug) / block bytes      */
+    int32_t  cls;       /* size class, or POOL_LARGE                  */
+    int32_t  site;      /* call-site index (debug)                    */
+    uint32_t state;     /* POOL_LIVE / POOL_FREED (debug)             */
+} pool_header_t;
+
+_Static_assert(sizeof(pool_header_t) <= POOL_ALIGN, "pool header must fit in one line");
+
+#define HDR(p)  ((pool_header_t *)((char *)(p) - POOL_ALIGN))
+#define DATA(h) ((void *)((char *)(h) + POOL_ALIGN))
+
+static _Thread_local pool_header_t *free_lists[POOL_NCLASSES];
+
+static int size_class(size_t bytes)
+{
+    int cls = 0;
+    while (((size_t)1 << (cls + POOL_MIN_SHIFT)) < bytes) cls++;
+    return cls;
+}
+
+/* ----------------------------------------------------------------
+ * Debug bookkeeping: per call-site counters behind a spinlock
+ * ---------------------------------------------------------------- */
+#ifdef POOL_DEBUG
+
+#define POOL_LIVE   0x4C495645u   /* "LIVE" */
+#define POOL_FREED  0x46524545u   /* "FREE" */
+#define MAX_SITES   512
+
+typedef struct {
+    const char *file;
+    int         line;
+    long        allocs, frees;
+    long        live;            /* blocks currently allocated   */
+    size_t      live_bytes;      /* requested bytes still live   */
+    size_t      peak_bytes;      /* high-water mark of live_bytes */
+} pool_site_t;
+
+static pool_site_t sites[MAX_SITES];
+static int n_sites = 0;
+static long slab_refills = 0, large_allocs = 0;
+static atomic_flag sites_lock = ATOMIC_FLAG_INIT;
+static int report_registered = 0;
+
+static void lock_sites(void)
+{
+    while (atomic_flag_test_and_set_explicit(&sites_lock, memory_order_acquire))
+        ;
+}
+
+static void unlock_sites(void)
+{
+    atomic_flag_clear_explicit(&sites_lock, memory_order_release);
+}
+
+static void report_at_exit(void)
+{
+    pool_report();
+}
+
+/* Caller holds the lock */
+static int find_site(const char *file, int line)
+{
+    if (!file) file = "?";
+    for (int s = 0; s < n_sites; s++)
+        if (sites[s].line == line && strcmp(sites[s].file, file) == 0)
+            return s;
+    if (n_sites == MAX_SITES) return MAX_SITES - 1;   /* overflow bucket */
+    sites[n_sites].file = file;
+    sites[n_sites].line = line;
+    return n_sites++;
+}
+
+static void track_alloc(pool_header_t *h, size_t bytes, const char *file, int line)
+{
+    lock_sites();
+    if (!report_registered) {
+        atexit(report_at_exit);
+        report_registered = 1;
+    }
+    int s = find_site(file, line);
+    pool_site_t *st = &sites[s];
+    st->allocs++;
+    st->live++;
+    st->live_bytes += bytes;
+    if (st->live_bytes > st->peak_bytes) st->peak_bytes = st->live_bytes;
+    if (h->cls == POOL_LARGE) large_allocs++;
+    unlock_sites();
+
+    h->site = s;
+    h->size = bytes;
+    h->state = POOL_LIVE;
+}
+
+static void track_free(pool_header_t *h, void *p)
+{
+    if (h->state != POOL_LIVE) {
+        fprintf(stderr, "[mem_pool] %s of %p\n",
+                h->state == POOL_FREED ? "double free" : "free of a foreign pointer", p);
+        abort();
+    }
+    h->state = POOL_FREED;
+
+    lock_sites();
+    pool_site_t *st = &sites[h->site];
+    st->frees++;
+    st->live--;
+    st->live_bytes -= h->size;
+    unlock_sites();
+}
+
+void pool_report(void)
+{
+    long leaked = 0;
+    size_t leaked_bytes = 0;
+
+    lock_sites();
+    fprintf(stderr, "\n[mem_pool] %d call site(s), %ld slab refill(s), %ld large block(s)\n",
+            n_sites, slab_refills, large_allocs);
+    fprintf(stderr, "| %-32s | %8s | %8s | %6s | %12s | %12s |\n",
+            "Call site", "Allocs", "Frees", "Live", "Live bytes", "Peak bytes");
+    for (int s = 0; s < n_sites; s++) {
+        char where[64];
+        snprintf(where, sizeof(where), "%s:%d", sites[s].file, sites[s].line);
+        fprintf(stderr, "| %-32s | %8ld | %8ld | %6ld | %12zu | %12zu |\n",
+                where, sites[s].allocs, sites[s].frees, sites[s].live,
+                sites[s].live_bytes, sites[s].peak_bytes);
+        leaked += sites[s].live;
+        leaked_bytes += sites[s].live_bytes;
+    }
+    if (leaked > 0) {
+        fprintf(stderr, "[mem_pool] LEAK: %ld block(s), %zu bytes still allocated from:\n",
+                leaked, leaked_bytes);
+        for (int s = 0; s < n_sites; s++)
+            if (sites[s].live > 0)
+                fprintf(stderr, "    %s:%d  (%ld block(s), %zu bytes)\n", sites[s].file,
+                        sites[s].line, sites[s].live, sites[s].live_bytes);
+    } else {
+        fprintf(stderr, "[mem_pool] no leaks\n");
+    }
+    unlock_sites();
+}
+
+#else /* release */
+
+void pool_report(void)
+{
+}
+
+#endif /* POOL_DEBUG */
+
+/* ----------------------------------------------------------------
+ * Allocation
+ * ---------------------------------------------------------------- */
+
+/* Carve a fresh slab into blocks of class cls and push them */
+static int refill(int cls)
+{
+    size_t block = (size_t)1 << (cls + POOL_MIN_SHIFT);
+    size_t stride = block + POOL_ALIGN;
+    size_t count = POOL_SLAB_BYTES / stride;
+    if (count < 4) count = 4;
+
+    char *slab = aligned_alloc(POOL_ALIGN, count * stride);
+    if (!slab) return -1;
+
+    for (size_t b = count; b-- > 0;) {
+        pool_header_t *h = (pool_header_t *)(slab + b * stride);
+        h->cls = cls;
+        h->size = block;
+        h->next = free_lists[cls];
+        free_lists[cls] = h;
+    }
+#ifdef POOL_DEBUG
+    lock_sites();
+    slab_refills++;
+    unlock_sites();
+#endif
+    return 0;
+}
+
+void *pool_alloc_at(size_t bytes, const char *file, int line)
+{
+    pool_header_t *h;
+    (void)file;
+    (void)line;
+
+    if (bytes == 0) bytes = 1;
+
+    if (bytes > POOL_MAX_CLASS) {
+        size_t total = ((bytes + POOL_ALIGN - 1) / POOL_ALIGN + 1) * POOL_ALIGN;
+        char *base = aligned_alloc(POOL_ALIGN, total);
+        if (!base) return NULL;
+        h = (pool_header_t *)base;
+        h->base = base;
+        h->cls = POOL_LARGE;
+        h->size = bytes;
+    } else {
+        int cls = size_class(bytes);
+        if (!free_lists[cls] && refill(cls) != 0) return NULL;
+        h = free_lists[cls];
+        free_lists[cls] = h->next;
+    }
+
+#ifdef POOL_DEBUG
+    track_alloc(h, bytes, file, line);
+#endif
+    return DATA(h);
+}
+
+void *pool_calloc_at(size_t count, size_t size, const char *file, int line)
+{
+    size_t bytes = count * size;
+    if (size != 0 && bytes / size != count) return NULL;   /* overflow */
+
+    void *p = pool_alloc_at(bytes, file, line);
+    if (p) memset(p, 0, bytes);
+    return p;
+}
+
+void *pool_dup_at(const void *src, size_t bytes, const char *file, int line)
+{
+    if (!src) return NULL;
+    void *p = pool_alloc_at(bytes, file, line);
+    if (p) memcpy(p, src, bytes);
+    return p;
+}
+
+size_t pool_block_size(const void *p)
+{
+    const pool_header_t *h = HDR(p);
+    if (h->cls == POOL_LARGE) return h->size;
+    return (size_t)1 << (h->cls + POOL_MIN_SHIFT);
+}
+
+void pool_free(void *p)
+{
+    if (!p) return;
+
+    pool_header_t *h = HDR(p);
+#ifdef POOL_DEBUG
+    track_free(h, p);
+#endif
+    if (h->cls == POOL_LARGE) {
+        free(h->base);
+        return;
+    }
+    h->next = free_lists[h->cls];
+    free_lists[h->cls] = h;
+}
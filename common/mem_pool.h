@@ -0,0 +1,78 @@
+/* ================================================================
+ * Size-classed pool allocator with leak tracking
+ * ================================================================
+ *
+ * Blocks of 1 B .. POOL_MAX_CLASS bytes are rounded up to a power
+ * of two and served from per-class free lists.  A free list that
+ * runs dry is refilled by carving a new slab (one big allocation)
+ * into blocks of that class, so a solver that allocates and frees
+ * the same scratch buffers every iteration only pays for a list
+ * push/pop after the first step.  Larger requests go straight to
+ * aligned_alloc.  Every block is POOL_ALIGN-byte aligned.
+ *
+ * Free lists are per thread (no locking); a block may be freed by
+ * another thread than the one that allocated it, it then simply
+ * joins the free list of the freeing thread.  Slabs are never given
+ * back to the system before exit.
+ *
+ * Debug build (-DPOOL_DEBUG):
+ *   every pool_alloc() records its call site (__FILE__:__LINE__),
+ *   the per-site live blocks / live bytes / high-water mark are
+ *   kept, double frees and foreign pointers abort, and the table
+ *   plus every site that still owns blocks (leaks) is printed at
+ *   exit.
+ *   A helper that allocates on behalf of its caller takes the
+ *   (file, line) pair itself and is called through a macro that
+ *   passes POOL_CALLER, so the site recorded is the caller's line:
+ *
+ *     int *make_buf_at(int n, const char *file, int line)
+ *         { return pool_alloc_at(n * sizeof(int), file, line); }
+ *     #define make_buf(n) make_buf_at((n), POOL_CALLER)
+ *
+ * Release build (default):
+ *   none of the above is compiled in; pool_alloc() is a free-list
+ *   pop and pool_free() a push.
+ *
+ * COMPILATION: add  -I../common ../common/mem_pool.c  to the
+ * compile line (plus -DPOOL_DEBUG for the checking build).
+ * ================================================================ */
+
+#ifndef MEM_POOL_H
+#define MEM_POOL_H
+
+#include <stddef.h>
+
+#define POOL_ALIGN      64
+#define POOL_MIN_SHIFT  6                       /* 64 B  */
+#define POOL_MAX_SHIFT  22                      /* 4 MiB */
+#define POOL_MAX_CLASS  ((size_t)1 << POOL_MAX_SHIFT)
+#define POOL_NCLASSES   (POOL_MAX_SHIFT - POOL_MIN_SHIFT + 1)
+
+/* Bytes carved per slab refill (at least 4 blocks for big classes) */
+#ifndef POOL_SLAB_BYTES
+#define POOL_SLAB_BYTES (1u << 20)
+#endif
+
+void *pool_alloc_at(size_t bytes, const char *file, int line);
+void *pool_calloc_at(size_t count, size_t size, const char *file, int line);
+void *pool_dup_at(const void *src, size_t bytes, const char *file, int line);
+void  pool_free(void *p);
+
+/* Usable size of a block (>= the requested size) */
+size_t pool_block_size(const void *p);
+
+/* Call-site table and leaks so far (no-op in release builds) */
+void pool_report(void);
+
+/* Call site argument pair: the current line in debug builds */
+#ifdef POOL_DEBUG
+#define POOL_CALLER __FILE__, __LINE__
+#else
+#define POOL_CALLER NULL, 0
+#endif
+
+#define pool_alloc(bytes)        pool_alloc_at((bytes), POOL_CALLER)
+#define pool_calloc(count, size) pool_calloc_at((count), (size), POOL_CALLER)
+#define pool_dup(src, bytes)     pool_dup_at((src), (bytes), POOL_CALLER)
+
+#endif /* MEM_POOL_H */
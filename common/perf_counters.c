@@ -0,0 +1,259 @@
+/* ================================================================
+ * Hardware performance counters around named code regions
+ * (see perf_counters.h)
+ * ================================================================ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
+#include <cpuid.h>
+
+#include "perf_counters.h"
+
+typedef struct {
+    uint32_t type;
+    uint64_t config;
+    double   weight;     /* FP events: flops per count */
+} event_spec_t;
+
+#define HW_CACHE(cache, op, result) \
+    ((uint64_t)(cache) | ((uint64_t)(op) << 8) | ((uint64_t)(result) << 16))
+
+/* Raw "event | umask << 8" encodings */
+#define RAW(event, umask) ((uint64_t)(event) | ((uint64_t)(umask) << 8))
+
+static event_spec_t specs[PERF_NCOUNTERS];
+static int specs_ready = 0;
+static int counters_disabled = 0;
+
+static const char *events_names[PERF_NCOUNTERS] = {
+    "cycles", "instructions", "L1D loads", "L1D misses", "LLC loads",
+    "LLC misses", "DTLB misses", "FP scalar", "FP 128", "FP 256", "FP 512"
+};
+
+/* Fill specs[] once; type 0xffffffff marks an event this CPU lacks */
+static void init_specs(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    char vendor[13] = {0};
+
+    if (specs_ready) return;
+    specs_ready = 1;
+
+    const char *env = getenv("PERF_COUNTERS");
+    counters_disabled = (env && strcmp(env, "0") == 0);
+
+    specs[PERF_CYCLES]       = (event_spec_t){PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 0};
+    specs[PERF_INSTRUCTIONS] = (event_spec_t){PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, 0};
+    specs[PERF_L1D_LOADS]    = (event_spec_t){PERF_TYPE_HW_CACHE,
+        HW_CACHE(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_ACCESS), 0};
+    specs[PERF_L1D_MISSES]   = (event_spec_t){PERF_TYPE_HW_CACHE,
+        HW_CACHE(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), 0};
+    specs[PERF_LLC_LOADS]    = (event_spec_t){PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES, 0};
+    specs[PERF_LLC_MISSES]   = (event_spec_t){PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, 0};
+    specs[PERF_DTLB_MISSES]  = (event_spec_t){PERF_TYPE_HW_CACHE,
+        HW_CACHE(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), 0};
+
+    for (int e = PERF_FP_SCALAR; e <= PERF_FP_512; e++)
+        specs[e] = (event_spec_t){0xffffffffu, 0, 0};
+
+    if (__get_cpuid(0, &eax, &ebx, &ecx, &edx)) {
+        memcpy(vendor, &ebx, 4);
+        memcpy(vendor + 4, &edx, 4);
+        memcpy(vendor + 8, &ecx, 4);
+    }
+
+    if (strcmp(vendor, "GenuineIntel") == 0) {
+        /* FP_ARITH_INST_RETIRED (0xC7), double precision; FMAs count twice */
+        specs[PERF_FP_SCALAR] = (event_spec_t){PERF_TYPE_RAW, RAW(0xC7, 0x01), 1.0};
+        specs[PERF_FP_128]    = (event_spec_t){PERF_TYPE_RAW, RAW(0xC7, 0x04), 2.0};
+        specs[PERF_FP_256]    = (event_spec_t){PERF_TYPE_RAW, RAW(0xC7, 0x10), 4.0};
+        specs[PERF_FP_512]    = (event_spec_t){PERF_TYPE_RAW, RAW(0xC7, 0x40), 8.0};
+    } else if (strcmp(vendor, "AuthenticAMD") == 0) {
+        /* RETIRED_SSE_AVX_FLOPS (0x03): already counts FLOPs, all widths */
+        specs[PERF_FP_SCALAR] = (event_spec_t){PERF_TYPE_RAW, RAW(0x03, 0xFF), 1.0};
+    }
+}
+
+static int open_event(const event_spec_t *s)
+{
+    struct perf_event_attr attr;
+
+    if (s->type == 0xffffffffu) return -1;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = s->type;
+    attr.config = s->config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int perf_region_begin(perf_region_t *r, const char *name)
+{
+    int opened = 0;
+
+    init_specs();
+    r->name = name;
+    r->seconds = 0.0;
+
+    for (int e = 0; e < PERF_NCOUNTERS; e++) {
+        r->value[e] = -1.0;
+        r->fd[e] = counters_disabled ? -1 : open_event(&specs[e]);
+        if (r->fd[e] >= 0) opened++;
+    }
+    for (int e = 0; e < PERF_NCOUNTERS; e++) {
+        if (r->fd[e] < 0) continue;
+        ioctl(r->fd[e], PERF_EVENT_IOC_RESET, 0);
+        ioctl(r->fd[e], PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    r->t0 = now_sec();
+    return opened;
+}
+
+void perf_region_end(perf_region_t *r)
+{
+    double t1 = now_sec();
+
+    for (int e = 0; e < PERF_NCOUNTERS; e++)
+        if (r->fd[e] >= 0) ioctl(r->fd[e], PERF_EVENT_IOC_DISABLE, 0);
+    r->seconds = t1 - r->t0;
+
+    for (int e = 0; e < PERF_NCOUNTERS; e++) {
+        uint64_t buf[3];   /* value, time enabled, time running */
+        if (r->fd[e] < 0) continue;
+
+        if (read(r->fd[e], buf, sizeof(buf)) == sizeof(buf) && buf[2] > 0) {
+            /* Scale up when the PMU had to multiplex this counter */
+            double v = (double)buf[0] * ((double)buf[1] / (double)buf[2]);
+            if (specs[e].weight > 0) v *= specs[e].weight;
+            r->value[e] = v;
+        }
+        close(r->fd[e]);
+        r->fd[e] = -1;
+    }
+}
+
+/* ----------------------------------------------------------------
+ * Derived metrics
+ * ---------------------------------------------------------------- */
+
+static double ratio(double num, double den)
+{
+    if (num < 0 || den <= 0) return -1.0;
+    return num / den;
+}
+
+double perf_ipc(const perf_region_t *r)
+{
+    return ratio(r->value[PERF_INSTRUCTIONS], r->value[PERF_CYCLES]);
+}
+
+double perf_l1d_miss_rate(const perf_region_t *r)
+{
+    return ratio(r->value[PERF_L1D_MISSES], r->value[PERF_L1D_LOADS]);
+}
+
+double perf_llc_miss_rate(const perf_region_t *r)
+{
+    return ratio(r->value[PERF_LLC_MISSES], r->value[PERF_LLC_LOADS]);
+}
+
+double perf_dtlb_misses(const perf_region_t *r)
+{
+    return r->value[PERF_DTLB_MISSES];
+}
+
+double perf_flops(const perf_region_t *r)
+{
+    double total = 0.0;
+    int any = 0;
+
+    /* Widths the CPU does not have (or that failed to open) count as 0 */
+    for (int e = PERF_FP_SCALAR; e <= PERF_FP_512; e++) {
+        if (r->value[e] >= 0) {
+            total += r->value[e];
+            any = 1;
+        }
+    }
+    return any ? total : -1.0;
+}
+
+double perf_dram_bytes(const perf_region_t *r)
+{
+    double misses = r->value[PERF_LLC_MISSES];
+    return (misses < 0) ? -1.0 : misses * 64.0;
+}
+
+double perf_flop_per_byte(const perf_region_t *r)
+{
+    return ratio(perf_flops(r), perf_dram_bytes(r));
+}
+
+/* ----------------------------------------------------------------
+ * Output
+ * ---------------------------------------------------------------- */
+
+const char *perf_table_header(void)
+{
+    return "| IPC  | L1D miss | LLC miss | FLOP/byte | DTLB miss  |";
+}
+
+const char *perf_table_rule(void)
+{
+    return "--------------------------------------------------------";
+}
+
+static void cell(char *dst, size_t len, int width, double v, const char *fmt, double scale)
+{
+    if (v < 0) snprintf(dst, len, " %-*s |", width, "n/a");
+    else {
+        char num[16];
+        snprintf(num, sizeof(num), fmt, v * scale);
+        snprintf(dst, len, " %-*s |", width, num);
+    }
+}
+
+void perf_table_cells(const perf_region_t *r, char *buf, size_t len)
+{
+    char c[5][48];
+
+    cell(c[0], sizeof(c[0]), 4, perf_ipc(r), "%.2f", 1.0);
+    cell(c[1], sizeof(c[1]), 8, perf_l1d_miss_rate(r), "%.2f%%", 100.0);
+    cell(c[2], sizeof(c[2]), 8, perf_llc_miss_rate(r), "%.2f%%", 100.0);
+    cell(c[3], sizeof(c[3]), 9, perf_flop_per_byte(r), "%.3f", 1.0);
+    cell(c[4], sizeof(c[4]), 10, perf_dtlb_misses(r), "%.0f", 1.0);
+    snprintf(buf, len, "|%s%s%s%s%s", c[0], c[1], c[2], c[3], c[4]);
+}
+
+void perf_region_print(const perf_region_t *r)
+{
+    printf("[perf] %s: %.4f s", r->name ? r->name : "region", r->seconds);
+    for (int e = 0; e < PERF_NCOUNTERS; e++) {
+        if (r->value[e] >= 0) printf(", %s %.0f", events_names[e], r->value[e]);
+    }
+    double ipc = perf_ipc(r), fpb = perf_flop_per_byte(r);
+    if (ipc >= 0) printf(", IPC %.2f", ipc);
+    if (fpb >= 0) printf(", FLOP/byte %.3f", fpb);
+    printf("\n");
+}
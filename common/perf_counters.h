@@ -0,0 +1,84 @@
+/* ================================================================
+ * Hardware performance counters around named code regions
+ * ================================================================
+ *
+ * Thin wrapper over Linux perf_event_open(2).  A region opens one
+ * counter per event below, runs the code, and keeps the (multiplex-
+ * scaled) counts:
+ *
+ *   cycles, instructions          -> IPC
+ *   L1D read accesses / misses    -> L1D miss rate
+ *   LLC read accesses / misses    -> LLC miss rate, DRAM bytes ~ 64 * LLC misses
+ *   DTLB read misses
+ *   double-precision FP ops       -> measured FLOP/byte
+ *
+ * FP ops use the model-specific raw events (Intel FP_ARITH_INST_RETIRED
+ * scalar/128/256/512-bit double, weighted 1/2/4/8; AMD Zen
+ * RETIRED_SSE_AVX_FLOPS); other CPUs report them as unavailable.
+ *
+ * Counters follow the calling thread and the threads it creates
+ * after perf_region_begin() (inherit).  Any event the kernel refuses
+ * (perf_event_paranoid, no PMU in a VM, ...) reads as unavailable
+ * and the derived metric prints as "n/a"; timing still works.
+ * PERF_COUNTERS=0 in the environment disables all counters.
+ *
+ * COMPILATION: add  -I../common ../common/perf_counters.c  to the
+ * compile line.
+ * ================================================================ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stddef.h>
+
+typedef enum {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_LOADS,
+    PERF_L1D_MISSES,
+    PERF_LLC_LOADS,
+    PERF_LLC_MISSES,
+    PERF_DTLB_MISSES,
+    PERF_FP_SCALAR,      /* FP ops, already weighted by vector width */
+    PERF_FP_128,
+    PERF_FP_256,
+    PERF_FP_512,
+    PERF_NCOUNTERS
+} perf_counter_t;
+
+typedef struct {
+    const char *name;
+    int    fd[PERF_NCOUNTERS];
+    double value[PERF_NCOUNTERS];   /* scaled count, -1 if unavailable */
+    double seconds;                 /* wall time of the region          */
+    double t0;
+} perf_region_t;
+
+/* Open and start the counters; returns how many could be opened */
+int  perf_region_begin(perf_region_t *r, const char *name);
+/* Stop, read and close them */
+void perf_region_end(perf_region_t *r);
+
+/* Derived metrics, negative when an input counter is unavailable */
+double perf_ipc(const perf_region_t *r);
+double perf_l1d_miss_rate(const perf_region_t *r);   /* 0..1 */
+double perf_llc_miss_rate(const perf_region_t *r);   /* 0..1 */
+double perf_dtlb_misses(const perf_region_t *r);
+double perf_flops(const perf_region_t *r);
+double perf_dram_bytes(const perf_region_t *r);      /* 64 B per LLC miss */
+double perf_flop_per_byte(const perf_region_t *r);
+
+/*
+ * Fixed-width table columns, so every benchmark prints the same
+ * extra cells after its own ones:
+ *   "| IPC  | L1D miss | LLC miss | FLOP/byte | DTLB miss  |"
+ * perf_table_cells() writes the matching cells for one region.
+ */
+const char *perf_table_header(void);
+const char *perf_table_rule(void);
+void perf_table_cells(const perf_region_t *r, char *buf, size_t len);
+
+/* One-line "name: 1.23 IPC, ..." summary on stdout */
+void perf_region_print(const perf_region_t *r);
+
+#endif /* PERF_COUNTERS_H */
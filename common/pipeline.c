@@ -0,0 +1,157 @@
+/* ================================================================
+ * Fused streaming pipeline over cache-sized chunks (see pipeline.h)
+ * ================================================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "pipeline.h"
+
+void pipe_init(pipeline_t *p)
+{
+    memset(p, 0, sizeof(*p));
+}
+
+static int push(pipeline_t *p, pipe_kind_t kind, const double *src, double *dst,
+                pipe_fn fn, void *arg)
+{
+    int is_source = (kind == PIPE_SRC_ARRAY || kind == PIPE_SRC_GEN);
+
+    if (p->n_stages == PIPE_MAX_STAGES) {
+        fprintf(stderr, "[pipe] too many stages (max %d)\n", PIPE_MAX_STAGES);
+        return -1;
+    }
+    /* A source comes first and only first */
+    if (is_source != (p->n_stages == 0)) {
+        fprintf(stderr, "[pipe] %s\n", is_source ? "source after the first stage"
+                                                 : "first stage must be a source");
+        return -1;
+    }
+    p->stage[p->n_stages++] = (pipe_stage_t){kind, src, dst, fn, arg};
+    return 0;
+}
+
+int pipe_source_array(pipeline_t *p, const double *src) { return push(p, PIPE_SRC_ARRAY, src, NULL, NULL, NULL); }
+int pipe_source_gen(pipeline_t *p, pipe_fn fn, void *arg) { return push(p, PIPE_SRC_GEN, NULL, NULL, fn, arg); }
+int pipe_add_array(pipeline_t *p, const double *src)    { return push(p, PIPE_ADD_ARRAY, src, NULL, NULL, NULL); }
+int pipe_add_gen(pipeline_t *p, pipe_fn fn, void *arg)    { return push(p, PIPE_ADD_GEN, NULL, NULL, fn, arg); }
+int pipe_map(pipeline_t *p, pipe_fn fn, void *arg)        { return push(p, PIPE_MAP, NULL, NULL, fn, arg); }
+int pipe_store(pipeline_t *p, double *dst)                { return push(p, PIPE_STORE, NULL, dst, NULL, NULL); }
+
+void pipe_gen_ramp(double *x, size_t i0, size_t len, void *arg)
+{
+    double scale = *(const double *)arg;
+    for (size_t k = 0; k < len; k++) x[k] = (double)(i0 + k) * scale;
+}
+
+double pipe_bytes_per_elem(const pipeline_t *p)
+{
+    double bytes = 0.0;
+    for (int s = 0; s < p->n_stages; s++) {
+        pipe_kind_t k = p->stage[s].kind;
+        if (k == PIPE_SRC_ARRAY || k == PIPE_ADD_ARRAY || k == PIPE_STORE)
+            bytes += sizeof(double);
+    }
+    return bytes;
+}
+
+/* ----------------------------------------------------------------
+ * Execution
+ * ---------------------------------------------------------------- */
+
+/* All stages on elements [i0, i0+len) of one chunk; x and tmp are
+ * PIPE_CHUNK-element scratch buffers */
+static void run_chunk(const pipeline_t *p, size_t i0, size_t len,
+                      double *restrict x, double *restrict tmp)
+{
+    for (int s = 0; s < p->n_stages; s++) {
+        const pipe_stage_t *st = &p->stage[s];
+        const double *restrict src = st->src ? st->src + i0 : NULL;
+
+        switch (st->kind) {
+        case PIPE_SRC_ARRAY:
+            memcpy(x, src, len * sizeof(double));
+            break;
+        case PIPE_SRC_GEN:
+            st->fn(x, i0, len, st->arg);
+            break;
+        case PIPE_ADD_ARRAY:
+            for (size_t k = 0; k < len; k++) x[k] += src[k];
+            break;
+        case PIPE_ADD_GEN:
+            st->fn(tmp, i0, len, st->arg);
+            for (size_t k = 0; k < len; k++) x[k] += tmp[k];
+            break;
+        case PIPE_MAP:
+            st->fn(x, i0, len, st->arg);
+            break;
+        case PIPE_STORE:
+            memcpy(st->dst + i0, x, len * sizeof(double));
+            break;
+        }
+    }
+}
+
+/* Four independent accumulators: the chunk sum is not latency bound */
+static double chunk_sum(const double *x, size_t len)
+{
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t k = 0;
+
+    for (; k + 4 <= len; k += 4) {
+        s0 += x[k];
+        s1 += x[k + 1];
+        s2 += x[k + 2];
+        s3 += x[k + 3];
+    }
+    for (; k < len; k++) s0 += x[k];
+    return (s0 + s1) + (s2 + s3);
+}
+
+static double run_all(const pipeline_t *p, size_t n, int want_sum)
+{
+    size_t n_chunks = (n + PIPE_CHUNK - 1) / PIPE_CHUNK;
+    double *part = want_sum ? malloc((n_chunks ? n_chunks : 1) * sizeof(double)) : NULL;
+
+    if (p->n_stages == 0 || (want_sum && !part)) {
+        free(part);
+        return 0.0;
+    }
+
+    #pragma omp parallel
+    {
+        double x[PIPE_CHUNK] __attribute__((aligned(64)));
+        double tmp[PIPE_CHUNK] __attribute__((aligned(64)));
+
+        #pragma omp for schedule(static)
+        for (size_t c = 0; c < n_chunks; c++) {
+            size_t i0 = c * PIPE_CHUNK;
+            size_t len = (n - i0 < PIPE_CHUNK) ? n - i0 : PIPE_CHUNK;
+
+            run_chunk(p, i0, len, x, tmp);
+            if (want_sum) part[c] = chunk_sum(x, len);
+        }
+    }
+
+    /* Chunk order, whatever the thread count */
+    double sum = 0.0;
+    if (want_sum) {
+        for (size_t c = 0; c < n_chunks; c++) sum += part[c];
+        free(part);
+    }
+    return sum;
+}
+
+double pipe_run_sum(const pipeline_t *p, size_t n)
+{
+    return run_all(p, n, 1);
+}
+
+void pipe_run(const pipeline_t *p, size_t n)
+{
+    run_all(p, n, 0);
+}
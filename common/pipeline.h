@@ -0,0 +1,93 @@
+/* ================================================================
+ * Fused streaming pipeline over cache-sized chunks
+ * ================================================================
+ *
+ * A loop chain such as
+ *
+ *   init b;  c = a + b;  sum += c;
+ *
+ * run as separate passes streams every intermediate array through
+ * memory.  A pipeline describes the same chain as stages and runs
+ * all of them on one PIPE_CHUNK-element chunk (L1 resident) before
+ * moving to the next chunk, so intermediates never leave the cache
+ * and are only written out where a pipe_store() stage asks for it.
+ *
+ *   pipeline_t p;
+ *   pipe_init(&p);
+ *   pipe_source_array(&p, a);          x  = a[i]
+ *   pipe_add_gen(&p, ramp, &half);     x += f(i)   (b never stored)
+ *   pipe_store(&p, c);                 c[i] = x    (optional)
+ *   double s = pipe_run_sum(&p, n);    sum of x
+ *
+ * Chunks are distributed over OpenMP threads (serial without
+ * -fopenmp).  Every chunk's partial sum is kept and the partials are
+ * added in chunk order, so the sum does not depend on the thread
+ * count.
+ *
+ * pipe_bytes_per_elem() gives the memory traffic of the fused run:
+ * 8 bytes per array read (source / add) and per array written
+ * (store); generated operands cost nothing.
+ *
+ * COMPILATION: add  -I../common ../common/pipeline.c  (and
+ * -fopenmp for the threaded run) to the compile line.
+ * ================================================================ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stddef.h>
+
+/* Elements per chunk: 2 buffers of 16 KiB */
+#ifndef PIPE_CHUNK
+#define PIPE_CHUNK 2048
+#endif
+
+#define PIPE_MAX_STAGES 8
+
+/* Fills or transforms x[0..len) for global indices i0 .. i0+len-1 */
+typedef void (*pipe_fn)(double *x, size_t i0, size_t len, void *arg);
+
+typedef enum {
+    PIPE_SRC_ARRAY,     /* x  = src[i]           */
+    PIPE_SRC_GEN,       /* x  = fn(i)            */
+    PIPE_ADD_ARRAY,     /* x += src[i]           */
+    PIPE_ADD_GEN,       /* x += fn(i)            */
+    PIPE_MAP,           /* x  = fn(x) in place   */
+    PIPE_STORE          /* dst[i] = x            */
+} pipe_kind_t;
+
+typedef struct {
+    pipe_kind_t   kind;
+    const double *src;
+    double       *dst;
+    pipe_fn       fn;
+    void         *arg;
+} pipe_stage_t;
+
+typedef struct {
+    int          n_stages;
+    pipe_stage_t stage[PIPE_MAX_STAGES];
+} pipeline_t;
+
+void pipe_init(pipeline_t *p);
+
+/* Each returns 0, or -1 when the pipeline is full or starts wrong */
+int pipe_source_array(pipeline_t *p, const double *src);
+int pipe_source_gen(pipeline_t *p, pipe_fn fn, void *arg);
+int pipe_add_array(pipeline_t *p, const double *src);
+int pipe_add_gen(pipeline_t *p, pipe_fn fn, void *arg);
+int pipe_map(pipeline_t *p, pipe_fn fn, void *arg);
+int pipe_store(pipeline_t *p, double *dst);
+
+/* Run over n elements; returns the sum of the final values */
+double pipe_run_sum(const pipeline_t *p, size_t n);
+/* Run over n elements for the stores only (no reduction) */
+void   pipe_run(const pipeline_t *p, size_t n);
+
+/* Memory traffic of one element of the fused run (bytes) */
+double pipe_bytes_per_elem(const pipeline_t *p);
+
+/* Ready-made generator: x[k] = scale * (i0 + k), arg is a double * */
+void pipe_gen_ramp(double *x, size_t i0, size_t len, void *arg);
+
+#endif /* PIPELINE_H */
@@ -0,0 +1,271 @@
+/* ================================================================
+ * Compensated and reproducible summation (see repro_sum.h)
+ * ================================================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "repro_sum.h"
+
+static const char *mode_names[SUM_NMODES] = {
+    "plain", "kahan", "neumaier", "pairwise", "binned"
+};
+
+const char *sum_mode_name(sum_mode_t mode)
+{
+    if ((int)mode < 0 || mode >= SUM_NMODES) return "???";
+    return mode_names[mode];
+}
+
+int sum_mode_parse(const char *name)
+{
+    for (int m = 0; m < SUM_NMODES; m++)
+        if (strcmp(name, mode_names[m]) == 0) return m;
+    return -1;
+}
+
+/* ----------------------------------------------------------------
+ * Binned accumulator
+ * ---------------------------------------------------------------- */
+
+void repro_init(repro_acc_t *acc)
+{
+    memset(acc, 0, sizeof(*acc));
+}
+
+void repro_normalize(repro_acc_t *acc)
+{
+    for (int i = 0; i < REPRO_NBINS - 1; i++) {
+        long long carry = acc->bin[i] >> REPRO_BIN_BITS;   /* floor division */
+        acc->bin[i] -= carry * (1LL << REPRO_BIN_BITS);
+        acc->bin[i + 1] += carry;
+    }
+    acc->pending = 0;
+}
+
+void repro_merge(repro_acc_t *dst, const repro_acc_t *src)
+{
+    repro_acc_t tmp = *src;
+
+    repro_normalize(dst);
+    repro_normalize(&tmp);
+    for (int i = 0; i < REPRO_NBINS; i++) dst->bin[i] += tmp.bin[i];
+    dst->pending = 2;
+    dst->n_pinf += tmp.n_pinf;
+    dst->n_ninf += tmp.n_ninf;
+    dst->n_nan += tmp.n_nan;
+}
+
+void repro_add_special(repro_acc_t *acc, double x)
+{
+    if (isnan(x)) acc->n_nan++;
+    else if (x > 0) acc->n_pinf++;
+    else acc->n_ninf++;
+}
+
+double repro_value(const repro_acc_t *acc)
+{
+    repro_acc_t t = *acc;
+    int top = REPRO_NBINS - 1, negative;
+
+    if (t.n_nan || (t.n_pinf && t.n_ninf)) return NAN;
+    if (t.n_pinf) return INFINITY;
+    if (t.n_ninf) return -INFINITY;
+
+    /* Canonical form: lower bins in [0, 2^32), so the sign of the
+     * value is the sign of the top bin; work on the magnitude */
+    repro_normalize(&t);
+    negative = (t.bin[REPRO_NBINS - 1] < 0);
+    if (negative) {
+        for (int i = 0; i < REPRO_NBINS; i++) t.bin[i] = -t.bin[i];
+        repro_normalize(&t);
+    }
+
+    while (top > 0 && t.bin[top] == 0) top--;
+
+    /* Most significant bins first.  Each bin below the top holds a
+     * 32-bit piece in its int64, exact as a double; the top two pieces
+     * already span the 53-bit mantissa, the lower ones only matter for
+     * the rounding */
+    double r = 0.0;
+    for (int i = top; i >= 0; i--)
+        r += ldexp((double)t.bin[i], REPRO_BIN_BITS * i - 1074);
+    return negative ? -r : r;
+}
+
+/* ----------------------------------------------------------------
+ * Array kernels, for double and float accumulation
+ * ---------------------------------------------------------------- */
+
+/* Below this length pairwise recursion stops and adds in a loop */
+#define PAIRWISE_LEAF 128
+
+#define SUM_KERNELS(sfx, T)                                             \
+    static double plain_##sfx(const T *a, size_t n)                     \
+    {                                                                   \
+        T s = 0;                                                        \
+        for (size_t i = 0; i < n; i++) s += a[i];                       \
+        return s;                                                       \
+    }                                                                   \
+                                                                        \
+    static double kahan_##sfx(const T *a, size_t n)                     \
+    {                                                                   \
+        T s = 0, c = 0;                                                 \
+        for (size_t i = 0; i < n; i++) {                                \
+            T y = a[i] - c;                                             \
+            T t = s + y;                                                \
+            c = (t - s) - y;                                            \
+            s = t;                                                      \
+        }                                                               \
+        return s;                                                       \
+    }                                                                   \
+                                                                        \
+    static double neumaier_##sfx(const T *a, size_t n)                  \
+    {                                                                   \
+        T s = 0, c = 0;                                                 \
+        for (size_t i = 0; i < n; i++) {                                \
+            T x = a[i], t = s + x;                                      \
+            /* |s| >= |x| almost always once s has grown */         \
+            int s_big = fabs((double)s) >= fabs((double)x);             \
+            T big = s_big ? s : x, small = s_big ? x : s;               \
+            c += (big - t) + small;                                     \
+            s = t;                                                      \
+        }                                                               \
+        return (T)(s + c);                                              \
+    }                                                                   \
+                                                                        \
+    static T pairwise_rec_##sfx(const T *a, size_t n)                   \
+    {                                                                   \
+        if (n <= PAIRWISE_LEAF) {                                       \
+            T s = 0;                                                    \
+            for (size_t i = 0; i < n; i++) s += a[i];                   \
+            return s;                                                   \
+        }                                                               \
+        size_t h = n / 2;                                               \
+        return pairwise_rec_##sfx(a, h) + pairwise_rec_##sfx(a + h, n - h); \
+    }                                                                   \
+                                                                        \
+    static double pairwise_##sfx(const T *a, size_t n)                  \
+    {                                                                   \
+        return pairwise_rec_##sfx(a, n);                                \
+    }                                                                   \
+                                                                        \
+    static double binned_##sfx(const T *a, size_t n)                    \
+    {                                                                   \
+        repro_acc_t acc;                                                \
+        repro_init(&acc);                                               \
+        for (size_t i = 0; i < n; i++) repro_add(&acc, (double)a[i]);   \
+        return repro_value(&acc);                                       \
+    }                                                                   \
+                                                                        \
+    static double (*const kernels_##sfx[SUM_NMODES])(const T *, size_t) = { \
+        plain_##sfx, kahan_##sfx, neumaier_##sfx, pairwise_##sfx, binned_##sfx \
+    };
+
+SUM_KERNELS(d, double)
+SUM_KERNELS(f, float)
+
+#undef SUM_KERNELS
+
+double sum_array(const double *a, size_t n, sum_mode_t mode)
+{
+    return kernels_d[mode](a, n);
+}
+
+double sum_array_f(const float *a, size_t n, sum_mode_t mode)
+{
+    return kernels_f[mode](a, n);
+}
+
+/* ----------------------------------------------------------------
+ * OpenMP
+ * ---------------------------------------------------------------- */
+
+/* Pairwise over fixed SUM_BLOCK blocks: the tree does not depend on
+ * the thread count, only the block sums are computed in parallel */
+static double pairwise_omp(const double *a, size_t n)
+{
+    size_t nb = (n + SUM_BLOCK - 1) / SUM_BLOCK;
+    double *part = malloc((nb ? nb : 1) * sizeof(double));
+
+    if (!part) return pairwise_d(a, n);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (size_t b = 0; b < nb; b++) {
+        size_t lo = b * SUM_BLOCK, len = (n - lo < SUM_BLOCK) ? n - lo : SUM_BLOCK;
+        part[b] = pairwise_rec_d(a + lo, len);
+    }
+
+    double s = pairwise_rec_d(part, nb);
+    free(part);
+    return s;
+}
+
+static double binned_omp(const double *a, size_t n)
+{
+    repro_acc_t total;
+    repro_init(&total);
+
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+        repro_acc_t acc;
+        repro_init(&acc);
+
+#ifdef _OPENMP
+        #pragma omp for schedule(static) nowait
+#endif
+        for (size_t i = 0; i < n; i++) repro_add(&acc, a[i]);
+
+        /* Exact: the merge order does not matter */
+#ifdef _OPENMP
+        #pragma omp critical
+#endif
+        repro_merge(&total, &acc);
+    }
+    return repro_value(&total);
+}
+
+double sum_array_omp(const double *a, size_t n, sum_mode_t mode)
+{
+    if (mode == SUM_PAIRWISE) return pairwise_omp(a, n);
+    if (mode == SUM_BINNED) return binned_omp(a, n);
+
+    /* Per-thread partial sums with the serial kernel, combined in
+     * thread order with Neumaier (deterministic for a given count) */
+    int nt = 1;
+#ifdef _OPENMP
+    nt = omp_get_max_threads();
+#endif
+    double *part = calloc((size_t)nt, sizeof(double));
+    if (!part) return sum_array(a, n, mode);
+
+#ifdef _OPENMP
+    #pragma omp parallel num_threads(nt)
+#endif
+    {
+        int t = 0, team = 1;
+#ifdef _OPENMP
+        t = omp_get_thread_num();
+        team = omp_get_num_threads();
+#endif
+        size_t lo = n * (size_t)t / (size_t)team, hi = n * (size_t)(t + 1) / (size_t)team;
+        part[t] = kernels_d[mode](a + lo, hi - lo);
+    }
+
+    neumaier_t k = {0.0, 0.0};
+    for (int t = 0; t < nt; t++) {
+        if (mode == SUM_PLAIN) k.s += part[t];
+        else neumaier_add(&k, part[t]);
+    }
+    free(part);
+    return neumaier_value(&k);
+}
@@ -0,0 +1,181 @@
+/* ================================================================
+ * Compensated and reproducible summation
+ * ================================================================
+ *
+ * A floating-point sum depends on the order of its additions, so a
+ * reduction(+:sum) or an MPI_Reduce gives a different last bit (or
+ * worse) for every thread / rank count.  Five modes:
+ *
+ *   SUM_PLAIN     s += x                        (the baseline)
+ *   SUM_KAHAN     Kahan compensated sum         ~ error O(eps), not O(n eps)
+ *   SUM_NEUMAIER  Kahan-Babuska-Neumaier: also correct when |x| > |s|
+ *   SUM_PAIRWISE  recursive halving             ~ error O(eps log n)
+ *   SUM_BINNED    exact binned accumulation     bitwise reproducible
+ *
+ * SUM_BINNED splits every double into 32-bit pieces and adds each
+ * piece, as an integer, into the bin of its exponent (66 bins of
+ * 64-bit integers cover the whole double range, subnormals
+ * included).  Integer adds are exact and associative, so the bins
+ * hold the exact sum whatever the order, partition, thread count or
+ * MPI decomposition; the final rounding to double is a function of
+ * that exact value only (within 1 ulp of it), hence identical bits
+ * everywhere.  Inf and NaN are counted apart and give the IEEE
+ * result.
+ *
+ * Thread / rank independence of each mode:
+ *   PLAIN, KAHAN, NEUMAIER : no
+ *   PAIRWISE               : threads yes (fixed SUM_BLOCK tree in
+ *                            sum_array_omp), MPI no
+ *   BINNED                 : threads and MPI
+ *
+ * Streaming use (values computed on the fly):
+ *
+ *   repro_acc_t acc;  repro_init(&acc);
+ *   #pragma omp parallel for reduction(binned : acc)   (REPRO_OMP_DECLARE)
+ *   for (...) repro_add(&acc, f(i));
+ *   repro_mpi_reduce(&acc, 0, MPI_COMM_WORLD);         (after mpi.h)
+ *   double s = repro_value(&acc);
+ *
+ * Do not compile with -ffast-math: it lets the compiler cancel the
+ * compensation terms.
+ *
+ * COMPILATION: add  -I../common ../common/repro_sum.c  to the
+ * compile line.
+ * ================================================================ */
+
+#ifndef REPRO_SUM_H
+#define REPRO_SUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __FAST_MATH__
+#error "repro_sum needs IEEE arithmetic, do not use -ffast-math"
+#endif
+
+typedef enum {
+    SUM_PLAIN = 0,
+    SUM_KAHAN,
+    SUM_NEUMAIER,
+    SUM_PAIRWISE,
+    SUM_BINNED,
+    SUM_NMODES
+} sum_mode_t;
+
+/* Block of the fixed pairwise tree (elements) */
+#define SUM_BLOCK 2048
+
+const char *sum_mode_name(sum_mode_t mode);
+/* "plain", "kahan", ...; returns -1 on unknown names */
+int sum_mode_parse(const char *name);
+
+/* Serial sums of an array */
+double sum_array(const double *a, size_t n, sum_mode_t mode);
+/* float input: every mode but BINNED accumulates in float, like T sum */
+double sum_array_f(const float *a, size_t n, sum_mode_t mode);
+/* OpenMP sum (serial without -fopenmp), see the table above */
+double sum_array_omp(const double *a, size_t n, sum_mode_t mode);
+
+/* ----------------------------------------------------------------
+ * Streaming compensated sum (Neumaier)
+ * ---------------------------------------------------------------- */
+
+typedef struct {
+    double s, c;
+} neumaier_t;
+
+static inline void neumaier_add(neumaier_t *k, double x)
+{
+    double t = k->s + x;
+    int s_big = __builtin_fabs(k->s) >= __builtin_fabs(x);
+    double big = s_big ? k->s : x, small = s_big ? x : k->s;
+    k->c += (big - t) + small;
+    k->s = t;
+}
+
+static inline double neumaier_value(const neumaier_t *k) { return k->s + k->c; }
+
+/* ----------------------------------------------------------------
+ * Binned (exact, reproducible) accumulator
+ * ---------------------------------------------------------------- */
+
+#define REPRO_BIN_BITS 32
+#define REPRO_NBINS    66               /* largest double: top piece in bin 65 */
+/* Adds of < 2^32 between two carry propagations (bins are int64) */
+#define REPRO_FLUSH    (1LL << 30)
+
+typedef struct {
+    long long bin[REPRO_NBINS];         /* bin i weighs 2^(32 i - 1074) */
+    long long pending;                  /* adds since the last carry pass */
+    long long n_pinf, n_ninf, n_nan;
+} repro_acc_t;
+
+void   repro_init(repro_acc_t *acc);
+/* Propagate carries: every bin but the top one back in [0, 2^32) */
+void   repro_normalize(repro_acc_t *acc);
+void   repro_merge(repro_acc_t *dst, const repro_acc_t *src);
+void   repro_add_special(repro_acc_t *acc, double x);
+/* Exact sum rounded to double (does not modify the sum) */
+double repro_value(const repro_acc_t *acc);
+
+static inline void repro_add(repro_acc_t *acc, double x)
+{
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+
+    unsigned ex = (unsigned)(bits >> 52) & 0x7ff;
+    uint64_t mant = bits & ((1ULL << 52) - 1);
+
+    if (ex == 0x7ff) { repro_add_special(acc, x); return; }
+    if (ex) mant |= 1ULL << 52;         /* normal: implicit bit */
+    else    ex = 1;                     /* subnormal: same scale as ex 1 */
+
+    /* x = mant * 2^(ex - 1075); shift s = ex - 1 from the bottom bin */
+    unsigned s = ex - 1, b = s / REPRO_BIN_BITS, off = s % REPRO_BIN_BITS;
+    unsigned __int128 v = (unsigned __int128)mant << off;
+    long long sg = -(long long)(bits >> 63);    /* 0 or -1 */
+
+    acc->bin[b]     += ((long long)((uint64_t)v & 0xffffffffu) ^ sg) - sg;
+    acc->bin[b + 1] += ((long long)((uint64_t)(v >> 32) & 0xffffffffu) ^ sg) - sg;
+    acc->bin[b + 2] += ((long long)(uint64_t)(v >> 64) ^ sg) - sg;
+
+    if (++acc->pending >= REPRO_FLUSH) repro_normalize(acc);
+}
+
+/* Sum of two accumulators in an OpenMP reduction clause:
+ *   REPRO_OMP_DECLARE
+ *   #pragma omp parallel for reduction(binned : acc)          */
+#define REPRO_OMP_DECLARE                                               \
+    _Pragma("omp declare reduction(binned : repro_acc_t :              \
+             repro_merge(&omp_out, &omp_in)) initializer(repro_init(&omp_priv))")
+
+/* Exact MPI reduction of the bins (integer MPI_SUM) onto root */
+#ifdef MPI_VERSION
+static inline void repro_mpi_reduce(repro_acc_t *acc, int root, MPI_Comm comm)
+{
+    long long in[REPRO_NBINS + 3], out[REPRO_NBINS + 3];
+    int rank, size;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    repro_normalize(acc);
+    memcpy(in, acc->bin, sizeof(acc->bin));
+    in[REPRO_NBINS] = acc->n_pinf;
+    in[REPRO_NBINS + 1] = acc->n_ninf;
+    in[REPRO_NBINS + 2] = acc->n_nan;
+
+    MPI_Reduce(in, out, REPRO_NBINS + 3, MPI_LONG_LONG, MPI_SUM, root, comm);
+
+    if (rank == root) {
+        memcpy(acc->bin, out, sizeof(acc->bin));
+        acc->n_pinf = out[REPRO_NBINS];
+        acc->n_ninf = out[REPRO_NBINS + 1];
+        acc->n_nan = out[REPRO_NBINS + 2];
+        acc->pending = size;            /* each bin: at most size adds of < 2^32 */
+    }
+}
+#endif
+
+#endif /* REPRO_SUM_H */
@@ -0,0 +1,246 @@
+/* ================================================================
+ * Serial / parallel region timing and scaling fits (see scaling.h)
+ * ================================================================ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "scaling.h"
+
+typedef struct {
+    const char  *name;
+    scale_kind_t kind;
+    double       run;                      /* current run             */
+    double       t[SCALE_MAX_POINTS];      /* best run of each point  */
+} region_t;
+
+static region_t g_region[SCALE_MAX_REGIONS];
+static int      g_nregions;
+
+static int    g_enabled;
+static int    g_threads[SCALE_MAX_POINTS];
+static int    g_npoints;
+static double g_total[SCALE_MAX_POINTS];
+static int    g_swept;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int max_threads(void)
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/* ----------------------------------------------------------------
+ * Regions
+ * ---------------------------------------------------------------- */
+
+void scale_begin(scale_region_t *r, const char *name, scale_kind_t kind)
+{
+    int id = 0;
+    while (id < g_nregions && strcmp(g_region[id].name, name) != 0) id++;
+    if (id == g_nregions) {
+        if (g_nregions == SCALE_MAX_REGIONS) {
+            r->id = -1;
+            return;
+        }
+        g_region[g_nregions++] = (region_t){.name = name, .kind = kind};
+    }
+    r->id = id;
+    r->t0 = now_sec();
+}
+
+void scale_end(scale_region_t *r)
+{
+    if (r->id >= 0) g_region[r->id].run += now_sec() - r->t0;
+}
+
+/* ----------------------------------------------------------------
+ * Command line
+ * ---------------------------------------------------------------- */
+
+static void default_points(void)
+{
+    int pmax = max_threads();
+    g_npoints = 0;
+    for (int p = 1; p < pmax && g_npoints < SCALE_MAX_POINTS - 1; p *= 2)
+        g_threads[g_npoints++] = p;
+    g_threads[g_npoints++] = pmax;
+}
+
+static int parse_points(const char *list)
+{
+    char *end;
+    g_npoints = 0;
+    g_threads[g_npoints++] = 1;
+    while (*list) {
+        long p = strtol(list, &end, 10);
+        if (end == list || p < 1 || (*end && *end != ',')) return -1;
+        if (p != 1 && g_npoints < SCALE_MAX_POINTS) g_threads[g_npoints++] = (int)p;
+        list = *end ? end + 1 : end;
+    }
+    return 0;
+}
+
+int scale_parse_args(int *argc, char **argv)
+{
+    int out = 1, status = 0;
+
+    for (int a = 1; a < *argc; a++) {
+        if (strcmp(argv[a], "--scaling") == 0) {
+            g_enabled = 1;
+            default_points();
+        } else if (strncmp(argv[a], "--scaling=", 10) == 0) {
+            g_enabled = 1;
+            if (parse_points(argv[a] + 10) != 0) {
+                fprintf(stderr, "Bad --scaling list '%s' (e.g. 1,2,4,8)\n", argv[a] + 10);
+                status = -1;
+            }
+        } else {
+            argv[out++] = argv[a];
+        }
+    }
+    *argc = out;
+    argv[out] = NULL;
+    return status;
+}
+
+int scale_enabled(void)
+{
+    return g_enabled;
+}
+
+/* ----------------------------------------------------------------
+ * Sweep
+ * ---------------------------------------------------------------- */
+
+void scale_sweep(scale_fn fn, void *arg)
+{
+    if (g_npoints == 0) default_points();
+    int saved = max_threads();
+
+    for (int k = 0; k < g_npoints; k++) {
+#ifdef _OPENMP
+        omp_set_num_threads(g_threads[k]);
+#else
+        g_threads[k] = 1;
+#endif
+        g_total[k] = -1.0;
+        for (int rep = 0; rep < SCALE_REPS; rep++) {
+            for (int i = 0; i < g_nregions; i++) g_region[i].run = 0.0;
+
+            double t0 = now_sec();
+            fn(arg);
+            double t = now_sec() - t0;
+
+            if (g_total[k] < 0 || t < g_total[k]) {
+                g_total[k] = t;
+                for (int i = 0; i < g_nregions; i++) g_region[i].t[k] = g_region[i].run;
+            }
+        }
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(saved);
+#else
+    (void)saved;
+#endif
+    g_swept = 1;
+}
+
+/* ----------------------------------------------------------------
+ * Laws and report
+ * ---------------------------------------------------------------- */
+
+double scale_amdahl(double f, int p)
+{
+    return 1.0 / (f + (1.0 - f) / p);
+}
+
+double scale_gustafson(double a, int p)
+{
+    return p - a * (p - 1);
+}
+
+double scale_karp_flatt(double speedup, int p)
+{
+    if (p <= 1 || speedup <= 0) return 0.0;
+    return (1.0 / speedup - 1.0 / p) / (1.0 - 1.0 / p);
+}
+
+static double kind_time(scale_kind_t kind, int k)
+{
+    double t = 0.0;
+    for (int i = 0; i < g_nregions; i++)
+        if (g_region[i].kind == kind) t += g_region[i].t[k];
+    return t;
+}
+
+void scale_report(FILE *out)
+{
+    if (!g_swept) return;
+
+    /* Serial fraction of the tagged time at 1 thread (first point) */
+    double s1 = kind_time(SCALE_SERIAL, 0), p1 = kind_time(SCALE_PARALLEL, 0);
+    double f1 = (s1 + p1 > 0) ? s1 / (s1 + p1) : 0.0;
+
+    /* Least squares: 1/S - 1/p = f (1 - 1/p) */
+    double sxy = 0.0, sxx = 0.0;
+    for (int k = 1; k < g_npoints; k++) {
+        double x = 1.0 - 1.0 / g_threads[k];
+        double y = g_total[k] / g_total[0] - 1.0 / g_threads[k];
+        sxy += x * y;
+        sxx += x * x;
+    }
+    double ffit = (sxx > 0) ? sxy / sxx : f1;
+
+    fprintf(out, "\n| %-7s | %-9s | %-9s | %-9s | %-7s | %-10s | %-10s | %-10s | %-9s |\n",
+            "Threads", "Time (s)", "Serial", "Parallel", "Speedup",
+            "Amdahl(f1)", "Amdahl fit", "Karp-Flatt", "Gustafson");
+    for (int k = 0; k < g_npoints; k++) {
+        int p = g_threads[k];
+        double ts = kind_time(SCALE_SERIAL, k), tp = kind_time(SCALE_PARALLEL, k);
+        double speedup = g_total[0] / g_total[k];
+        double a = (ts + tp > 0) ? ts / (ts + tp) : 0.0;
+        char kf[16] = "-";
+        if (p > 1) snprintf(kf, sizeof(kf), "%.4f", scale_karp_flatt(speedup, p));
+        fprintf(out, "| %7d | %9.4f | %9.4f | %9.4f | %7.2f | %10.2f | %10.2f | %10s | %9.2f |\n",
+                p, g_total[k], ts, tp, speedup, scale_amdahl(f1, p), scale_amdahl(ffit, p),
+                kf, scale_gustafson(a, p));
+    }
+
+    fprintf(out, "Serial fraction at 1 thread (tagged time): f1 = %.4f -> Amdahl limit %.1fx\n",
+            f1, f1 > 0 ? 1.0 / f1 : 0.0);
+    if (g_npoints > 1)
+        fprintf(out, "Serial fraction fitted to observed speedups: f = %.4f -> limit %.1fx\n",
+                ffit, ffit > 0 ? 1.0 / ffit : 0.0);
+    else
+        fprintf(out, "(one thread count only: no fit; run with OMP_NUM_THREADS > 1 or --scaling=LIST)\n");
+
+    /* Per-region times across the sweep */
+    fprintf(out, "\n| %-16s | %-8s |", "Region", "Kind");
+    for (int k = 0; k < g_npoints; k++) fprintf(out, " p=%-6d |", g_threads[k]);
+    fprintf(out, "\n");
+    for (int i = 0; i <= g_nregions; i++) {
+        int other = (i == g_nregions);
+        fprintf(out, "| %-16s | %-8s |", other ? "(other)" : g_region[i].name,
+                other ? "-" : g_region[i].kind == SCALE_SERIAL ? "serial" : "parallel");
+        for (int k = 0; k < g_npoints; k++) {
+            double t = other ? g_total[k] - kind_time(SCALE_SERIAL, k) - kind_time(SCALE_PARALLEL, k)
+                             : g_region[i].t[k];
+            fprintf(out, " %8.4f |", t);
+        }
+        fprintf(out, "\n");
+    }
+}
@@ -0,0 +1,80 @@
+/* ================================================================
+ * Serial / parallel region timing and Amdahl / Gustafson fits
+ * ================================================================
+ *
+ * Code is tagged as serial or parallel with named regions:
+ *
+ *   scale_region_t r;
+ *   scale_begin(&r, "noise", SCALE_SERIAL);
+ *   generate_noise(noise);
+ *   scale_end(&r);
+ *
+ * scale_sweep() runs a function once per thread count (best of
+ * SCALE_REPS runs, omp_set_num_threads() between counts) and keeps
+ * the time of every region.  scale_report() then prints, per thread
+ * count p:
+ *
+ *   observed speedup   S(p) = T(1) / T(p)
+ *   Amdahl             1 / (f + (1 - f) / p), f = serial share of the
+ *                      tagged time at 1 thread, and f fitted to all
+ *                      observed S(p) (least squares on 1/S - 1/p)
+ *   Karp-Flatt         e(p) = (1/S - 1/p) / (1 - 1/p): the serial
+ *                      fraction the observed speedup implies; growing
+ *                      e(p) means overhead, not serial code
+ *   Gustafson          p - a (p - 1), a = serial share of the run at
+ *                      p threads: the speedup if the parallel work
+ *                      grew with p (weak scaling)
+ *
+ * and the time of each region across the sweep.  Regions must not
+ * nest; time outside any region shows as "other".
+ *
+ * Command line (scale_parse_args() removes what it uses):
+ *   --scaling             sweep 1, 2, 4, ... up to the OpenMP maximum
+ *   --scaling=1,2,3,8     explicit thread counts (1 is added if absent)
+ *
+ * COMPILATION: add  -fopenmp -I../common ../common/scaling.c  to the
+ * compile line (without -fopenmp the sweep has a single point).
+ * ================================================================ */
+
+#ifndef SCALING_H
+#define SCALING_H
+
+#include <stdio.h>
+
+#define SCALE_MAX_REGIONS 16
+#define SCALE_MAX_POINTS  32
+
+#ifndef SCALE_REPS
+#define SCALE_REPS 3
+#endif
+
+typedef enum {
+    SCALE_SERIAL,
+    SCALE_PARALLEL
+} scale_kind_t;
+
+typedef struct {
+    int    id;
+    double t0;
+} scale_region_t;
+
+void scale_begin(scale_region_t *r, const char *name, scale_kind_t kind);
+void scale_end(scale_region_t *r);
+
+/* 0 on success, -1 on a malformed --scaling list */
+int  scale_parse_args(int *argc, char **argv);
+/* Non-zero when --scaling was given */
+int  scale_enabled(void);
+
+typedef void (*scale_fn)(void *arg);
+
+/* Run fn(arg) at every thread count of the sweep */
+void scale_sweep(scale_fn fn, void *arg);
+void scale_report(FILE *out);
+
+/* Laws used by the report */
+double scale_amdahl(double f, int p);
+double scale_gustafson(double a, int p);
+double scale_karp_flatt(double speedup, int p);
+
+#endif /* SCALING_H */
@@ -0,0 +1,197 @@
+/* ================================================================
+ * Parallel scan of affine recurrences (see scan.h)
+ * ================================================================ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "scan.h"
+
+#define AVX2_TARGET "avx2,fma"
+
+/* Affine map x -> a x + b */
+typedef struct {
+    double a, b;
+} affine_t;
+
+/* g o f: apply f first */
+static affine_t compose(affine_t g, affine_t f)
+{
+    return (affine_t){g.a * f.a, g.a * f.b + g.b};
+}
+
+/* f applied len times, by squaring (powers of f commute) */
+static affine_t affine_pow(affine_t f, size_t len)
+{
+    affine_t r = {1.0, 0.0};
+    while (len) {
+        if (len & 1) r = compose(f, r);
+        f = compose(f, f);
+        len >>= 1;
+    }
+    return r;
+}
+
+/* ----------------------------------------------------------------
+ * In-register scan of one block, constant coefficients
+ * ---------------------------------------------------------------- */
+
+typedef double v4d __attribute__((vector_size(32)));
+
+/* Offsets of step k: x[i+k] = P[k] * x[i-1] + Q[k] */
+typedef struct {
+    double a, b;
+    double P[SCAN_STEP] __attribute__((aligned(32)));
+    double Q[SCAN_STEP] __attribute__((aligned(32)));
+} scan_coef_t;
+
+static void coef_init(scan_coef_t *c, double a, double b)
+{
+    affine_t f = {a, b}, g = f;
+    c->a = a;
+    c->b = b;
+    for (int k = 0; k < SCAN_STEP; k++) {
+        c->P[k] = g.a;
+        c->Q[k] = g.b;
+        g = compose(f, g);
+    }
+}
+
+/* x[0..len) from the value before x[0]: the only dependency between
+ * steps is the last element of the previous one */
+#define SCAN_BLOCK_BODY                                                   \
+    {                                                                     \
+        v4d P0, P1, P2, P3, Q0, Q1, Q2, Q3;                               \
+        memcpy(&P0, c->P, 32); memcpy(&P1, c->P + 4, 32);                 \
+        memcpy(&P2, c->P + 8, 32); memcpy(&P3, c->P + 12, 32);            \
+        memcpy(&Q0, c->Q, 32); memcpy(&Q1, c->Q + 4, 32);                 \
+        memcpy(&Q2, c->Q + 8, 32); memcpy(&Q3, c->Q + 12, 32);            \
+        size_t i = 0;                                                     \
+        for (; i + SCAN_STEP <= len; i += SCAN_STEP) {                    \
+            v4d v = {prev, prev, prev, prev};                             \
+            v4d y0 = P0 * v + Q0, y1 = P1 * v + Q1;                       \
+            v4d y2 = P2 * v + Q2, y3 = P3 * v + Q3;                       \
+            memcpy(x + i, &y0, 32); memcpy(x + i + 4, &y1, 32);           \
+            memcpy(x + i + 8, &y2, 32); memcpy(x + i + 12, &y3, 32);      \
+            prev = y3[3];                                                 \
+        }                                                                 \
+        for (; i < len; i++) x[i] = prev = c->a * prev + c->b;            \
+    }
+
+static void block_generic(double *restrict x, size_t len, double prev, const scan_coef_t *c)
+SCAN_BLOCK_BODY
+
+__attribute__((target(AVX2_TARGET)))
+static void block_avx2(double *restrict x, size_t len, double prev, const scan_coef_t *c)
+SCAN_BLOCK_BODY
+
+typedef void (*block_fn)(double *restrict, size_t, double, const scan_coef_t *);
+
+static block_fn pick_block(void)
+{
+    static block_fn fn;
+    if (!fn) {
+        __builtin_cpu_init();
+        fn = (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+                 ? block_avx2 : block_generic;
+    }
+    return fn;
+}
+
+/* ----------------------------------------------------------------
+ * Public API
+ * ---------------------------------------------------------------- */
+
+void scan_affine_serial(double *x, size_t n, double x0, double a, double b)
+{
+    if (n == 0) return;
+    x[0] = x0;
+    for (size_t i = 1; i < n; i++) x[i] = a * x[i-1] + b;
+}
+
+static int max_threads(void)
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/* Bounds of block t of T over elements 1 .. n-1 (x[0] is given) */
+static void block_range(size_t n, int t, int T, size_t *lo, size_t *hi)
+{
+    size_t m = n - 1;
+    *lo = 1 + m * t / T;
+    *hi = 1 + m * (t + 1) / T;
+}
+
+void scan_affine(double *x, size_t n, double x0, double a, double b)
+{
+    if (n == 0) return;
+
+    scan_coef_t c;
+    coef_init(&c, a, b);
+    block_fn block = pick_block();
+    x[0] = x0;
+
+    if (n < SCAN_PAR_MIN || max_threads() == 1) {
+        block(x + 1, n - 1, x0, &c);
+        return;
+    }
+
+    /* Value entering each block */
+    double *start = malloc((size_t)(max_threads() + 1) * sizeof(double));
+    if (!start) {
+        scan_affine_serial(x, n, x0, a, b);
+        return;
+    }
+
+    #pragma omp parallel
+    {
+        int t = 0, T = 1;
+#ifdef _OPENMP
+        t = omp_get_thread_num();
+        T = omp_get_num_threads();
+#endif
+        size_t lo, hi;
+        block_range(n, t, T, &lo, &hi);
+
+        /* Pass 1 is O(log L) here; only the serial carry chain is left */
+        #pragma omp single
+        {
+            affine_t f = {a, b};
+            start[0] = x0;
+            for (int u = 0; u < T; u++) {
+                size_t ulo, uhi;
+                block_range(n, u, T, &ulo, &uhi);
+                affine_t g = affine_pow(f, uhi - ulo);
+                start[u + 1] = g.a * start[u] + g.b;
+            }
+        }
+
+        /* Pass 2 */
+        block(x + lo, hi - lo, start[t], &c);
+    }
+    free(start);
+}
+
+double scan_check(const double *x, size_t n, double x0, double a, double b)
+{
+    double *ref = malloc((n ? n : 1) * sizeof(double));
+    if (!ref) return -1.0;
+
+    scan_affine_serial(ref, n, x0, a, b);
+    double worst = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double d = fabs(x[i] - ref[i]);
+        if (ref[i] != 0.0) d /= fabs(ref[i]);
+        if (d > worst) worst = d;
+    }
+    free(ref);
+    return worst;
+}
@@ -0,0 +1,57 @@
+/* ================================================================
+ * Parallel scan of affine recurrences  x[i] = a * x[i-1] + b
+ * ================================================================
+ *
+ * The recurrence looks strictly sequential, but affine maps
+ * f(x) = a x + b compose into affine maps,
+ *
+ *   (a2, b2) o (a1, b1) = (a2 a1, a2 b1 + b2),
+ *
+ * and composition is associative, so it can be scanned in parallel:
+ *
+ *   pass 1  every thread composes the map of its block, in O(log L)
+ *           by squaring,
+ *   serial  the T block maps are applied in order to get the value
+ *           entering each block,
+ *   pass 2  every thread rebuilds its block from that value.
+ *
+ * Inside a block, x is produced SCAN_STEP elements at a time from
+ * the last value only:
+ *
+ *   x[i+k] = a^(k+1) x[i-1] + b (1 + a + ... + a^k),   k < SCAN_STEP
+ *
+ * with the powers precomputed in vector registers, so the dependency
+ * chain is one FMA per SCAN_STEP elements instead of one per element
+ * (AVX2 path when the CPU has it, generic vectors otherwise).
+ *
+ * The results differ from the serial loop by rounding only (the
+ * powers are rounded once instead of step by step); scan_check()
+ * measures that difference.
+ *
+ * COMPILATION: add  -I../common ../common/scan.c  (and -fopenmp for
+ * the threaded passes) to the compile line.
+ * ================================================================ */
+
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+
+/* Elements produced per step of the in-register scan */
+#define SCAN_STEP 16
+
+/* Below this length one thread does the whole scan */
+#ifndef SCAN_PAR_MIN
+#define SCAN_PAR_MIN (1 << 16)
+#endif
+
+/* x[0] = x0, x[i] = a * x[i-1] + b: reference loop */
+void scan_affine_serial(double *x, size_t n, double x0, double a, double b);
+
+/* Same result (up to rounding), blocked over threads + SIMD */
+void scan_affine(double *x, size_t n, double x0, double a, double b);
+
+/* Largest relative difference of x from the serial recurrence */
+double scan_check(const double *x, size_t n, double x0, double a, double b);
+
+#endif /* SCAN_H */
@@ -0,0 +1,426 @@
+/* ================================================================
+ * Multi-accumulator SIMD reductions (see simd_reduce.h)
+ * ================================================================ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "simd_reduce.h"
+
+#define REDUCE_CAT_(a, b, c) a##_##b##_##c
+#define REDUCE_CAT(a, b, c)  REDUCE_CAT_(a, b, c)
+
+#define AVX2_TARGET   "avx2,fma"
+#define AVX512_TARGET "avx512f,avx512bw,avx512dq"
+
+/* ----------------------------------------------------------------
+ * Kernels: scalar first (the vector paths fall back on them)
+ * ---------------------------------------------------------------- */
+
+#define RT float
+#define RM int
+#define RS f
+#define RI scalar
+#define RVB 0
+#include "simd_reduce_kernels.h"
+
+#define RT double
+#define RM long long
+#define RS d
+#define RI scalar
+#define RVB 0
+#include "simd_reduce_kernels.h"
+
+#define RT int
+#define RM int
+#define RS i
+#define RI scalar
+#define RVB 0
+#include "simd_reduce_kernels.h"
+
+#define RT short
+#define RM short
+#define RS s
+#define RI scalar
+#define RVB 0
+#include "simd_reduce_kernels.h"
+
+#define RT long long
+#define RM long long
+#define RS ll
+#define RI scalar
+#define RVB 0
+#include "simd_reduce_kernels.h"
+
+/* AVX2, then AVX-512 */
+#define RT float
+#define RM int
+#define RS f
+#define RI avx2
+#define RVB 32
+#define RTARGET AVX2_TARGET
+#include "simd_reduce_kernels.h"
+
+#define RT double
+#define RM long long
+#define RS d
+#define RI avx2
+#define RVB 32
+#define RTARGET AVX2_TARGET
+#include "simd_reduce_kernels.h"
+
+#define RT int
+#define RM int
+#define RS i
+#define RI avx2
+#define RVB 32
+#define RTARGET AVX2_TARGET
+#include "simd_reduce_kernels.h"
+
+#define RT short
+#define RM short
+#define RS s
+#define RI avx2
+#define RVB 32
+#define RTARGET AVX2_TARGET
+#include "simd_reduce_kernels.h"
+
+#define RT long long
+#define RM long long
+#define RS ll
+#define RI avx2
+#define RVB 32
+#define RTARGET AVX2_TARGET
+#include "simd_reduce_kernels.h"
+
+#define RT float
+#define RM int
+#define RS f
+#define RI avx512
+#define RVB 64
+#define RTARGET AVX512_TARGET
+#include "simd_reduce_kernels.h"
+
+#define RT double
+#define RM long long
+#define RS d
+#define RI avx512
+#define RVB 64
+#define RTARGET AVX512_TARGET
+#include "simd_reduce_kernels.h"
+
+#define RT int
+#define RM int
+#define RS i
+#define RI avx512
+#define RVB 64
+#define RTARGET AVX512_TARGET
+#include "simd_reduce_kernels.h"
+
+#define RT short
+#define RM short
+#define RS s
+#define RI avx512
+#define RVB 64
+#define RTARGET AVX512_TARGET
+#include "simd_reduce_kernels.h"
+
+#define RT long long
+#define RM long long
+#define RS ll
+#define RI avx512
+#define RVB 64
+#define RTARGET AVX512_TARGET
+#include "simd_reduce_kernels.h"
+
+/* ----------------------------------------------------------------
+ * Widening sums of narrow integers into 64 bits
+ * ---------------------------------------------------------------- */
+
+#define WSUM_SCALAR(sfx, T)                                             \
+    static long long wsum_##sfx##_scalar(const T *a, size_t n)          \
+    {                                                                   \
+        long long s[REDUCE_ACCUMULATORS] = {0};                         \
+        size_t i = 0;                                                   \
+        for (; i + REDUCE_ACCUMULATORS <= n; i += REDUCE_ACCUMULATORS)  \
+            for (int k = 0; k < REDUCE_ACCUMULATORS; k++) s[k] += a[i + k]; \
+        for (; i < n; i++) s[0] += a[i];                                \
+        for (int k = 1; k < REDUCE_ACCUMULATORS; k++) s[0] += s[k];     \
+        return s[0];                                                    \
+    }
+
+WSUM_SCALAR(c, signed char)
+WSUM_SCALAR(s, short)
+WSUM_SCALAR(i, int)
+
+#undef WSUM_SCALAR
+
+__attribute__((target(AVX2_TARGET)))
+static long long hsum_epi64_avx2(__m256i v)
+{
+    __m128i s = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    return _mm_cvtsi128_si64(s) + _mm_extract_epi64(s, 1);
+}
+
+/* acc64 += sign-extended 32-bit lanes of s */
+__attribute__((target(AVX2_TARGET)))
+static __m256i spill32_avx2(__m256i acc64, __m256i s)
+{
+    acc64 = _mm256_add_epi64(acc64, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(s)));
+    return _mm256_add_epi64(acc64, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(s, 1)));
+}
+
+__attribute__((target(AVX2_TARGET)))
+static long long wsum_c_avx2(const signed char *a, size_t n)
+{
+    const __m256i bias = _mm256_set1_epi8((char)0x80), zero = _mm256_setzero_si256();
+    __m256i s0 = zero, s1 = zero, s2 = zero, s3 = zero;
+    size_t i = 0;
+
+    for (; i + 128 <= n; i += 128) {
+        __m256i x0 = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i x1 = _mm256_loadu_si256((const __m256i *)(a + i + 32));
+        __m256i x2 = _mm256_loadu_si256((const __m256i *)(a + i + 64));
+        __m256i x3 = _mm256_loadu_si256((const __m256i *)(a + i + 96));
+        s0 = _mm256_add_epi64(s0, _mm256_sad_epu8(_mm256_xor_si256(x0, bias), zero));
+        s1 = _mm256_add_epi64(s1, _mm256_sad_epu8(_mm256_xor_si256(x1, bias), zero));
+        s2 = _mm256_add_epi64(s2, _mm256_sad_epu8(_mm256_xor_si256(x2, bias), zero));
+        s3 = _mm256_add_epi64(s3, _mm256_sad_epu8(_mm256_xor_si256(x3, bias), zero));
+    }
+    s0 = _mm256_add_epi64(_mm256_add_epi64(s0, s1), _mm256_add_epi64(s2, s3));
+
+    /* Every byte was biased by +128 */
+    long long r = hsum_epi64_avx2(s0) - 128LL * (long long)i;
+    return r + wsum_c_scalar(a + i, n - i);
+}
+
+__attribute__((target(AVX2_TARGET)))
+static long long wsum_s_avx2(const short *a, size_t n)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i acc64 = _mm256_setzero_si256();
+    size_t i = 0;
+
+    while (i + 64 <= n) {
+        __m256i s0 = _mm256_setzero_si256(), s1 = s0, s2 = s0, s3 = s0;
+        size_t iters = (n - i) / 64;
+        if (iters > REDUCE_WSUM16_BLOCK) iters = REDUCE_WSUM16_BLOCK;
+
+        for (size_t it = 0; it < iters; it++, i += 64) {
+            s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)(a + i)), ones));
+            s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)(a + i + 16)), ones));
+            s2 = _mm256_add_epi32(s2, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)(a + i + 32)), ones));
+            s3 = _mm256_add_epi32(s3, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)(a + i + 48)), ones));
+        }
+        /* Spill before the 32-bit lanes can overflow */
+        acc64 = spill32_avx2(acc64, s0);
+        acc64 = spill32_avx2(acc64, s1);
+        acc64 = spill32_avx2(acc64, s2);
+        acc64 = spill32_avx2(acc64, s3);
+    }
+    return hsum_epi64_avx2(acc64) + wsum_s_scalar(a + i, n - i);
+}
+
+__attribute__((target(AVX2_TARGET)))
+static long long wsum_i_avx2(const int *a, size_t n)
+{
+    __m256i s0 = _mm256_setzero_si256(), s1 = s0, s2 = s0, s3 = s0;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        s0 = _mm256_add_epi64(s0, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)(a + i))));
+        s1 = _mm256_add_epi64(s1, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)(a + i + 4))));
+        s2 = _mm256_add_epi64(s2, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)(a + i + 8))));
+        s3 = _mm256_add_epi64(s3, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)(a + i + 12))));
+    }
+    s0 = _mm256_add_epi64(_mm256_add_epi64(s0, s1), _mm256_add_epi64(s2, s3));
+    return hsum_epi64_avx2(s0) + wsum_i_scalar(a + i, n - i);
+}
+
+__attribute__((target(AVX512_TARGET)))
+static long long wsum_c_avx512(const signed char *a, size_t n)
+{
+    const __m512i bias = _mm512_set1_epi8((char)0x80), zero = _mm512_setzero_si512();
+    __m512i s0 = zero, s1 = zero, s2 = zero, s3 = zero;
+    size_t i = 0;
+
+    for (; i + 256 <= n; i += 256) {
+        s0 = _mm512_add_epi64(s0, _mm512_sad_epu8(_mm512_xor_si512(_mm512_loadu_si512(a + i), bias), zero));
+        s1 = _mm512_add_epi64(s1, _mm512_sad_epu8(_mm512_xor_si512(_mm512_loadu_si512(a + i + 64), bias), zero));
+        s2 = _mm512_add_epi64(s2, _mm512_sad_epu8(_mm512_xor_si512(_mm512_loadu_si512(a + i + 128), bias), zero));
+        s3 = _mm512_add_epi64(s3, _mm512_sad_epu8(_mm512_xor_si512(_mm512_loadu_si512(a + i + 192), bias), zero));
+    }
+    s0 = _mm512_add_epi64(_mm512_add_epi64(s0, s1), _mm512_add_epi64(s2, s3));
+
+    long long r = _mm512_reduce_add_epi64(s0) - 128LL * (long long)i;
+    return r + wsum_c_scalar(a + i, n - i);
+}
+
+__attribute__((target(AVX512_TARGET)))
+static __m512i spill32_avx512(__m512i acc64, __m512i s)
+{
+    acc64 = _mm512_add_epi64(acc64, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(s)));
+    return _mm512_add_epi64(acc64, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(s, 1)));
+}
+
+__attribute__((target(AVX512_TARGET)))
+static long long wsum_s_avx512(const short *a, size_t n)
+{
+    const __m512i ones = _mm512_set1_epi16(1);
+    __m512i acc64 = _mm512_setzero_si512();
+    size_t i = 0;
+
+    while (i + 128 <= n) {
+        __m512i s0 = _mm512_setzero_si512(), s1 = s0, s2 = s0, s3 = s0;
+        size_t iters = (n - i) / 128;
+        if (iters > REDUCE_WSUM16_BLOCK) iters = REDUCE_WSUM16_BLOCK;
+
+        for (size_t it = 0; it < iters; it++, i += 128) {
+            s0 = _mm512_add_epi32(s0, _mm512_madd_epi16(_mm512_loadu_si512(a + i), ones));
+            s1 = _mm512_add_epi32(s1, _mm512_madd_epi16(_mm512_loadu_si512(a + i + 32), ones));
+            s2 = _mm512_add_epi32(s2, _mm512_madd_epi16(_mm512_loadu_si512(a + i + 64), ones));
+            s3 = _mm512_add_epi32(s3, _mm512_madd_epi16(_mm512_loadu_si512(a + i + 96), ones));
+        }
+        acc64 = spill32_avx512(acc64, s0);
+        acc64 = spill32_avx512(acc64, s1);
+        acc64 = spill32_avx512(acc64, s2);
+        acc64 = spill32_avx512(acc64, s3);
+    }
+    return _mm512_reduce_add_epi64(acc64) + wsum_s_scalar(a + i, n - i);
+}
+
+__attribute__((target(AVX512_TARGET)))
+static long long wsum_i_avx512(const int *a, size_t n)
+{
+    __m512i s0 = _mm512_setzero_si512(), s1 = s0, s2 = s0, s3 = s0;
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        s0 = _mm512_add_epi64(s0, _mm512_cvtepi32_epi64(_mm256_loadu_si256((const __m256i *)(a + i))));
+        s1 = _mm512_add_epi64(s1, _mm512_cvtepi32_epi64(_mm256_loadu_si256((const __m256i *)(a + i + 8))));
+        s2 = _mm512_add_epi64(s2, _mm512_cvtepi32_epi64(_mm256_loadu_si256((const __m256i *)(a + i + 16))));
+        s3 = _mm512_add_epi64(s3, _mm512_cvtepi32_epi64(_mm256_loadu_si256((const __m256i *)(a + i + 24))));
+    }
+    s0 = _mm512_add_epi64(_mm512_add_epi64(s0, s1), _mm512_add_epi64(s2, s3));
+    return _mm512_reduce_add_epi64(s0) + wsum_i_scalar(a + i, n - i);
+}
+
+/* ----------------------------------------------------------------
+ * Path selection
+ * ---------------------------------------------------------------- */
+
+static int isa_max = -1;   /* detected once */
+static int isa_cur = -1;   /* in use        */
+
+reduce_isa_t reduce_isa_max(void)
+{
+    if (isa_max >= 0) return (reduce_isa_t)isa_max;
+
+    reduce_isa_t best = REDUCE_ISA_SCALAR;
+
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        best = REDUCE_ISA_AVX2;
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512dq"))
+        best = REDUCE_ISA_AVX512;
+
+    /* Optional override, never above what the CPU supports */
+    const char *env = getenv("REDUCE_ISA");
+    if (env) {
+        reduce_isa_t want = best;
+        if (strcmp(env, "scalar") == 0) want = REDUCE_ISA_SCALAR;
+        else if (strcmp(env, "avx2") == 0) want = REDUCE_ISA_AVX2;
+        else if (strcmp(env, "avx512") == 0) want = REDUCE_ISA_AVX512;
+        if (want < best) best = want;
+    }
+
+    isa_max = best;
+    return best;
+}
+
+reduce_isa_t reduce_isa(void)
+{
+    if (isa_cur < 0) isa_cur = reduce_isa_max();
+    return (reduce_isa_t)isa_cur;
+}
+
+reduce_isa_t reduce_set_isa(reduce_isa_t isa)
+{
+    reduce_isa_t best = reduce_isa_max();
+    isa_cur = (isa > best) ? best : isa;
+    return (reduce_isa_t)isa_cur;
+}
+
+const char *reduce_isa_name(reduce_isa_t isa)
+{
+    switch (isa) {
+    case REDUCE_ISA_AVX512: return "avx512";
+    case REDUCE_ISA_AVX2:   return "avx2";
+    default:                return "scalar";
+    }
+}
+
+/* ----------------------------------------------------------------
+ * Public entry points
+ * ---------------------------------------------------------------- */
+
+#define REDUCE_DISPATCH(op, sfx, args)                                  \
+    switch (reduce_isa()) {                                             \
+    case REDUCE_ISA_AVX512: return op##_##sfx##_avx512 args;            \
+    case REDUCE_ISA_AVX2:   return op##_##sfx##_avx2 args;              \
+    default:                return op##_##sfx##_scalar args;            \
+    }
+
+#define REDUCE_DEFINE(sfx, T)                                                   \
+    T reduce_sum_##sfx(const T *a, size_t n)   { REDUCE_DISPATCH(sum, sfx, (a, n)) }   \
+    T reduce_sumsq_##sfx(const T *a, size_t n) { REDUCE_DISPATCH(sumsq, sfx, (a, n)) } \
+    T reduce_min_##sfx(const T *a, size_t n)   { REDUCE_DISPATCH(min, sfx, (a, n)) }   \
+    T reduce_max_##sfx(const T *a, size_t n)   { REDUCE_DISPATCH(max, sfx, (a, n)) }   \
+    T reduce_dot_##sfx(const T *a, const T *b, size_t n)                        \
+                                               { REDUCE_DISPATCH(dot, sfx, (a, b, n)) }
+
+REDUCE_DEFINE(f, float)
+REDUCE_DEFINE(d, double)
+REDUCE_DEFINE(i, int)
+REDUCE_DEFINE(s, short)
+REDUCE_DEFINE(ll, long long)
+
+long long reduce_wsum_c(const signed char *a, size_t n) { REDUCE_DISPATCH(wsum, c, (a, n)) }
+long long reduce_wsum_s(const short *a, size_t n)       { REDUCE_DISPATCH(wsum, s, (a, n)) }
+long long reduce_wsum_i(const int *a, size_t n)         { REDUCE_DISPATCH(wsum, i, (a, n)) }
+
+/* ----------------------------------------------------------------
+ * Sum ladder
+ * ---------------------------------------------------------------- */
+
+/* (path tag, reduce_isa_t) */
+#define REDUCE_PATHS(X, ...)                                            \
+    X(__VA_ARGS__, scalar, REDUCE_ISA_SCALAR)                           \
+    X(__VA_ARGS__, avx2,   REDUCE_ISA_AVX2)                             \
+    X(__VA_ARGS__, avx512, REDUCE_ISA_AVX512)
+
+#define VARIANT_ENTRY(unused, isa, E, sfx, T, U, A)                     \
+    {"sum_" #sfx "_u" #U "_a" #A "_" #isa, REDUCE_TYPE_##sfx, U, A, E,  \
+     ladder_##sfx##_##isa##_u##U##_a##A},
+#define VARIANT_TYPE(unused, isa, E, sfx, T)                            \
+    REDUCE_SUM_SHAPES(VARIANT_ENTRY, ~, isa, E, sfx, T)
+#define VARIANT_PATH(unused, isa, E)                                    \
+    REDUCE_TYPES(VARIANT_TYPE, ~, isa, E)
+
+static const reduce_variant_t variants[] = {
+    REDUCE_PATHS(VARIANT_PATH, ~)
+};
+
+#define NVARIANTS ((int)(sizeof(variants) / sizeof(variants[0])))
+
+int reduce_sum_variant_count(void)
+{
+    return NVARIANTS;
+}
+
+const reduce_variant_t *reduce_sum_variant(int i)
+{
+    return (i >= 0 && i < NVARIANTS) ? &variants[i] : NULL;
+}
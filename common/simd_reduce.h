@@ -0,0 +1,175 @@
+/* ================================================================
+ * Multi-accumulator SIMD reductions: sum, sum of squares, min, max
+ * and dot product
+ * ================================================================
+ *
+ * A loop such as  for (i...) sum += a[i];  is a chain of dependent
+ * adds: however far it is unrolled, every add waits for the previous
+ * one (3-4 cycles for FP), so it runs at one element per add
+ * latency.  These kernels keep REDUCE_ACCUMULATORS independent
+ * vector accumulators instead, enough to cover the add latency at
+ * two vector adds per cycle, and only combine them at the end.
+ *
+ * Each operation exists for the element types the TP2 benchmarks
+ * switch on with -DT:
+ *
+ *   suffix   element     result
+ *   _f       float       float
+ *   _d       double      double
+ *   _i       int         int        (wraps like  int sum )
+ *   _s       short       short      (wraps like  short sum )
+ *   _ll      long long   long long
+ *
+ * Integer results are computed in the element type, exactly as the
+ * benchmarks' own  T sum  does (use reduce_wsum below for an exact
+ * sum).  FP results are summed in a different order than the serial
+ * loop, so they may differ in the last bits.
+ * min/max of an empty array return 0.
+ *
+ * The type-generic macros  reduce_sum(a, n), reduce_sumsq(a, n),
+ * reduce_min(a, n), reduce_max(a, n), reduce_dot(a, b, n)  pick the
+ * function from the pointer type, so  -DT=short  just works.
+ *
+ * The code path is chosen at runtime from the host CPU:
+ *   AVX-512 (F+BW+DQ) : 512-bit vectors
+ *   AVX2              : 256-bit vectors
+ *   scalar            : REDUCE_ACCUMULATORS scalar accumulators
+ * REDUCE_ISA=scalar|avx2|avx512 in the environment, or
+ * reduce_set_isa(), selects a lower path for comparisons.
+ *
+ * Widening sums (exact, never wrap): narrow integers summed into a
+ * 64-bit result without a scalar sign extension per element.
+ *
+ *   reduce_wsum_c   signed char (int8)  -> long long
+ *   reduce_wsum_s   short (int16)       -> long long
+ *   reduce_wsum_i   int (int32)         -> long long
+ *   reduce_wsum(a, n)                      type-generic
+ *
+ *   int8  : bias to unsigned (x ^ 0x80), vpsadbw against zero adds
+ *           8 bytes straight into each 64-bit lane; the bias is
+ *           subtracted once at the end.
+ *   int16 : vpmaddwd with a vector of ones adds pairs into 32-bit
+ *           lanes; the 32-bit accumulators are spilled into 64-bit
+ *           ones every REDUCE_WSUM16_BLOCK iterations, before they
+ *           can overflow.
+ *   int32 : vpmovsxdq loads straight into 64-bit accumulators.
+ *
+ * Sum ladder: besides reduce_sum (REDUCE_ACCUMULATORS vectors per
+ * iteration, one accumulator each), the sum body is also built for
+ * every (unroll U, accumulators A) of REDUCE_SUM_SHAPES on every path
+ * and type, and listed by reduce_sum_variant().  With A = 1 the
+ * unrolled loop is still one dependency chain (the TP2 unroll
+ * ladder); A > 1 is what breaks it.  kernel_family.h times them and
+ * dispatches to the fastest.
+ *
+ * COMPILATION: add  -I../common ../common/simd_reduce.c  to the
+ * compile line.  No -mavx2 / -mavx512f flag is needed: the SIMD
+ * kernels carry function-level target attributes.
+ * ================================================================ */
+
+#ifndef SIMD_REDUCE_H
+#define SIMD_REDUCE_H
+
+#include <stddef.h>
+
+/* Independent accumulators per kernel (vectors, or scalars) */
+#define REDUCE_ACCUMULATORS 4
+
+/* Element types, as (suffix, type) */
+#define REDUCE_TYPES(X, ...)                                            \
+    X(__VA_ARGS__, f, float)                                            \
+    X(__VA_ARGS__, d, double)                                           \
+    X(__VA_ARGS__, i, int)                                              \
+    X(__VA_ARGS__, s, short)                                            \
+    X(__VA_ARGS__, ll, long long)
+
+/* Sum ladder shapes, as (unroll, accumulators) with A <= min(U, 8) */
+#define REDUCE_SUM_SHAPES(X, ...)                                       \
+    X(__VA_ARGS__, 1, 1)                                                \
+    X(__VA_ARGS__, 2, 1)   X(__VA_ARGS__, 2, 2)                         \
+    X(__VA_ARGS__, 4, 1)   X(__VA_ARGS__, 4, 2)   X(__VA_ARGS__, 4, 4)  \
+    X(__VA_ARGS__, 8, 1)   X(__VA_ARGS__, 8, 2)   X(__VA_ARGS__, 8, 4)   X(__VA_ARGS__, 8, 8)  \
+    X(__VA_ARGS__, 16, 1)  X(__VA_ARGS__, 16, 4)  X(__VA_ARGS__, 16, 8) \
+    X(__VA_ARGS__, 32, 1)  X(__VA_ARGS__, 32, 4)  X(__VA_ARGS__, 32, 8)
+
+#define REDUCE_TYPE_ENUM(unused, sfx, T) REDUCE_TYPE_##sfx,
+typedef enum {
+    REDUCE_TYPES(REDUCE_TYPE_ENUM, ~)
+    REDUCE_NTYPES
+} reduce_type_t;
+#undef REDUCE_TYPE_ENUM
+
+typedef enum {
+    REDUCE_ISA_SCALAR = 0,
+    REDUCE_ISA_AVX2   = 1,
+    REDUCE_ISA_AVX512 = 2
+} reduce_isa_t;
+
+/* Best path of this CPU (honours REDUCE_ISA if set) */
+reduce_isa_t reduce_isa_max(void);
+/* Path used by the reduce_* functions */
+reduce_isa_t reduce_isa(void);
+/* Select a path, clamped to reduce_isa_max(); returns the one in use */
+reduce_isa_t reduce_set_isa(reduce_isa_t isa);
+const char  *reduce_isa_name(reduce_isa_t isa);
+
+/* One member of the sum ladder; fn returns the sum (in the element
+ * type, so integers wrap) converted to double */
+typedef struct {
+    const char   *name;      /* sum_<sfx>_u<U>_a<A>_<isa>, e.g. sum_d_u8_a4_avx2 */
+    reduce_type_t type;
+    int           unroll;
+    int           accs;
+    reduce_isa_t  isa;
+    double      (*fn)(const void *a, size_t n);
+} reduce_variant_t;
+
+int                     reduce_sum_variant_count(void);
+/* NULL when i is out of range; callers check isa <= reduce_isa_max() */
+const reduce_variant_t *reduce_sum_variant(int i);
+
+#define REDUCE_DECLARE(sfx, T)                                          \
+    T reduce_sum_##sfx(const T *a, size_t n);                           \
+    T reduce_sumsq_##sfx(const T *a, size_t n);                         \
+    T reduce_min_##sfx(const T *a, size_t n);                           \
+    T reduce_max_##sfx(const T *a, size_t n);                           \
+    T reduce_dot_##sfx(const T *a, const T *b, size_t n);
+
+REDUCE_DECLARE(f, float)
+REDUCE_DECLARE(d, double)
+REDUCE_DECLARE(i, int)
+REDUCE_DECLARE(s, short)
+REDUCE_DECLARE(ll, long long)
+
+#undef REDUCE_DECLARE
+
+/* Vector iterations between spills of the 32-bit int16 accumulators:
+ * a vpmaddwd lane is at most 2 * 32768 = 2^16 in magnitude, so 2^15
+ * of them fit in an int32; keep a factor 2 of margin */
+#define REDUCE_WSUM16_BLOCK 16384
+
+long long reduce_wsum_c(const signed char *a, size_t n);
+long long reduce_wsum_s(const short *a, size_t n);
+long long reduce_wsum_i(const int *a, size_t n);
+
+#define REDUCE_GENERIC(op, a)                                           \
+    _Generic((a),                                                       \
+        float *: reduce_##op##_f,           const float *: reduce_##op##_f,      \
+        double *: reduce_##op##_d,          const double *: reduce_##op##_d,     \
+        int *: reduce_##op##_i,             const int *: reduce_##op##_i,        \
+        short *: reduce_##op##_s,           const short *: reduce_##op##_s,      \
+        long long *: reduce_##op##_ll,      const long long *: reduce_##op##_ll)
+
+#define reduce_wsum(a, n)                                               \
+    _Generic((a),                                                       \
+        signed char *: reduce_wsum_c,       const signed char *: reduce_wsum_c,  \
+        short *: reduce_wsum_s,             const short *: reduce_wsum_s,        \
+        int *: reduce_wsum_i,               const int *: reduce_wsum_i)(a, n)
+
+#define reduce_sum(a, n)     REDUCE_GENERIC(sum, a)(a, n)
+#define reduce_sumsq(a, n)   REDUCE_GENERIC(sumsq, a)(a, n)
+#define reduce_min(a, n)     REDUCE_GENERIC(min, a)(a, n)
+#define reduce_max(a, n)     REDUCE_GENERIC(max, a)(a, n)
+#define reduce_dot(a, b, n)  REDUCE_GENERIC(dot, a)(a, b, n)
+
+#endif /* SIMD_REDUCE_H */
@@ -0,0 +1,275 @@
+/* ================================================================
+ * Kernel bodies of simd_reduce.c, included once per (type, path)
+ * ================================================================
+ *
+ * Not a public header.  The includer #defines
+ *
+ *   RT       element type
+ *   RM       signed integer type of the same width as RT (masks)
+ *   RS       function suffix (f, d, i, s, ll)
+ *   RI       path tag (scalar, avx2, avx512)
+ *   RVB      vector bytes, 0 for the scalar path
+ *   RTARGET  target attribute string (vector paths only)
+ *
+ * and gets  sum_<RS>_<RI>, sumsq_, min_, max_, dot_  as static
+ * functions, plus the sum ladder  ladder_<RS>_<RI>_u<U>_a<A>  for
+ * every shape of REDUCE_SUM_SHAPES.  The parameters are #undef'd at
+ * the end.
+ *
+ * Vector paths use GCC vector extensions: +, *, < on a vector type
+ * compile to the instruction set of the function's target attribute
+ * (vaddpd, vpaddw, vpmullq, vcmppd ...), which keeps one body for
+ * all five element types instead of one intrinsic set per type.
+ * Every path keeps K independent accumulators and only combines
+ * them after the main loop; the vector paths call the scalar kernel
+ * of the same type for arrays shorter than K vectors.
+ *
+ * The sum (and its ladder) is one body for both paths: the scalar
+ * path runs it on one-lane vectors, which compile to scalar code.
+ * ================================================================ */
+
+#define R_FN(op)      REDUCE_CAT(op, RS, RI)
+#define R_SCALAR(op)  REDUCE_CAT(op, RS, scalar)
+#define R_LADDER(U, A) REDUCE_CAT(R_FN(ladder), u##U, a##A)
+#define K             REDUCE_ACCUMULATORS
+
+/* Sum of a[0..n): U vectors of LW lanes per iteration, added
+ * round-robin into A accumulators; returns RET */
+#define R_SUM_BODY(name, RET, VT, LW, ATTR, U, A)                       \
+    ATTR static RET name(const void *p, size_t n)                       \
+    {                                                                   \
+        const RT *a = p;                                                \
+        VT s[A];                                                        \
+        size_t i = 0;                                                   \
+                                                                        \
+        for (int k = 0; k < (A); k++) s[k] = (VT){0};                   \
+        for (; i + (U) * (LW) <= n; i += (U) * (LW)) {                  \
+            _Pragma("GCC unroll 32")                                    \
+            for (int u = 0; u < (U); u++) {                             \
+                VT x;                                                   \
+                memcpy(&x, a + i + u * (LW), sizeof(x));                \
+                s[u % (A)] += x;                                        \
+            }                                                           \
+        }                                                               \
+        for (int k = 1; k < (A); k++) s[0] += s[k];                     \
+                                                                        \
+        RT r = 0;                                                       \
+        for (size_t l = 0; l < (LW); l++) r += s[0][l];                 \
+        for (; i < n; i++) r += a[i];                                   \
+        return (RET)r;                                                  \
+    }
+
+#if RVB == 0
+
+/* ---------------------------------------------------------------- */
+/* Scalar path: K scalar accumulators                                */
+/* ---------------------------------------------------------------- */
+
+typedef RT REDUCE_CAT(vec, RS, RI) __attribute__((vector_size(sizeof(RT))));
+
+R_SUM_BODY(R_FN(sum), RT, REDUCE_CAT(vec, RS, RI), 1, , K, K)
+
+#define R_LADDER_DEFINE(unused, U, A)                                   \
+    R_SUM_BODY(R_LADDER(U, A), double, REDUCE_CAT(vec, RS, RI), 1, , U, A)
+REDUCE_SUM_SHAPES(R_LADDER_DEFINE, ~)
+#undef R_LADDER_DEFINE
+
+static RT R_FN(sumsq)(const RT *a, size_t n)
+{
+    RT s[K] = {0};
+    size_t i = 0;
+
+    for (; i + K <= n; i += K)
+        for (int k = 0; k < K; k++) s[k] += a[i + k] * a[i + k];
+    for (; i < n; i++) s[0] += a[i] * a[i];
+    for (int k = 1; k < K; k++) s[0] += s[k];
+    return s[0];
+}
+
+static RT R_FN(dot)(const RT *a, const RT *b, size_t n)
+{
+    RT s[K] = {0};
+    size_t i = 0;
+
+    for (; i + K <= n; i += K)
+        for (int k = 0; k < K; k++) s[k] += a[i + k] * b[i + k];
+    for (; i < n; i++) s[0] += a[i] * b[i];
+    for (int k = 1; k < K; k++) s[0] += s[k];
+    return s[0];
+}
+
+static RT R_FN(min)(const RT *a, size_t n)
+{
+    RT m[K];
+    size_t i = 0;
+
+    if (n == 0) return 0;
+    for (int k = 0; k < K; k++) m[k] = a[0];
+    for (; i + K <= n; i += K)
+        for (int k = 0; k < K; k++) m[k] = (a[i + k] < m[k]) ? a[i + k] : m[k];
+    for (; i < n; i++) m[0] = (a[i] < m[0]) ? a[i] : m[0];
+    for (int k = 1; k < K; k++) m[0] = (m[k] < m[0]) ? m[k] : m[0];
+    return m[0];
+}
+
+static RT R_FN(max)(const RT *a, size_t n)
+{
+    RT m[K];
+    size_t i = 0;
+
+    if (n == 0) return 0;
+    for (int k = 0; k < K; k++) m[k] = a[0];
+    for (; i + K <= n; i += K)
+        for (int k = 0; k < K; k++) m[k] = (a[i + k] > m[k]) ? a[i + k] : m[k];
+    for (; i < n; i++) m[0] = (a[i] > m[0]) ? a[i] : m[0];
+    for (int k = 1; k < K; k++) m[0] = (m[k] > m[0]) ? m[k] : m[0];
+    return m[0];
+}
+
+#else
+
+/* ---------------------------------------------------------------- */
+/* Vector path: K vector accumulators of W lanes                     */
+/* ---------------------------------------------------------------- */
+
+#define V   REDUCE_CAT(vec, RS, RI)
+#define MV  REDUCE_CAT(mask, RS, RI)
+#define W   ((size_t)(RVB / sizeof(RT)))
+/* Unaligned load (compiles to one vmovdqu/vmovupd) */
+#define LOAD(dst, p) memcpy(&(dst), (p), sizeof(V))
+/* Lane-wise select: lt ? x : y */
+#define SELECT(lt, x, y) ((V)(((lt) & (MV)(x)) | (~(lt) & (MV)(y))))
+
+typedef RT V  __attribute__((vector_size(RVB)));
+typedef RM MV __attribute__((vector_size(RVB)));
+
+R_SUM_BODY(R_FN(sum), RT, V, W, __attribute__((target(RTARGET))), K, K)
+
+#define R_LADDER_DEFINE(unused, U, A)                                   \
+    R_SUM_BODY(R_LADDER(U, A), double, V, W, __attribute__((target(RTARGET))), U, A)
+REDUCE_SUM_SHAPES(R_LADDER_DEFINE, ~)
+#undef R_LADDER_DEFINE
+
+__attribute__((target(RTARGET)))
+static RT R_FN(sumsq)(const RT *a, size_t n)
+{
+    V s[K] = {{0}};
+    size_t i = 0;
+
+    for (; i + K * W <= n; i += K * W) {
+#pragma GCC unroll 8
+        for (int k = 0; k < K; k++) {
+            V x;
+            LOAD(x, a + i + k * W);
+            s[k] += x * x;
+        }
+    }
+    for (int k = 1; k < K; k++) s[0] += s[k];
+
+    RT r = 0;
+    for (size_t l = 0; l < W; l++) r += s[0][l];
+    for (; i < n; i++) r += a[i] * a[i];
+    return r;
+}
+
+__attribute__((target(RTARGET)))
+static RT R_FN(dot)(const RT *a, const RT *b, size_t n)
+{
+    V s[K] = {{0}};
+    size_t i = 0;
+
+    for (; i + K * W <= n; i += K * W) {
+#pragma GCC unroll 8
+        for (int k = 0; k < K; k++) {
+            V x, y;
+            LOAD(x, a + i + k * W);
+            LOAD(y, b + i + k * W);
+            s[k] += x * y;
+        }
+    }
+    for (int k = 1; k < K; k++) s[0] += s[k];
+
+    RT r = 0;
+    for (size_t l = 0; l < W; l++) r += s[0][l];
+    for (; i < n; i++) r += a[i] * b[i];
+    return r;
+}
+
+__attribute__((target(RTARGET)))
+static RT R_FN(min)(const RT *a, size_t n)
+{
+    V m[K];
+    size_t i;
+
+    if (n < K * W) return R_SCALAR(min)(a, n);
+    for (int k = 0; k < K; k++) LOAD(m[k], a + k * W);
+
+    for (i = K * W; i + K * W <= n; i += K * W) {
+#pragma GCC unroll 8
+        for (int k = 0; k < K; k++) {
+            V x;
+            LOAD(x, a + i + k * W);
+            MV lt = (MV)(x < m[k]);
+            m[k] = SELECT(lt, x, m[k]);
+        }
+    }
+    for (int k = 1; k < K; k++) {
+        MV lt = (MV)(m[k] < m[0]);
+        m[0] = SELECT(lt, m[k], m[0]);
+    }
+
+    RT r = m[0][0];
+    for (size_t l = 1; l < W; l++) r = (m[0][l] < r) ? m[0][l] : r;
+    for (; i < n; i++) r = (a[i] < r) ? a[i] : r;
+    return r;
+}
+
+__attribute__((target(RTARGET)))
+static RT R_FN(max)(const RT *a, size_t n)
+{
+    V m[K];
+    size_t i;
+
+    if (n < K * W) return R_SCALAR(max)(a, n);
+    for (int k = 0; k < K; k++) LOAD(m[k], a + k * W);
+
+    for (i = K * W; i + K * W <= n; i += K * W) {
+#pragma GCC unroll 8
+        for (int k = 0; k < K; k++) {
+            V x;
+            LOAD(x, a + i + k * W);
+            MV gt = (MV)(x > m[k]);
+            m[k] = SELECT(gt, x, m[k]);
+        }
+    }
+    for (int k = 1; k < K; k++) {
+        MV gt = (MV)(m[k] > m[0]);
+        m[0] = SELECT(gt, m[k], m[0]);
+    }
+
+    RT r = m[0][0];
+    for (size_t l = 1; l < W; l++) r = (m[0][l] > r) ? m[0][l] : r;
+    for (; i < n; i++) r = (a[i] > r) ? a[i] : r;
+    return r;
+}
+
+#undef V
+#undef MV
+#undef W
+#undef LOAD
+#undef SELECT
+
+#endif /* RVB == 0 */
+
+#undef R_FN
+#undef R_SCALAR
+#undef R_LADDER
+#undef R_SUM_BODY
+#undef K
+
+#undef RT
+#undef RM
+#undef RS
+#undef RI
+#undef RVB
+#undef RTARGET
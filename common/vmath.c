@@ -0,0 +1,112 @@
+/* ================================================================
+ * Vectorizable sin / cos / sqrt: batch functions (see vmath.h)
+ * ================================================================ */
+
+#include <math.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "simd_reduce.h"
+#include "vmath.h"
+
+#define AVX2_TARGET   "avx2,fma"
+#define AVX512_TARGET "avx512f,avx512dq"
+
+/* One batch loop per (function, ISA); the element kernels inline
+ * into the target-specific loop and vectorize at its width */
+#define VM_BATCH(name, isa, ATTR, EXPR)                                   \
+    ATTR static void name##_##isa(double *y, const double *x, size_t n)  \
+    {                                                                     \
+        _Pragma("omp simd")                                               \
+        for (size_t i = 0; i < n; i++) y[i] = EXPR(x[i]);                 \
+    }
+
+#define VM_SINCOS(isa, ATTR)                                                         \
+    ATTR static void sincos_##isa(double *s, double *c, const double *x, size_t n)  \
+    {                                                                                \
+        _Pragma("omp simd")                                                          \
+        for (size_t i = 0; i < n; i++) {                                             \
+            double xi = x[i];                                                        \
+            s[i] = vm_sin1(xi);                                                      \
+            c[i] = vm_cos1(xi);                                                      \
+        }                                                                            \
+    }
+
+/* Batch sqrt: here the instruction can be used directly (correctly
+ * rounded); vm_sqrt1 exists for loops the compiler must vectorize */
+#define VM_SQRT(isa, ATTR, W, LOAD, SQRT, STORE)                          \
+    ATTR static void sqrt_##isa(double *y, const double *x, size_t n)    \
+    {                                                                     \
+        size_t i = 0;                                                     \
+        for (; i + W <= n; i += W) STORE(y + i, SQRT(LOAD(x + i)));       \
+        for (; i < n; i++) y[i] = sqrt(x[i]);                             \
+    }
+
+#define VM_ALL(isa, ATTR)                    \
+    VM_BATCH(sin, isa, ATTR, vm_sin1)        \
+    VM_BATCH(cos, isa, ATTR, vm_cos1)        \
+    VM_SINCOS(isa, ATTR)
+
+VM_ALL(sse2, )
+VM_ALL(avx2, __attribute__((target(AVX2_TARGET))))
+VM_ALL(avx512, __attribute__((target(AVX512_TARGET))))
+
+VM_SQRT(sse2, , 2, _mm_loadu_pd, _mm_sqrt_pd, _mm_storeu_pd)
+VM_SQRT(avx2, __attribute__((target(AVX2_TARGET))), 4, _mm256_loadu_pd, _mm256_sqrt_pd, _mm256_storeu_pd)
+VM_SQRT(avx512, __attribute__((target(AVX512_TARGET))), 8, _mm512_loadu_pd, _mm512_sqrt_pd, _mm512_storeu_pd)
+
+#define VM_DISPATCH(fn, ...)                                              \
+    switch (reduce_isa()) {                                               \
+    case REDUCE_ISA_AVX512: fn##_avx512(__VA_ARGS__); break;              \
+    case REDUCE_ISA_AVX2:   fn##_avx2(__VA_ARGS__);   break;              \
+    default:                fn##_sse2(__VA_ARGS__);   break;              \
+    }
+
+/* Arguments the reduction cannot take (and inf / nan) go to libm */
+static void trig_fixup(double *y, const double *x, size_t n, double (*f)(double))
+{
+    for (size_t i = 0; i < n; i++)
+        if (!(fabs(x[i]) <= VM_TRIG_MAX)) y[i] = f(x[i]);
+}
+
+/* Blocks of x are copied first, so y may be x itself */
+#define VM_BLOCK 512
+
+void vm_sin(double *y, const double *x, size_t n)
+{
+    double xb[VM_BLOCK];
+    for (size_t i = 0; i < n; i += VM_BLOCK) {
+        size_t len = (n - i < VM_BLOCK) ? n - i : VM_BLOCK;
+        memcpy(xb, x + i, len * sizeof(double));
+        VM_DISPATCH(sin, y + i, xb, len);
+        trig_fixup(y + i, xb, len, sin);
+    }
+}
+
+void vm_cos(double *y, const double *x, size_t n)
+{
+    double xb[VM_BLOCK];
+    for (size_t i = 0; i < n; i += VM_BLOCK) {
+        size_t len = (n - i < VM_BLOCK) ? n - i : VM_BLOCK;
+        memcpy(xb, x + i, len * sizeof(double));
+        VM_DISPATCH(cos, y + i, xb, len);
+        trig_fixup(y + i, xb, len, cos);
+    }
+}
+
+void vm_sqrt(double *y, const double *x, size_t n)
+{
+    VM_DISPATCH(sqrt, y, x, n);
+}
+
+void vm_sincos(double *s, double *c, const double *x, size_t n)
+{
+    double xb[VM_BLOCK];
+    for (size_t i = 0; i < n; i += VM_BLOCK) {
+        size_t len = (n - i < VM_BLOCK) ? n - i : VM_BLOCK;
+        memcpy(xb, x + i, len * sizeof(double));
+        VM_DISPATCH(sincos, s + i, c + i, xb, len);
+        trig_fixup(s + i, xb, len, sin);
+        trig_fixup(c + i, xb, len, cos);
+    }
+}
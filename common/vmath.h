@@ -0,0 +1,144 @@
+/* ================================================================
+ * Vectorizable sin / cos / sqrt (double precision)
+ * ================================================================
+ *
+ * libm's sin, cos and sqrt are opaque calls (and set errno), so a
+ * loop around them runs one element at a time.  The kernels below
+ * are plain branch-free arithmetic that the compiler turns into SIMD
+ * code, in two forms:
+ *
+ *   element functions  vm_sin1 / vm_cos1 / vm_sqrt1  (static inline,
+ *                      "omp declare simd"), for use inside your own
+ *                      loops:
+ *
+ *                        #pragma omp simd reduction(+:x)
+ *                        for (i = 0; i < n; i++)
+ *                            x += vm_sqrt1(i * 0.5) * vm_cos1(i * 0.001);
+ *
+ *   batch functions    vm_sin / vm_cos / vm_sincos / vm_sqrt over
+ *                      arrays, built for SSE2, AVX2+FMA and AVX-512
+ *                      and dispatched on the CPU (reduce_isa(), so
+ *                      REDUCE_ISA=scalar|avx2|avx512 also applies).
+ *
+ * sin / cos: reduction by pi/2 in three 33-bit pieces and a tail
+ * (products exact for |x| <= VM_TRIG_MAX), then the fdlibm / musl
+ * minimax polynomials of degree 13 (sin) and 14 (cos) on
+ * [-pi/4, pi/4] and a quadrant select.  vm_sqrt1: bit-trick
+ * reciprocal square root estimate, four Newton steps and one final
+ * correction of x * rsqrt(x) (a call to sqrt() sets errno, which
+ * keeps the loop scalar); vm_sqrt uses the sqrt instruction itself.
+ *
+ * Error against correctly rounded results (max over 4 * 10^6 random
+ * arguments per range, every ISA path):
+ *
+ *   sin, cos    0.8 ULP for |x| <= pi/4,  1.5 ULP for |x| <= 100,
+ *               2.5 ULP for |x| <= VM_TRIG_MAX (batch functions: libm
+ *               beyond VM_TRIG_MAX and for inf / NaN)
+ *   vm_sqrt1    0.5 ULP with FMA (-mavx2 -mfma and up), 0.8 ULP
+ *               without; subnormals included, NaN for x < 0
+ *   vm_sqrt     correctly rounded (hardware sqrt)
+ *
+ * The element functions do not reduce |x| > VM_TRIG_MAX accurately
+ * (the result is still in [-1, 1]); use the batch functions or libm
+ * for such arguments.  With GCC, loops over vm_sin1 / vm_cos1
+ * vectorize at any -m level, vm_sqrt1 from AVX2 up.
+ *
+ * COMPILATION: add  -fopenmp (or -fopenmp-simd) -I../common
+ * ../common/vmath.c ../common/simd_reduce.c -lm  to the compile line.
+ * ================================================================ */
+
+#ifndef VMATH_H
+#define VMATH_H
+
+#include <stddef.h>
+
+/* 2^20 * pi/2: q * VM_PIO2_1 stays exact below this */
+#define VM_TRIG_MAX 1647099.0
+
+#define VM_2_PI   6.36619772367581382433e-01   /* 2/pi                 */
+#define VM_PIO2_1 1.57079632673412561417e+00   /* first 33 bits of pi/2 */
+#define VM_PIO2_2 6.07710050630396597660e-11   /* next 33 bits          */
+#define VM_PIO2_3 2.02226624871116645580e-21   /* next 33 bits          */
+#define VM_PIO2_T 8.47842766036889956997e-32   /* pi/2 - the three above */
+
+typedef union {
+    double    d;
+    long long i;
+} vm_bits_t;
+
+/* sin(x) for shift 0, cos(x) = sin(x + pi/2) for shift 1 */
+#pragma omp declare simd notinbranch
+static inline double vm_trig1(double x, long long shift)
+{
+    const double magic = 0x1.8p52;    /* adding it rounds to an integer */
+    vm_bits_t t = {x * VM_2_PI + magic};
+    double q = t.d - magic;
+    long long n = (t.i + shift) & 3;  /* quadrant, from the low bits   */
+
+    double r = (((x - q * VM_PIO2_1) - q * VM_PIO2_2) - q * VM_PIO2_3) - q * VM_PIO2_T;
+    double z = r * r, w = z * z;
+
+    /* sin on [-pi/4, pi/4] */
+    double ps = 8.33333333332248946124e-03 + z * (-1.98412698298579493134e-04 + z * 2.75573137070700676789e-06)
+              + z * w * (-2.50507602534068634195e-08 + z * 1.58969099521155010221e-10);
+    double s = r + z * r * (-1.66666666666666324348e-01 + z * ps);
+
+    /* cos on [-pi/4, pi/4], 1 - z/2 split to keep the low bits */
+    double pc = z * (4.16666666666666019037e-02 + z * (-1.38888888888741095749e-03 + z * 2.48015872894767294178e-05))
+              + w * w * (-2.75573143513906633035e-07 + z * (2.08757232129817482790e-09 + z * -1.13596475577881948265e-11));
+    double hz = 0.5 * z, c1 = 1.0 - hz;
+    double c = c1 + (((1.0 - c1) - hz) + z * pc);
+
+    /* Quadrant select with bit masks: no 64-bit compares for SSE2 */
+    vm_bits_t vs = {s}, vc = {c}, v;
+    long long odd = -(n & 1);
+    v.i = ((vc.i & odd) | (vs.i & ~odd)) ^ ((n & 2) << 62);
+    return v.d;
+}
+
+#pragma omp declare simd notinbranch
+static inline double vm_sin1(double x) { return vm_trig1(x, 0); }
+
+#pragma omp declare simd notinbranch
+static inline double vm_cos1(double x) { return vm_trig1(x, 1); }
+
+#pragma omp declare simd notinbranch
+static inline double vm_sqrt1(double x)
+{
+    /* Special cases are merged with bit masks: a conditional FP op
+     * would keep the loop from vectorizing (-ftrapping-math) */
+    vm_bits_t bx = {x}, nan = {__builtin_nan("")};
+    long long tiny = -(long long)(x < 0x1p-1000);
+    long long keep = -(long long)((x == 0.0) | (x == __builtin_inf()));
+    long long neg = -(long long)(x < 0.0);
+
+    /* Subnormals: scale by 2^108, the result by 2^-54 */
+    vm_bits_t b = {x * 0x1p108};
+    b.i = (b.i & tiny) | (bx.i & ~tiny);
+    double xs = b.d;
+
+    b.i = 0x5FE6EB50C7B537A9LL - (long long)((unsigned long long)b.i >> 1);
+    double r = b.d;                    /* ~ 1/sqrt(xs), 5 bits         */
+    double hx = 0.5 * xs;
+    r = r * (1.5 - hx * r * r);
+    r = r * (1.5 - hx * r * r);
+    r = r * (1.5 - hx * r * r);
+    r = r * (1.5 - hx * r * r);
+
+    double y = xs * r;                 /* sqrt(xs), then one correction */
+    y = y + 0.5 * r * (xs - y * y);
+
+    vm_bits_t by = {y}, down = {y * 0x1p-54};
+    by.i = (down.i & tiny) | (by.i & ~tiny);
+    by.i = (bx.i & keep) | (by.i & ~keep);     /* +-0, +inf        */
+    by.i = (nan.i & neg) | (by.i & ~neg);      /* x < 0, -inf      */
+    return by.d;
+}
+
+/* y[i] = f(x[i]); y may be x itself, s and c must not overlap x */
+void vm_sin(double *y, const double *x, size_t n);
+void vm_cos(double *y, const double *x, size_t n);
+void vm_sqrt(double *y, const double *x, size_t n);
+void vm_sincos(double *s, double *c, const double *x, size_t n);
+
+#endif /* VMATH_H */
@@ -0,0 +1,359 @@
+/* ================================================================
+ * Work-stealing runtime (see wsteal.h)
+ * ================================================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "wsteal.h"
+
+/* Failed steals before an idle worker yields the CPU */
+#define WS_SPIN 64
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+typedef struct {
+    long         grain;
+    ws_reduce_fn fn;
+    void        *arg;
+} ws_body_t;
+
+/* A pending upper half; lives in the frame that split it, which
+ * does not return before the task is done */
+typedef struct {
+    long             lo, hi;
+    const ws_body_t *body;
+    double           result;
+    atomic_int       done;
+} ws_task_t;
+
+/*
+ * Chase-Lev deque, fixed size (Le, Pop, Cohen, Zappa Nardelli, "Correct
+ * and efficient work-stealing for weak memory models", PPoPP 2013).
+ * The owner pushes and pops at bottom, thieves take from top.
+ */
+typedef struct {
+    _Alignas(64) atomic_long top;
+    _Alignas(64) atomic_long bottom;
+    _Alignas(64) _Atomic(ws_task_t *) buf[WS_DEQUE_SIZE];
+} ws_deque_t;
+
+typedef struct {
+    ws_deque_t  q;
+    pthread_t   thread;
+    int         id;
+    unsigned    rng;
+    atomic_long tasks, steals, failed;   /* written by the owner only */
+} ws_worker_t;
+
+_Static_assert((WS_DEQUE_SIZE & (WS_DEQUE_SIZE - 1)) == 0, "WS_DEQUE_SIZE must be a power of 2");
+
+static ws_worker_t    *g_workers;
+static int             g_n;
+static atomic_int      g_active, g_stop;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  g_wake = PTHREAD_COND_INITIALIZER;
+
+static _Thread_local ws_worker_t *tls_self;
+
+static inline void bump(atomic_long *c)
+{
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+}
+
+/* ----------------------------------------------------------------
+ * Deque operations
+ * ---------------------------------------------------------------- */
+
+static int dq_push(ws_deque_t *q, ws_task_t *t)
+{
+    long b = atomic_load_explicit(&q->bottom, memory_order_relaxed);
+    long top = atomic_load_explicit(&q->top, memory_order_acquire);
+    if (b - top >= WS_DEQUE_SIZE) return -1;
+
+    atomic_store_explicit(&q->buf[b & (WS_DEQUE_SIZE - 1)], t, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+    return 0;
+}
+
+static ws_task_t *dq_pop(ws_deque_t *q)
+{
+    long b = atomic_load_explicit(&q->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&q->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long top = atomic_load_explicit(&q->top, memory_order_relaxed);
+
+    ws_task_t *t = NULL;
+    if (top <= b) {
+        t = atomic_load_explicit(&q->buf[b & (WS_DEQUE_SIZE - 1)], memory_order_relaxed);
+        if (top == b) {
+            /* Last entry: race the thieves for it */
+            if (!atomic_compare_exchange_strong_explicit(&q->top, &top, top + 1,
+                                                         memory_order_seq_cst,
+                                                         memory_order_relaxed))
+                t = NULL;
+            atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+        }
+    } else {
+        atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+    }
+    return t;
+}
+
+static ws_task_t *dq_steal(ws_deque_t *q)
+{
+    long top = atomic_load_explicit(&q->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&q->bottom, memory_order_acquire);
+    if (top >= b) return NULL;
+
+    ws_task_t *t = atomic_load_explicit(&q->buf[top & (WS_DEQUE_SIZE - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&q->top, &top, top + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed))
+        return NULL;
+    return t;
+}
+
+/* One attempt on a random victim */
+static ws_task_t *steal_one(ws_worker_t *w)
+{
+    if (g_n < 2) return NULL;
+    w->rng ^= w->rng << 13;
+    w->rng ^= w->rng >> 17;
+    w->rng ^= w->rng << 5;
+    int v = (int)(w->rng % (unsigned)(g_n - 1));
+    if (v >= w->id) v++;
+
+    ws_task_t *t = dq_steal(&g_workers[v].q);
+    bump(t ? &w->steals : &w->failed);
+    return t;
+}
+
+/* ----------------------------------------------------------------
+ * Splitting and joining
+ * ---------------------------------------------------------------- */
+
+static void run_task(ws_worker_t *w, ws_task_t *t);
+
+static double range(ws_worker_t *w, long lo, long hi, const ws_body_t *body)
+{
+    if (hi - lo <= body->grain) {
+        bump(&w->tasks);
+        return body->fn(lo, hi, body->arg);
+    }
+
+    long mid = lo + (hi - lo) / 2;
+    ws_task_t child = {mid, hi, body, 0.0, 0};
+    if (dq_push(&w->q, &child) != 0)
+        return range(w, lo, mid, body) + range(w, mid, hi, body);
+
+    double left = range(w, lo, mid, body);
+
+    /* Everything pushed after child has been joined: the pop gives
+     * child back, or nothing when a thief took it */
+    if (dq_pop(&w->q) == &child)
+        return left + range(w, mid, hi, body);
+
+    while (!atomic_load_explicit(&child.done, memory_order_acquire)) {
+        ws_task_t *t = steal_one(w);
+        if (t) run_task(w, t);
+        else   cpu_relax();
+    }
+    return left + child.result;
+}
+
+static void run_task(ws_worker_t *w, ws_task_t *t)
+{
+    t->result = range(w, t->lo, t->hi, t->body);
+    atomic_store_explicit(&t->done, 1, memory_order_release);
+}
+
+static void *worker_main(void *p)
+{
+    ws_worker_t *w = p;
+    int idle = 0;
+
+    tls_self = w;
+    for (;;) {
+        if (!atomic_load_explicit(&g_active, memory_order_acquire)) {
+            pthread_mutex_lock(&g_lock);
+            while (!atomic_load(&g_active) && !atomic_load(&g_stop))
+                pthread_cond_wait(&g_wake, &g_lock);
+            pthread_mutex_unlock(&g_lock);
+            if (atomic_load(&g_stop)) return NULL;
+        }
+
+        ws_task_t *t = steal_one(w);
+        if (t) {
+            run_task(w, t);
+            idle = 0;
+        } else if (++idle >= WS_SPIN) {
+            sched_yield();
+            idle = 0;
+        } else {
+            cpu_relax();
+        }
+    }
+}
+
+/* ----------------------------------------------------------------
+ * Public API
+ * ---------------------------------------------------------------- */
+
+static int default_threads(void)
+{
+    const char *env = getenv("WS_THREADS");
+    if (!env) env = getenv("OMP_NUM_THREADS");    /* "4" or "4,2": first level */
+    int n = env ? atoi(env) : 0;
+    if (n <= 0) n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? n : 1;
+}
+
+int ws_init(int nthreads)
+{
+    if (g_workers) return 0;
+    if (nthreads <= 0) nthreads = default_threads();
+    if (nthreads > WS_MAX_THREADS) nthreads = WS_MAX_THREADS;
+
+    g_workers = aligned_alloc(64, sizeof(ws_worker_t) * nthreads);
+    if (!g_workers) return -1;
+    for (int i = 0; i < nthreads; i++) {
+        ws_worker_t *w = &g_workers[i];
+        atomic_init(&w->q.top, 0);
+        atomic_init(&w->q.bottom, 0);
+        w->id = i;
+        w->rng = 2463534242u + 977u * (unsigned)i;
+        atomic_init(&w->tasks, 0);
+        atomic_init(&w->steals, 0);
+        atomic_init(&w->failed, 0);
+    }
+    g_n = nthreads;
+    atomic_store(&g_stop, 0);
+
+    /* Worker 0 is whichever thread makes the top-level call */
+    for (int i = 1; i < nthreads; i++) {
+        if (pthread_create(&g_workers[i].thread, NULL, worker_main, &g_workers[i]) != 0) {
+            fprintf(stderr, "ws_init: could only start %d of %d threads\n", i, nthreads);
+            g_n = i;
+            break;
+        }
+    }
+    return 0;
+}
+
+void ws_finalize(void)
+{
+    if (!g_workers) return;
+    pthread_mutex_lock(&g_lock);
+    atomic_store(&g_stop, 1);
+    pthread_cond_broadcast(&g_wake);
+    pthread_mutex_unlock(&g_lock);
+    for (int i = 1; i < g_n; i++) pthread_join(g_workers[i].thread, NULL);
+
+    free(g_workers);
+    g_workers = NULL;
+    g_n = 0;
+}
+
+int ws_nthreads(void)
+{
+    return g_workers ? g_n : default_threads();
+}
+
+int ws_worker_id(void)
+{
+    return tls_self ? tls_self->id : -1;
+}
+
+static double run_root(long lo, long hi, const ws_body_t *body)
+{
+    if (tls_self) return range(tls_self, lo, hi, body);   /* nested */
+
+    if (!g_workers && ws_init(0) != 0) return body->fn(lo, hi, body->arg);
+
+    tls_self = &g_workers[0];
+    pthread_mutex_lock(&g_lock);
+    atomic_store(&g_active, 1);
+    pthread_cond_broadcast(&g_wake);
+    pthread_mutex_unlock(&g_lock);
+
+    double r = range(tls_self, lo, hi, body);
+
+    atomic_store(&g_active, 0);
+    tls_self = NULL;
+    return r;
+}
+
+double ws_parallel_reduce(long lo, long hi, long grain, ws_reduce_fn fn, void *arg)
+{
+    if (hi <= lo) return 0.0;
+    if (grain <= 0) grain = (hi - lo) / WS_AUTO_PIECES;
+    if (grain < 1) grain = 1;
+
+    ws_body_t body = {grain, fn, arg};
+    return run_root(lo, hi, &body);
+}
+
+typedef struct {
+    ws_for_fn fn;
+    void     *arg;
+} for_arg_t;
+
+static double for_body(long lo, long hi, void *p)
+{
+    for_arg_t *f = p;
+    f->fn(lo, hi, f->arg);
+    return 0.0;
+}
+
+void ws_parallel_for(long lo, long hi, long grain, ws_for_fn fn, void *arg)
+{
+    for_arg_t f = {fn, arg};
+    ws_parallel_reduce(lo, hi, grain, for_body, &f);
+}
+
+/* Jobs are the leaves of a range over job indices; each one splits
+ * its own range as a nested call */
+static double job_body(long lo, long hi, void *p)
+{
+    ws_job_t *jobs = p;
+    for (long j = lo; j < hi; j++)
+        jobs[j].result = ws_parallel_reduce(jobs[j].lo, jobs[j].hi, jobs[j].grain,
+                                            jobs[j].fn, jobs[j].arg);
+    return 0.0;
+}
+
+void ws_run_jobs(ws_job_t *jobs, int njobs)
+{
+    ws_parallel_reduce(0, njobs, 1, job_body, jobs);
+}
+
+ws_stats_t ws_stats(void)
+{
+    ws_stats_t s = {0, 0, 0};
+    for (int i = 0; i < g_n; i++) {
+        s.tasks  += atomic_load_explicit(&g_workers[i].tasks, memory_order_relaxed);
+        s.steals += atomic_load_explicit(&g_workers[i].steals, memory_order_relaxed);
+        s.failed += atomic_load_explicit(&g_workers[i].failed, memory_order_relaxed);
+    }
+    return s;
+}
+
+void ws_stats_reset(void)
+{
+    for (int i = 0; i < g_n; i++) {
+        atomic_store_explicit(&g_workers[i].tasks, 0, memory_order_relaxed);
+        atomic_store_explicit(&g_workers[i].steals, 0, memory_order_relaxed);
+        atomic_store_explicit(&g_workers[i].failed, 0, memory_order_relaxed);
+    }
+}
@@ -0,0 +1,89 @@
+/* ================================================================
+ * Work-stealing runtime: Chase-Lev deques, splittable ranges
+ * ================================================================
+ *
+ * One deque per worker thread.  A range [lo, hi) larger than its
+ * grain is split at the midpoint: the upper half is pushed on the
+ * worker's own deque, the lower half is run at once (work first).
+ * Idle workers steal the oldest entry of a random victim's deque,
+ * which is always the largest piece still unclaimed, so a few steals
+ * spread a big range over every thread and later splits stay local.
+ *
+ *   double f(long lo, long hi, void *arg);      partial result
+ *
+ *   ws_parallel_for(0, n, 1000, body, arg);     body over pieces
+ *   s = ws_parallel_reduce(0, n, 1000, f, arg); sum of f over pieces
+ *
+ *   ws_job_t jobs[3] = {{0, N, 1000, light, NULL},
+ *                       {0, 5 * N, 1000, moderate, NULL},
+ *                       {0, 20 * N, 1000, heavy, NULL}};
+ *   ws_run_jobs(jobs, 3);                       jobs[j].result
+ *
+ * ws_run_jobs() runs unrelated ranges of different cost together:
+ * each job splits as it goes, so threads that finish the cheap ones
+ * steal pieces of the expensive one, without any hand balancing.
+ *
+ * A waiting parent (its upper half was stolen) runs other stolen
+ * work until the thief is done.  Calls from inside a body run nested
+ * on the same workers.  Partial results are combined along the fixed
+ * midpoint tree, so for a given grain the sum does not depend on the
+ * thread count or on who stole what.
+ *
+ * Threads: ws_init(n), or at the first call n = WS_THREADS, else
+ * OMP_NUM_THREADS, else the online CPUs.  The calling thread is
+ * worker 0; the others sleep between calls.  Top-level calls must
+ * come from one thread at a time.
+ *
+ * COMPILATION: add  -pthread -I../common ../common/wsteal.c  to the
+ * compile line.
+ * ================================================================ */
+
+#ifndef WSTEAL_H
+#define WSTEAL_H
+
+/* Entries per deque: splits pending on one worker at a time (depth
+ * of the split tree, per nesting level); a full deque runs inline */
+#ifndef WS_DEQUE_SIZE
+#define WS_DEQUE_SIZE 1024
+#endif
+
+#define WS_MAX_THREADS 256
+
+/* Pieces per range when the grain is 0 (fixed, so that sums do not
+ * depend on the thread count) */
+#ifndef WS_AUTO_PIECES
+#define WS_AUTO_PIECES 256
+#endif
+
+typedef double (*ws_reduce_fn)(long lo, long hi, void *arg);
+typedef void   (*ws_for_fn)(long lo, long hi, void *arg);
+
+typedef struct {
+    long         lo, hi, grain;
+    ws_reduce_fn fn;
+    void        *arg;
+    double       result;     /* set by ws_run_jobs() */
+} ws_job_t;
+
+typedef struct {
+    long tasks;              /* pieces run           */
+    long steals;             /* successful steals    */
+    long failed;             /* empty / lost steals  */
+} ws_stats_t;
+
+/* Starts n workers (n <= 0: default); 0 or -1 */
+int  ws_init(int nthreads);
+void ws_finalize(void);
+int  ws_nthreads(void);
+/* Worker index of the calling thread inside a call, else -1 */
+int  ws_worker_id(void);
+
+void   ws_parallel_for(long lo, long hi, long grain, ws_for_fn fn, void *arg);
+double ws_parallel_reduce(long lo, long hi, long grain, ws_reduce_fn fn, void *arg);
+void   ws_run_jobs(ws_job_t *jobs, int njobs);
+
+/* Counters summed over workers since the last reset */
+ws_stats_t ws_stats(void);
+void       ws_stats_reset(void);
+
+#endif /* WSTEAL_H */